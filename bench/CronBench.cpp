@@ -0,0 +1,382 @@
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <libcron/Cron.h>
+#include <libcron/ShardedCron.h>
+
+using namespace std::chrono;
+
+namespace
+{
+    // A clock that only moves when told to, so each tick sees the same amount of due tasks.
+    class BenchClock
+            : public libcron::ICronClock
+    {
+        public:
+            system_clock::time_point now() const override
+            {
+                return current_time;
+            }
+
+            seconds utc_offset(system_clock::time_point) const override
+            {
+                return seconds{ 0 };
+            }
+
+            void add(system_clock::duration time)
+            {
+                current_time += time;
+            }
+
+        private:
+            system_clock::time_point current_time = system_clock::from_time_t(1577836800); // 2020-01-01
+    };
+
+    template<template<typename> class QueueType>
+    using BenchCron = libcron::Cron<BenchClock, libcron::NullLock, QueueType>;
+
+    // Adds 'count' tasks, every 'due_every' of them expiring each second, the others once a year.
+    template<typename CronType>
+    void add_tasks(CronType& cron, int64_t count, int64_t due_every)
+    {
+        std::vector<std::pair<std::string, std::string>> schedules;
+        schedules.reserve(static_cast<size_t>(count));
+
+        for (int64_t i = 0; i < count; ++i)
+        {
+            bool due = due_every > 0 && i % due_every == 0;
+            schedules.emplace_back("Task-" + std::to_string(i), due ? "* * * * * ?" : "0 0 0 1 1 ?");
+        }
+
+        cron.add_schedule(schedules, [](auto&) {});
+    }
+
+    // Arguments are the number of tasks and the number of tasks for each due one, zero for none.
+    void tick_arguments(benchmark::internal::Benchmark* b)
+    {
+        for (int64_t count : { 1000, 10000, 100000, 1000000 })
+        {
+            for (int64_t due_every : { 0, 100, 1 })
+            {
+                b->Args({ count, due_every });
+            }
+        }
+
+        b->ArgNames({ "tasks", "due_every" })->Unit(benchmark::kMicrosecond);
+    }
+
+    template<template<typename> class QueueType>
+    void tick(benchmark::State& state)
+    {
+        BenchCron<QueueType> cron;
+        add_tasks(cron, state.range(0), state.range(1));
+        cron.tick();
+
+        for (auto _ : state)
+        {
+            cron.get_clock().add(seconds{ 1 });
+            benchmark::DoNotOptimize(cron.tick());
+        }
+
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    }
+
+    // Adding and removing a task while 'count' other tasks are scheduled.
+    template<template<typename> class QueueType>
+    void churn(benchmark::State& state)
+    {
+        BenchCron<QueueType> cron;
+        add_tasks(cron, state.range(0), 100);
+
+        const std::string name = "Churn";
+        size_t i = 0;
+
+        for (auto _ : state)
+        {
+            cron.add_schedule(name, ++i % 2 == 0 ? "* * * * * ?" : "0 */5 * * * ?", [](auto&) {});
+            cron.remove_schedule(name);
+        }
+
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    }
+}
+
+static void Cron_tick_vector(benchmark::State& state)
+{
+    tick<libcron::TaskQueue>(state);
+}
+
+BENCHMARK(Cron_tick_vector)->Apply(tick_arguments);
+
+static void Cron_tick_heap(benchmark::State& state)
+{
+    tick<libcron::HeapTaskQueue>(state);
+}
+
+BENCHMARK(Cron_tick_heap)->Apply(tick_arguments);
+
+static void Cron_tick_grouped(benchmark::State& state)
+{
+    tick<libcron::GroupedTaskQueue>(state);
+}
+
+BENCHMARK(Cron_tick_grouped)->Apply(tick_arguments);
+
+static void Cron_churn_vector(benchmark::State& state)
+{
+    churn<libcron::TaskQueue>(state);
+}
+
+BENCHMARK(Cron_churn_vector)->Arg(1000)->Arg(100000)->ArgName("tasks");
+
+static void Cron_churn_heap(benchmark::State& state)
+{
+    churn<libcron::HeapTaskQueue>(state);
+}
+
+BENCHMARK(Cron_churn_heap)->Arg(1000)->Arg(100000)->ArgName("tasks");
+
+static void Cron_churn_grouped(benchmark::State& state)
+{
+    churn<libcron::GroupedTaskQueue>(state);
+}
+
+BENCHMARK(Cron_churn_grouped)->Arg(1000)->Arg(100000)->ArgName("tasks");
+
+// Starting from a snapshot versus adding the tasks from their expressions.
+static void Cron_restore_snapshot(benchmark::State& state)
+{
+    BenchCron<libcron::HeapTaskQueue> cron;
+    add_tasks(cron, state.range(0), 100);
+
+    std::vector<uint8_t> snapshot;
+    cron.save_snapshot(snapshot);
+
+    for (auto _ : state)
+    {
+        BenchCron<libcron::HeapTaskQueue> restored;
+        restored.restore_snapshot(snapshot.data(), snapshot.size(), [](std::string_view)
+        {
+            return [](auto&) {};
+        });
+        benchmark::DoNotOptimize(restored.count());
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+BENCHMARK(Cron_restore_snapshot)->Arg(500000)->ArgName("tasks")->Unit(benchmark::kMillisecond);
+
+static void Cron_add_schedules(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        BenchCron<libcron::HeapTaskQueue> cron;
+        add_tasks(cron, state.range(0), 100);
+        benchmark::DoNotOptimize(cron.count());
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+BENCHMARK(Cron_add_schedules)->Arg(500000)->ArgName("tasks")->Unit(benchmark::kMillisecond);
+
+// As above, with the tasks in an arena that is released as a whole.
+static void Cron_add_schedules_arena(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        std::pmr::monotonic_buffer_resource arena;
+        BenchCron<libcron::HeapTaskQueue> cron{ &arena };
+        add_tasks(cron, state.range(0), 100);
+        benchmark::DoNotOptimize(cron.count());
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+BENCHMARK(Cron_add_schedules_arena)->Arg(500000)->ArgName("tasks")->Unit(benchmark::kMillisecond);
+
+// Recalculating all tasks, as after a correction of the clock, with the tasks using 'expressions' different ones.
+static void Cron_recalculate_schedule(benchmark::State& state)
+{
+    BenchCron<libcron::HeapTaskQueue> cron;
+    std::vector<std::pair<std::string, std::string>> schedules;
+
+    for (int64_t i = 0; i < state.range(0); ++i)
+    {
+        // Spread the expressions so that neighbouring tasks use different ones.
+        auto expression = (i * 7919) % state.range(1);
+        schedules.emplace_back("Task-" + std::to_string(i), "0 " + std::to_string(expression % 60) + " "
+                                                                + std::to_string(expression / 60 % 24) + " * * ?");
+    }
+
+    cron.add_schedule(schedules, [](auto&) {});
+
+    for (auto _ : state)
+    {
+        cron.get_clock().add(hours{ 5 });
+        cron.recalculate_schedule();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+BENCHMARK(Cron_recalculate_schedule)
+        ->Args({ 1000000, 1 })
+        ->Args({ 1000000, 16 })
+        ->Args({ 1000000, 1000 })
+        ->ArgNames({ "tasks", "expressions" })
+        ->Unit(benchmark::kMillisecond);
+
+// Resynchronising all schedules, e.g. from a database, one by one versus with a changeset.
+static void Cron_update_schedules(benchmark::State& state)
+{
+    BenchCron<libcron::HeapTaskQueue> cron;
+    add_tasks(cron, state.range(0), 100);
+    int64_t round = 0;
+
+    for (auto _ : state)
+    {
+        for (int64_t i = 0; i < state.range(0); ++i)
+        {
+            cron.update_schedule("Task-" + std::to_string(i), "0 " + std::to_string((i + round) % 60) + " * * * ?");
+        }
+
+        ++round;
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+BENCHMARK(Cron_update_schedules)->Arg(100000)->ArgName("tasks")->Unit(benchmark::kMillisecond);
+
+static void Cron_apply_changeset(benchmark::State& state)
+{
+    BenchCron<libcron::HeapTaskQueue> cron;
+    add_tasks(cron, state.range(0), 100);
+    std::vector<libcron::ChangeStatus> status;
+    libcron::Changeset changes;
+    int64_t round = 0;
+
+    for (auto _ : state)
+    {
+        changes.clear();
+
+        for (int64_t i = 0; i < state.range(0); ++i)
+        {
+            changes.replace("Task-" + std::to_string(i), "0 " + std::to_string((i + round) % 60) + " * * * ?");
+        }
+
+        cron.apply(changes, status);
+        ++round;
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+BENCHMARK(Cron_apply_changeset)->Arg(100000)->ArgName("tasks")->Unit(benchmark::kMillisecond);
+
+// Reconciling with a desired set of schedules of which 'changed' differ, versus clearing and adding all of them.
+static void Cron_reconcile(benchmark::State& state)
+{
+    BenchCron<libcron::HeapTaskQueue> cron;
+    std::unordered_map<std::string, std::string> desired;
+
+    for (int64_t i = 0; i < state.range(0); ++i)
+    {
+        desired.emplace("Task-" + std::to_string(i), "0 " + std::to_string(i % 60) + " * * * ?");
+    }
+
+    cron.reconcile(desired, [](std::string_view) { return [](auto&) {}; });
+    int64_t round = 0;
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        ++round;
+
+        for (int64_t i = 0; i < state.range(1); ++i)
+        {
+            desired["Task-" + std::to_string(i)] = "0 " + std::to_string((i + round) % 60) + " * * * ?";
+        }
+
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(cron.reconcile(desired, [](std::string_view) { return [](auto&) {}; }));
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+BENCHMARK(Cron_reconcile)
+        ->Args({ 100000, 0 })
+        ->Args({ 100000, 100 })
+        ->ArgNames({ "tasks", "changed" })
+        ->Unit(benchmark::kMillisecond);
+
+static void Cron_clear_and_add(benchmark::State& state)
+{
+    BenchCron<libcron::HeapTaskQueue> cron;
+    std::unordered_map<std::string, std::string> desired;
+
+    for (int64_t i = 0; i < state.range(0); ++i)
+    {
+        desired.emplace("Task-" + std::to_string(i), "0 " + std::to_string(i % 60) + " * * * ?");
+    }
+
+    for (auto _ : state)
+    {
+        cron.clear_schedules();
+        cron.add_schedule(desired, [](auto&) {});
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+BENCHMARK(Cron_clear_and_add)->Arg(100000)->ArgName("tasks")->Unit(benchmark::kMillisecond);
+
+// A burst of tasks all due at the top of the minute, ticked by one thread for each shard.
+static void ShardedCron_burst(benchmark::State& state)
+{
+    libcron::ShardedCron<BenchClock> cron{ static_cast<size_t>(state.range(1)) };
+
+    for (int64_t i = 0; i < state.range(0); ++i)
+    {
+        cron.add_schedule("Task-" + std::to_string(i), "0 * * * * ?", [](auto&) {});
+    }
+
+    cron.tick();
+    std::vector<std::thread> threads;
+
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < cron.shard_count(); ++i)
+        {
+            auto& shard = cron.get_shard(i);
+            shard.get_clock().add(minutes{ 1 });
+            threads.emplace_back([&shard]()
+                                 {
+                                     benchmark::DoNotOptimize(shard.tick());
+                                 });
+        }
+
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+
+        threads.clear();
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+BENCHMARK(ShardedCron_burst)
+        ->ArgsProduct({ { 100000, 1000000 }, { 1, 2, 4, 8 } })
+        ->ArgNames({ "tasks", "shards" })
+        ->Unit(benchmark::kMillisecond)
+        ->UseRealTime();
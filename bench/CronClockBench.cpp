@@ -0,0 +1,26 @@
+#include <benchmark/benchmark.h>
+#include <libcron/CronClock.h>
+
+static void LocalClock_now(benchmark::State& state)
+{
+    libcron::LocalClock clock;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(clock.now());
+    }
+}
+
+BENCHMARK(LocalClock_now);
+
+static void ZonedClock_now(benchmark::State& state)
+{
+    libcron::ZonedClock clock{ libcron::TimeZone::from_posix("Berlin", "CET-1CEST,M3.5.0,M10.5.0/3") };
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(clock.now());
+    }
+}
+
+BENCHMARK(ZonedClock_now);
@@ -0,0 +1,171 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+#include <libcron/CronData.h>
+#include <libcron/CronDataCache.h>
+#include <libcron/CronRandomization.h>
+#include "LegacyCronData.h"
+
+namespace
+{
+    const std::vector<std::string>& expressions()
+    {
+        static const std::vector<std::string> e{
+                "* * * * * ?",
+                "0 */5 * * * ?",
+                "0 0 12 * * MON-FRI",
+                "0 0 12 1/2 * ?",
+                "0 0 */12 ? * *",
+                "0 0 10 25 FEB ?",
+                "0 0 0 29 2 ?",
+                "0 22 15 1 * ?",
+                "0,15,30,45 0-30 8-18 ? * sat-tue,wed",
+                "0 0 0 ? JAN-MAR,DEC FRI,MON,THU" };
+
+        return e;
+    }
+}
+
+// Parse throughput of the hand-written tokenizer, bypassing the cache in CronData::create().
+static void CronData_parse(benchmark::State& state)
+{
+    const auto& e = expressions();
+    size_t i = 0;
+
+    for (auto _ : state)
+    {
+        libcron::CronData c{ e[i++ % e.size()] };
+        benchmark::DoNotOptimize(c);
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+BENCHMARK(CronData_parse);
+
+// Parse throughput of the previous, regex based, implementation.
+static void CronData_parse_legacy(benchmark::State& state)
+{
+    const auto& e = expressions();
+    size_t i = 0;
+
+    for (auto _ : state)
+    {
+        libcron::legacy::CronData c{ e[i++ % e.size()] };
+        benchmark::DoNotOptimize(c);
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+BENCHMARK(CronData_parse_legacy);
+
+// CronData::create() when the expression is not cached, i.e. parsing plus the cache lookup.
+static void CronData_create_cold(benchmark::State& state)
+{
+    const auto& e = expressions();
+    size_t i = 0;
+    libcron::CronDataCache cache{ 0 };
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(cache.get(e[i++ % e.size()]));
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+BENCHMARK(CronData_create_cold);
+
+// CronData::create() when the expression is cached.
+static void CronData_create_warm(benchmark::State& state)
+{
+    const auto& e = expressions();
+    size_t i = 0;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(libcron::CronData::create_shared(e[i++ % e.size()]));
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+BENCHMARK(CronData_create_warm);
+
+// Resolving a randomized expression followed by CronData::create() of the result.
+static void CronRandomization_parse(benchmark::State& state)
+{
+    static const std::vector<std::string> e{
+            "0 0 R(13-20) * * ?",
+            "0 0 0 ? * R(0-6)",
+            "0 R(45-15) */12 ? * *",
+            "0 0 0 ? R(DEC-MAR) R(SAT-SUN)",
+            "R(0-59) R(0-59) R(0-23) R(1-28) R(1-12) ?" };
+
+    size_t i = 0;
+    libcron::CronRandomization randomization;
+
+    for (auto _ : state)
+    {
+        auto res = randomization.parse(e[i++ % e.size()]);
+        benchmark::DoNotOptimize(libcron::CronData::create_shared(std::get<1>(res)));
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+BENCHMARK(CronRandomization_parse);
+
+// As CronRandomization_parse, producing the CronData directly.
+static void CronRandomization_create(benchmark::State& state)
+{
+    static const std::vector<std::string> e{
+            "0 0 R(13-20) * * ?",
+            "0 0 0 ? * R(0-6)",
+            "0 R(45-15) */12 ? * *",
+            "0 0 0 ? R(DEC-MAR) R(SAT-SUN)",
+            "R(0-59) R(0-59) R(0-23) R(1-28) R(1-12) ?" };
+
+    size_t i = 0;
+    libcron::CronRandomization randomization{ 1 };
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(randomization.create(e[i++ % e.size()]));
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+BENCHMARK(CronRandomization_create);
+
+// Picking the values by the name of the task.
+static void CronRandomization_create_keyed(benchmark::State& state)
+{
+    static const std::vector<std::string> e{
+            "0 0 R(13-20) * * ?",
+            "0 0 0 ? * R(0-6)",
+            "0 R(45-15) */12 ? * *",
+            "0 0 0 ? R(DEC-MAR) R(SAT-SUN)",
+            "R(0-59) R(0-59) R(0-23) R(1-28) R(1-12) ?" };
+
+    std::vector<std::string> names{};
+
+    for (size_t n = 0; n < 1000; ++n)
+    {
+        names.emplace_back("Task " + std::to_string(n));
+    }
+
+    size_t i = 0;
+
+    for (auto _ : state)
+    {
+        auto& name = names[i % names.size()];
+        benchmark::DoNotOptimize(libcron::CronRandomization::create(e[i++ % e.size()], 1, name));
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+BENCHMARK(CronRandomization_create_keyed);
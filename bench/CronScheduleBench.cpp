@@ -0,0 +1,111 @@
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <libcron/CronData.h>
+#include <libcron/CronSchedule.h>
+
+using namespace std::chrono;
+
+namespace
+{
+    // Expressions for which the next schedule is close by
+    const std::vector<std::string> dense{
+            "* * * * * ?",
+            "0 */5 * * * ?",
+            "*/10 * 8-18 * * ?",
+            "0,15,30,45 0-30 8-18 ? * sat-tue,wed" };
+
+    // Expressions for which the next schedule is far away
+    const std::vector<std::string> sparse{
+            "0 0 0 29 2 ?",
+            "0 0 10 25 FEB ?",
+            "0 0 0 31 * ?",
+            "0 0 12 ? JAN MON" };
+
+    void calculate_from(benchmark::State& state, const std::vector<std::string>& expressions)
+    {
+        std::vector<libcron::CronSchedule> schedules;
+
+        for (const auto& e : expressions)
+        {
+            schedules.emplace_back(libcron::CronData::create_shared(e));
+        }
+
+        const auto start = system_clock::from_time_t(1577836800); // 2020-01-01
+        auto from = start;
+        size_t i = 0;
+
+        for (auto _ : state)
+        {
+            auto res = schedules[i++ % schedules.size()].calculate_from(from);
+            benchmark::DoNotOptimize(res);
+
+            // Walk through the calendar rather than calculating from the same point in time,
+            // and start over before reaching the end of the time_point.
+            from = std::get<0>(res) && std::get<1>(res) < start + hours{ 24 * 365 * 100 }
+                   ? std::get<1>(res) + seconds{ 1 }
+                   : start;
+        }
+
+        state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    }
+
+    // As calculate_from(), but many schedules at a time.
+    void next_n(benchmark::State& state, const std::vector<std::string>& expressions)
+    {
+        std::vector<libcron::CronSchedule> schedules;
+
+        for (const auto& e : expressions)
+        {
+            schedules.emplace_back(libcron::CronData::create_shared(e));
+        }
+
+        const auto start = system_clock::from_time_t(1577836800); // 2020-01-01
+        std::vector<system_clock::time_point> out(static_cast<size_t>(state.range(0)));
+        auto from = start;
+        size_t i = 0;
+        int64_t items = 0;
+
+        for (auto _ : state)
+        {
+            auto found = schedules[i++ % schedules.size()].next_n(from, out.data(), out.size());
+            benchmark::DoNotOptimize(out.data());
+            items += static_cast<int64_t>(found);
+
+            from = found > 0 && out[found - 1] < start + hours{ 24 * 365 * 100 }
+                   ? out[found - 1] + seconds{ 1 }
+                   : start;
+        }
+
+        state.SetItemsProcessed(items);
+    }
+}
+
+static void CronSchedule_calculate_from_dense(benchmark::State& state)
+{
+    calculate_from(state, dense);
+}
+
+BENCHMARK(CronSchedule_calculate_from_dense);
+
+static void CronSchedule_calculate_from_sparse(benchmark::State& state)
+{
+    calculate_from(state, sparse);
+}
+
+BENCHMARK(CronSchedule_calculate_from_sparse);
+
+static void CronSchedule_next_n_dense(benchmark::State& state)
+{
+    next_n(state, dense);
+}
+
+BENCHMARK(CronSchedule_next_n_dense)->Arg(16)->Arg(256);
+
+static void CronSchedule_next_n_sparse(benchmark::State& state)
+{
+    next_n(state, sparse);
+}
+
+BENCHMARK(CronSchedule_next_n_sparse)->Arg(16)->Arg(256);
@@ -0,0 +1,40 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <libcron/CronRandomization.h>
+#include <libcron/Simulation.h>
+
+// A year of a mix of 100k daily, weekly and hourly schedules, each with randomized times. With 1,
+// the second is randomized too, so that nearly all schedules differ and none are calculated together.
+// The Simulation is set up once, as the time taken is that of running it.
+static void Simulation_year_100k(benchmark::State& state)
+{
+    using namespace std::chrono;
+
+    libcron::Simulation simulation;
+
+    for (uint32_t i = 0; i < 100000; ++i)
+    {
+        std::string expression = i % 100 == 0 ? "R(0-59) * * * ?"
+                                 : i % 2 == 0 ? "R(0-59) R(0-23) * * ?"
+                                 : "R(0-59) R(0-23) ? * R(0-6)";
+
+        auto name = "Task " + std::to_string(i);
+        auto data = libcron::CronRandomization::create((state.range(0) == 1 ? "R(0-59) " : "0 ") + expression, 1, name);
+        simulation.add(name, libcron::CronSchedule{ data });
+    }
+
+    const system_clock::time_point from = system_clock::from_time_t(1704067200); // 2024-01-01
+    libcron::FireEvents events;
+
+    for (auto _ : state)
+    {
+        events.clear();
+        simulation.run(from, from + hours{ 24 * 365 }, events);
+        benchmark::DoNotOptimize(events.schedules.data());
+    }
+
+    state.counters["events"] = static_cast<double>(events.size());
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * events.size()));
+}
+
+BENCHMARK(Simulation_year_100k)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Task.h"
+
+namespace libcron
+{
+    // The outcome of each change when applying a Changeset, see Cron::apply().
+    enum class ChangeStatus
+    {
+        Applied,
+        InvalidSchedule,    // Nothing changed
+        NeverExpires,       // The schedule is valid but never expires, so the task was not added or was removed
+        AlreadyExists,      // Adding a task with the name of an existing one
+        NotFound            // Replacing or removing a task that doesn't exist
+    };
+
+    // A batch of changes to the tasks of a Cron instance, applied in order with a single lock,
+    // calculation of the current time and reordering of the queue.
+    class Changeset
+    {
+        public:
+            enum class Kind
+            {
+                Add,
+                Replace,
+                Remove
+            };
+
+            struct Change
+            {
+                Kind kind;
+                std::string name;
+                std::string schedule;
+                Task::TaskFunction work;
+            };
+
+            void add(std::string name, std::string schedule, Task::TaskFunction work)
+            {
+                changes.push_back(Change{ Kind::Add, std::move(name), std::move(schedule), std::move(work) });
+            }
+
+            // Replaces the schedule of an existing task and, unless empty, its work. A paused task stays paused.
+            void replace(std::string name, std::string schedule, Task::TaskFunction work = {})
+            {
+                changes.push_back(Change{ Kind::Replace, std::move(name), std::move(schedule), std::move(work) });
+            }
+
+            void remove(std::string name)
+            {
+                changes.push_back(Change{ Kind::Remove, std::move(name), {}, {} });
+            }
+
+            const std::vector<Change>& get_changes() const
+            {
+                return changes;
+            }
+
+            size_t size() const
+            {
+                return changes.size();
+            }
+
+            void reserve(size_t count)
+            {
+                changes.reserve(count);
+            }
+
+            void clear()
+            {
+                changes.clear();
+            }
+
+        private:
+            std::vector<Change> changes{};
+    };
+}
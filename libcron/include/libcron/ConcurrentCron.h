@@ -0,0 +1,380 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "Cron.h"
+
+namespace libcron
+{
+    // The state of a task as of the last change to the tasks of a ConcurrentCron.
+    struct TaskStatus
+    {
+        std::string name;
+        // As of the snapshot, see next_schedule_at().
+        std::chrono::system_clock::time_point next_schedule;
+        bool paused;
+        CronSchedule schedule;
+        std::shared_ptr<const TimeZone> zone;
+        std::chrono::seconds offset;
+
+        // The next schedule as of now. Snapshots aren't published for tasks merely running, so once the one in
+        // the snapshot is due, the one after now is calculated as a tick does. Max if the task won't expire again.
+        std::chrono::system_clock::time_point next_schedule_at(std::chrono::system_clock::time_point now) const
+        {
+            auto res = next_schedule;
+
+            if (!paused && now >= next_schedule)
+            {
+                auto from = now + std::chrono::seconds{ 1 } - offset;
+                auto next = zone ? schedule.calculate_from(from, *zone) : schedule.calculate_from(from);
+                res = std::get<0>(next) ? std::get<1>(next) + offset : std::chrono::system_clock::time_point::max();
+            }
+
+            return res;
+        }
+    };
+
+    // Published by ConcurrentCron after each tick that changed the tasks, sorted by name.
+    struct CronSnapshot
+    {
+        std::chrono::system_clock::time_point time{};
+        std::vector<TaskStatus> tasks{};
+
+        // Returns nullptr if there is no such task.
+        const TaskStatus* find(const std::string& name) const
+        {
+            auto it = std::lower_bound(tasks.begin(), tasks.end(), name, [](const TaskStatus& t, const std::string& n)
+            {
+                return t.name < n;
+            });
+
+            return it != tasks.end() && it->name == name ? &*it : nullptr;
+        }
+    };
+
+    // A Cron variant for many threads changing and querying the tasks while one thread ticks.
+    //
+    // Changes are pushed onto a lock-free queue and applied by the ticking thread at the start
+    // of its next tick, so they never wait for a tick to finish nor does a tick wait for them.
+    // Queries are answered from the last published snapshot, which is replaced, never modified.
+    // As it is only replaced when commands have changed the tasks, or tasks that won't expire
+    // again have been removed, ticks that merely run tasks don't copy the tasks.
+    // As changes take effect asynchronously, the functions making them only report whether the
+    // schedule is valid.
+    template<typename ClockType = libcron::LocalClock,
+             template<typename> class QueueType = libcron::TaskQueue,
+             typename ObserverType = libcron::NullObserver>
+    class ConcurrentCron
+    {
+        public:
+            using CronType = Cron<ClockType, NullLock, QueueType, ObserverType>;
+
+            ConcurrentCron() = default;
+
+            explicit ConcurrentCron(Executor executor)
+                    : cron(std::move(executor))
+            {
+            }
+
+            // See Cron(std::pmr::memory_resource*); the resource is only used by the ticking thread.
+            explicit ConcurrentCron(std::pmr::memory_resource* resource)
+                    : cron(resource)
+            {
+            }
+
+            ConcurrentCron(Executor executor, std::pmr::memory_resource* resource)
+                    : cron(std::move(executor), resource)
+            {
+            }
+
+            ~ConcurrentCron()
+            {
+                delete_commands(commands.exchange(nullptr));
+            }
+
+            ConcurrentCron(const ConcurrentCron&) = delete;
+
+            ConcurrentCron& operator=(const ConcurrentCron&) = delete;
+
+            bool add_schedule(std::string name, const std::string& schedule, Task::TaskFunction work)
+            {
+                bool res = CronData::create_shared(schedule)->is_valid();
+
+                if (res)
+                {
+                    push([name = std::move(name), schedule, work = std::move(work)](CronType& c) mutable
+                         {
+                             c.add_schedule(std::move(name), schedule, std::move(work));
+                         });
+                }
+
+                return res;
+            }
+
+            bool update_schedule(std::string name, const std::string& schedule)
+            {
+                bool res = CronData::create_shared(schedule)->is_valid();
+
+                if (res)
+                {
+                    push([name = std::move(name), schedule](CronType& c)
+                         {
+                             c.update_schedule(name, schedule);
+                         });
+                }
+
+                return res;
+            }
+
+            void remove_schedule(std::string name)
+            {
+                push([name = std::move(name)](CronType& c)
+                     {
+                         c.remove_schedule(name);
+                     });
+            }
+
+            void pause_schedule(std::string name)
+            {
+                push([name = std::move(name)](CronType& c)
+                     {
+                         c.pause_schedule(name);
+                     });
+            }
+
+            void resume_schedule(std::string name)
+            {
+                push([name = std::move(name)](CronType& c)
+                     {
+                         c.resume_schedule(name);
+                     });
+            }
+
+            void clear_schedules()
+            {
+                push([](CronType& c)
+                     {
+                         c.clear_schedules();
+                     });
+            }
+
+            void set_misfire_options(const MisfireOptions& options)
+            {
+                push([options](CronType& c)
+                     {
+                         c.set_misfire_options(options);
+                     });
+            }
+
+            // See Cron::set_jitter().
+            void set_jitter(std::chrono::seconds window)
+            {
+                push([window](CronType& c)
+                     {
+                         c.set_jitter(window);
+                     });
+            }
+
+            // Never nullptr, but empty until the first tick.
+            std::shared_ptr<const CronSnapshot> get_snapshot() const
+            {
+                std::lock_guard<std::mutex> guard{ snapshot_lock };
+                return snapshot;
+            }
+
+            // As of the last tick
+            bool has_schedule(const std::string& name) const
+            {
+                return get_snapshot()->find(name) != nullptr;
+            }
+
+            // As of the last tick
+            size_t count() const
+            {
+                return get_snapshot()->tasks.size();
+            }
+
+            // The tasks as of the last tick, with the time until expiry relative to the time of that tick. The clock
+            // isn't read, as it may only be safe to use from the ticking thread, as with clocks set by it.
+            void get_time_until_expiry_for_tasks(
+                    std::vector<std::tuple<std::string, std::chrono::system_clock::duration>>& status) const
+            {
+                get_time_until_expiry_for_tasks(status, std::chrono::system_clock::time_point{
+                        std::chrono::system_clock::duration{ last_tick.load(std::memory_order_relaxed) } });
+            }
+
+            // As above, relative to now instead, e.g. from a thread-safe clock.
+            void get_time_until_expiry_for_tasks(
+                    std::vector<std::tuple<std::string, std::chrono::system_clock::duration>>& status,
+                    std::chrono::system_clock::time_point now) const
+            {
+                auto current = get_snapshot();
+                status.clear();
+
+                for (auto& t : current->tasks)
+                {
+                    auto next = t.next_schedule_at(now);
+                    status.emplace_back(t.name, next > now ? next - now : std::chrono::system_clock::duration{});
+                }
+            }
+
+            // The functions below are for the ticking thread only.
+
+            size_t tick()
+            {
+                return tick(cron.get_clock().now());
+            }
+
+            size_t tick(std::chrono::system_clock::time_point now)
+            {
+                bool changed = apply_commands();
+                auto res = cron.tick(now);
+                last_tick.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+
+                // Tasks are only removed by a tick once they won't expire again.
+                if (changed || cron.count() != published_count)
+                {
+                    publish(now);
+                }
+
+                return res;
+            }
+
+            std::chrono::system_clock::duration time_until_next() const
+            {
+                return cron.time_until_next();
+            }
+
+            bool time_until_next(std::chrono::system_clock::duration& time_until) const
+            {
+                return cron.time_until_next(time_until);
+            }
+
+            ClockType& get_clock()
+            {
+                return cron.get_clock();
+            }
+
+            // Safe to use from any thread as long as the observer is, as CronMetrics is.
+            const ObserverType& get_observer() const
+            {
+                return cron.get_observer();
+            }
+
+            // Called after each change is queued, from the thread doing so. See CronRunner.
+            void set_change_listener(std::function<void()> listener)
+            {
+                std::lock_guard<std::mutex> guard{ listener_lock };
+                change_listener = std::move(listener);
+            }
+
+        private:
+            struct Command
+            {
+                std::function<void(CronType&)> apply;
+                Command* next;
+            };
+
+            void push(std::function<void(CronType&)> apply)
+            {
+                auto command = new Command{ std::move(apply), commands.load(std::memory_order_relaxed) };
+
+                while (!commands.compare_exchange_weak(command->next, command,
+                                                       std::memory_order_release,
+                                                       std::memory_order_relaxed))
+                {
+                }
+
+                std::function<void()> listener;
+
+                {
+                    std::lock_guard<std::mutex> guard{ listener_lock };
+                    listener = change_listener;
+                }
+
+                if (listener)
+                {
+                    listener();
+                }
+            }
+
+            bool apply_commands()
+            {
+                // Take all queued commands at once; they are linked newest first.
+                auto head = commands.exchange(nullptr, std::memory_order_acquire);
+                Command* in_order = nullptr;
+
+                while (head != nullptr)
+                {
+                    auto next = head->next;
+                    head->next = in_order;
+                    in_order = head;
+                    head = next;
+                }
+
+                bool res = in_order != nullptr;
+
+                for (auto command = in_order; command != nullptr; command = command->next)
+                {
+                    command->apply(cron);
+                }
+
+                delete_commands(in_order);
+
+                return res;
+            }
+
+            static void delete_commands(Command* command)
+            {
+                while (command != nullptr)
+                {
+                    auto next = command->next;
+                    delete command;
+                    command = next;
+                }
+            }
+
+            void publish(std::chrono::system_clock::time_point now)
+            {
+                auto next = std::make_shared<CronSnapshot>();
+                next->time = now;
+                next->tasks.reserve(cron.count());
+
+                cron.for_each_task([&next](const Task& t)
+                                   {
+                                       next->tasks.push_back(TaskStatus{ std::string{ t.get_name() }, t.get_next_schedule(), t.is_paused(),
+                                                                         t.get_schedule(), t.get_time_zone(), t.get_offset() });
+                                   });
+
+                std::sort(next->tasks.begin(), next->tasks.end(), [](const TaskStatus& a, const TaskStatus& b)
+                {
+                    return a.name < b.name;
+                });
+
+                published_count = next->tasks.size();
+                std::shared_ptr<const CronSnapshot> published = std::move(next);
+                std::lock_guard<std::mutex> guard{ snapshot_lock };
+                snapshot.swap(published);
+            }
+
+            CronType cron{};
+            std::atomic<Command*> commands{ nullptr };
+            size_t published_count = 0;
+            // For readers, which mustn't use the clock.
+            std::atomic<std::chrono::system_clock::rep> last_tick{ 0 };
+
+            // Only held long enough to copy or swap the pointer.
+            mutable std::mutex snapshot_lock{};
+            std::shared_ptr<const CronSnapshot> snapshot = std::make_shared<const CronSnapshot>();
+
+            std::mutex listener_lock{};
+            std::function<void()> change_listener{};
+    };
+}
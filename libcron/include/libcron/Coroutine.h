@@ -0,0 +1,171 @@
+#pragma once
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && __has_include(<coroutine>)
+
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include "Task.h"
+#include "ThreadPool.h"
+
+namespace libcron
+{
+    // What a coroutine run as the work of a task is given, see async_work(). Unlike the TaskInformation
+    // passed to plain work, it stays valid across suspensions when the coroutine takes it by value.
+    class AsyncTaskInformation : public TaskInformation
+    {
+        public:
+            explicit AsyncTaskInformation(const TaskInformation& info)
+                    : name(info.get_name()), delay(info.get_delay()), completion(info.defer_completion())
+            {
+            }
+
+            std::chrono::system_clock::duration get_delay() const override
+            {
+                return delay;
+            }
+
+            std::string_view get_name() const override
+            {
+                return name;
+            }
+
+            // Calling it ends the run before the coroutine has finished.
+            RunCompletion defer_completion() const override
+            {
+                return completion;
+            }
+
+        private:
+            std::string name;
+            std::chrono::system_clock::duration delay;
+            RunCompletion completion;
+    };
+
+    // The return type of a coroutine run as the work of a task. It starts suspended, until started by async_work().
+    class AsyncWork
+    {
+        public:
+            struct promise_type
+            {
+                AsyncWork get_return_object()
+                {
+                    return AsyncWork{ std::coroutine_handle<promise_type>::from_promise(*this) };
+                }
+
+                std::suspend_always initial_suspend() noexcept
+                {
+                    return {};
+                }
+
+                // The frame is destroyed once the run has ended.
+                std::suspend_never final_suspend() noexcept
+                {
+                    completion();
+                    return {};
+                }
+
+                void return_void()
+                {
+                }
+
+                // As with an exception escaping a thread, there is no one left to handle it after a suspension.
+                void unhandled_exception()
+                {
+                    std::terminate();
+                }
+
+                RunCompletion completion{};
+                // The callable the coroutine was created by, whose captures it may use.
+                std::shared_ptr<const void> owner{};
+            };
+
+            AsyncWork(AsyncWork&& other) noexcept
+                    : handle(std::exchange(other.handle, {}))
+            {
+            }
+
+            AsyncWork(const AsyncWork&) = delete;
+
+            AsyncWork& operator=(const AsyncWork&) = delete;
+
+            AsyncWork& operator=(AsyncWork&&) = delete;
+
+            ~AsyncWork()
+            {
+                // Never started
+                if (handle)
+                {
+                    handle.destroy();
+                }
+            }
+
+            // Runs the coroutine until its first suspension. The coroutine then owns itself, ending the run
+            // and releasing the owner once it has finished.
+            void start(RunCompletion completion, std::shared_ptr<const void> owner = {}) &&
+            {
+                auto h = std::exchange(handle, {});
+                h.promise().completion = std::move(completion);
+                h.promise().owner = std::move(owner);
+                h.resume();
+            }
+
+        private:
+            explicit AsyncWork(std::coroutine_handle<promise_type> handle)
+                    : handle(handle)
+            {
+            }
+
+            std::coroutine_handle<promise_type> handle{};
+    };
+
+    // Awaiting it continues the coroutine in a job posted to the executor, e.g. one running jobs on an event loop.
+    struct ResumeOn
+    {
+        Executor executor;
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) const
+        {
+            executor([handle]()
+                     {
+                         handle.resume();
+                     });
+        }
+
+        void await_resume() const noexcept
+        {
+        }
+    };
+
+    inline ResumeOn resume_on(Executor executor)
+    {
+        return ResumeOn{ std::move(executor) };
+    }
+
+    // Adapts a coroutine taking an AsyncTaskInformation and returning AsyncWork to the work of a task, for use
+    // with add_schedule(). Each run starts on the thread running the task, i.e. tick() or the executor, and
+    // ends once the coroutine has finished, so the overlap policy of the task covers the whole coroutine.
+    // The coroutine may await the I/O of an event loop, or resume_on() to move onto it. When it is a lambda, its
+    // captures are kept alive until it has finished, even if the work of the task has been replaced meanwhile.
+    template<typename Coroutine>
+    Task::TaskFunction async_work(Coroutine coroutine)
+    {
+        return [coroutine = std::make_shared<const Coroutine>(std::move(coroutine))](const TaskInformation& info)
+        {
+            auto completion = info.defer_completion();
+            std::invoke(*coroutine, AsyncTaskInformation{ info }).start(std::move(completion), coroutine);
+        };
+    }
+}
+
+#endif
@@ -1,16 +1,28 @@
 #pragma once
 
+#include <algorithm>
 #include <string>
+#include <string_view>
 #include <chrono>
+#include <functional>
 #include <limits>
 #include <memory>
+#include <memory_resource>
 #include <mutex>
 #include <map>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include "Task.h"
+#include "Changeset.h"
 #include "CronClock.h"
+#include "CronObserver.h"
+#include "CronExpression.h"
 #include "TaskQueue.h"
+#include "HeapTaskQueue.h"
+#include "GroupedTaskQueue.h"
+#include "ThreadPool.h"
+#include "Snapshot.h"
 
 namespace libcron
 {
@@ -30,18 +42,97 @@ namespace libcron
             std::recursive_mutex m{};
     };
 
-    template<typename ClockType, typename LockType>
+    // What to do about the schedules a task missed, e.g. because tick() wasn't called while the process was suspended.
+    enum class MisfirePolicy
+    {
+        RunOnce,    // Run once for all missed schedules
+        RunAll,     // Run once for each missed schedule, up to MisfireOptions::max_catch_up times
+        Skip        // Don't run, wait for the next schedule
+    };
+
+    struct MisfireOptions
+    {
+        MisfirePolicy policy = MisfirePolicy::RunOnce;
+        // A schedule is missed when noticed this long after it was due.
+        std::chrono::system_clock::duration threshold = std::chrono::seconds{ 60 };
+        // The most runs of a task for its missed schedules with MisfirePolicy::RunAll.
+        size_t max_catch_up = 10;
+        // Missed schedules are counted up to this many per task, bounding the work of noticing them.
+        size_t max_counted = 1000;
+        // When longer than a second, the runs for missed schedules are spread over this window
+        // instead of all being made in the tick noticing them. Each task keeps its place within the window.
+        std::chrono::system_clock::duration spread{};
+        // The most runs for missed schedules per tick, the remaining ones are moved to the following
+        // seconds. Zero means no limit.
+        size_t max_runs_per_tick = 0;
+        // A forward jump in time of three hours or more is considered a correction to the clock, after
+        // which all tasks are rescheduled without running. When set, the schedules in between are
+        // considered missed instead, e.g. to catch up after the machine was suspended.
+        bool catch_up_large_jumps = false;
+    };
+
+    struct MisfireStatistics
+    {
+        // Tasks noticed to have missed schedules
+        size_t misfired = 0;
+        // Runs made for missed schedules
+        size_t runs = 0;
+        // Missed schedules that didn't get a run of their own
+        size_t coalesced = 0;
+    };
+
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
     class Cron;
 
-    template<typename ClockType, typename LockType>
-    std::ostream& operator<<(std::ostream& stream, const Cron<ClockType, LockType>& c);
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
+    std::ostream& operator<<(std::ostream& stream, const Cron<ClockType, LockType, QueueType, ObserverType>& c);
 
+    // QueueType selects how the tasks are kept in order; the default TaskQueue, a sorted vector which
+    // is scanned each tick, suits small numbers of tasks, HeapTaskQueue scales to large numbers of tasks.
+    // ObserverType is told what each tick does, e.g. CronMetrics; the default NullObserver costs nothing.
     template<typename ClockType = libcron::LocalClock, 
-             typename LockType = libcron::NullLock>
+             typename LockType = libcron::NullLock,
+             template<typename> class QueueType = libcron::TaskQueue,
+             typename ObserverType = libcron::NullObserver>
     class Cron
     {
         public:
+            Cron() = default;
+
+            // Tasks are run through the executor instead of by tick() itself, which then only
+            // collects the expired tasks and dispatches them once the queue has been released.
+            explicit Cron(Executor executor)
+                    : executor(std::move(executor))
+            {
+            }
+
+            // The tasks, their names and the storage of the queue are allocated from the memory resource, which
+            // must outlive the Cron instance; e.g. a std::pmr::monotonic_buffer_resource for tasks loaded once,
+            // which are then all freed at once by dropping the instance and its resource.
+            explicit Cron(std::pmr::memory_resource* resource)
+                    : tasks(resource), resource(resource)
+            {
+            }
+
+            Cron(Executor executor, std::pmr::memory_resource* resource)
+                    : tasks(resource), executor(std::move(executor)), resource(resource)
+            {
+            }
+
             bool add_schedule(std::string name, const std::string& schedule, Task::TaskFunction work);
+
+            // As above, also providing a handle to the task. The handle is invalid if the
+            // schedule is valid but never expires, in which case the task is not added.
+            bool add_schedule(std::string name, const std::string& schedule, Task::TaskFunction work, TaskHandle& handle);
+
+            // As above, with an expression that has already been parsed, e.g. cron_expr<"0 */5 * * * ?">::data().
+            bool add_schedule(std::string name, std::shared_ptr<const CronData> schedule, Task::TaskFunction work)
+            {
+                TaskHandle handle;
+                return add_schedule(std::move(name), std::move(schedule), std::move(work), handle);
+            }
+
+            bool add_schedule(std::string name, std::shared_ptr<const CronData> schedule, Task::TaskFunction work, TaskHandle& handle);
             
             template<typename Schedules = std::map<std::string, std::string>>
             std::tuple<bool, std::string, std::string>
@@ -49,12 +140,178 @@ namespace libcron
             void clear_schedules();
             void remove_schedule(const std::string& name);
 
+            // Applies the changes in order, as if made one by one, but with each expression parsed once,
+            // all schedules calculated from the same point in time and the new tasks added to the queue
+            // at once. Unlike the map overload of add_schedule, an invalid change doesn't prevent the
+            // others. status receives the outcome of each change; returns the number of changes applied.
+            size_t apply(const Changeset& changeset, std::vector<ChangeStatus>& status);
+
+            // Makes the tasks match the desired ones, a map of unique names to expressions, only touching
+            // the tasks that differ: tasks that aren't desired are removed, those with a different schedule
+            // get the desired one and missing ones are added with the work returned by work_of(name), unless
+            // it is empty. The other tasks, and their next schedule, last run and missed schedules, are left
+            // as they are, as are tasks whose desired expression is invalid.
+            // Each desired task is looked up once, all tasks are only looked at when some are to be removed.
+            // Returns the number of tasks added, replaced or removed.
+            template<typename Schedules = std::map<std::string, std::string>, typename WorkOf>
+            size_t reconcile(const Schedules& desired, WorkOf&& work_of);
+
+            void remove_schedule(TaskHandle handle)
+            {
+                tasks.remove(handle);
+                notify_change();
+            }
+
+            bool has_schedule(const std::string& name) const
+            {
+                tasks.lock_queue();
+                bool res = tasks.contains(name);
+                tasks.release_queue();
+
+                return res;
+            }
+
+            // False if the handle is stale, i.e. the task has been removed.
+            bool has_schedule(TaskHandle handle) const
+            {
+                tasks.lock_queue();
+                bool res = tasks.contains(handle);
+                tasks.release_queue();
+
+                return res;
+            }
+
+            // Replaces the schedule of an existing task, keeping its work. Returns false if the
+            // schedule is invalid or there is no such task.
+            bool update_schedule(const std::string& name, const std::string& schedule)
+            {
+                return update_schedule_of(name, schedule);
+            }
+
+            bool update_schedule(TaskHandle handle, const std::string& schedule)
+            {
+                return update_schedule_of(handle, schedule);
+            }
+
+            // A paused task stays scheduled but doesn't run until resumed, at which point
+            // its next schedule is calculated from the current time. Returns false if there is no such task.
+            bool pause_schedule(const std::string& name)
+            {
+                return pause_schedule_of(name);
+            }
+
+            bool pause_schedule(TaskHandle handle)
+            {
+                return pause_schedule_of(handle);
+            }
+
+            bool resume_schedule(const std::string& name)
+            {
+                return resume_schedule_of(name);
+            }
+
+            bool resume_schedule(TaskHandle handle)
+            {
+                return resume_schedule_of(handle);
+            }
+
+            // Only relevant when using an executor, or work deferring the end of its runs, see
+            // TaskInformation::defer_completion(). Returns false if there is no such task.
+            bool set_overlap_policy(const std::string& name, OverlapPolicy policy)
+            {
+                return set_overlap_policy_of(name, policy);
+            }
+
+            bool set_overlap_policy(TaskHandle handle, OverlapPolicy policy)
+            {
+                return set_overlap_policy_of(handle, policy);
+            }
+
+            // Makes the schedule of the task follow the local time of the zone, e.g. "America/New_York",
+            // with the time of the Cron instance taken to be UTC, so use a UTCClock. Returns false if there
+            // is no such task or zone.
+            bool set_time_zone(const std::string& name, const std::string& zone)
+            {
+                return set_time_zone_of(name, TimeZone::locate(zone));
+            }
+
+            bool set_time_zone(TaskHandle handle, const std::string& zone)
+            {
+                return set_time_zone_of(handle, TimeZone::locate(zone));
+            }
+
+            // Applies from the next tick on.
+            void set_misfire_options(const MisfireOptions& options)
+            {
+                tasks.lock_queue();
+                misfire = options;
+                tasks.release_queue();
+            }
+
+            // Spreads the runs of tasks sharing a schedule over the window after it: each task runs a fixed offset
+            // after each of its schedules, by a hash of its name, so it keeps the same times across restarts.
+            // Reschedules all tasks; zero, the default, turns it off.
+            void set_jitter(std::chrono::seconds window);
+
+            std::chrono::seconds get_jitter() const
+            {
+                return jitter;
+            }
+
+            // The offset of the task with the name within the window, see set_jitter().
+            static std::chrono::seconds jitter_of(std::string_view name, std::chrono::seconds window);
+
+            // The offset of the runs for the missed schedules of the task with the name within the window, see
+            // MisfireOptions::spread. Independent of its jitter, so that the runs don't follow the jittered schedules.
+            static std::chrono::seconds spread_of(std::string_view name, std::chrono::seconds window);
+
+            // A hash of the name, the same on all platforms unlike std::hash. jitter_of() uses it unsalted. Salted,
+            // it is passed through a finalizer, so that hashes with different salts are independent of each other,
+            // whatever they are reduced by.
+            static uint64_t hash_of(std::string_view name, uint64_t salt = 0);
+
+            // Totals since the Cron instance was created.
+            MisfireStatistics get_misfire_statistics() const
+            {
+                tasks.lock_queue();
+                auto res = misfire_statistics;
+                tasks.release_queue();
+                return res;
+            }
+
+            // Appends a snapshot of the state of all tasks to out, see Snapshot. Restoring it with
+            // restore_snapshot() continues where this instance is now, e.g. after a restart.
+            void save_snapshot(std::vector<uint8_t>& out) const
+            {
+                tasks.lock_queue();
+                Snapshot::write(tasks.get_tasks(), out);
+                tasks.release_queue();
+            }
+
+            // Adds the tasks of a snapshot made by save_snapshot(), with the next schedule, last run and
+            // missed schedules as they were, so that schedules missed meanwhile are handled as per the
+            // misfire options on the next tick. The next schedules of tasks whose offset differs from the one
+            // of the current jitter are moved to it, see set_jitter(). work_of is called with the name of each task
+            // and returns its work; tasks for which it returns an empty function are not added.
+            // Returns false, adding no tasks, if the data is not a valid snapshot.
+            template<typename WorkOf>
+            bool restore_snapshot(const void* data, size_t size, WorkOf&& work_of);
+
+            // Returns false if the handle is stale.
+            bool get_time_until_expiry(TaskHandle handle, std::chrono::system_clock::duration& time_until) const;
+
             size_t count() const
             {
-                return tasks.size();
+                tasks.lock_queue();
+                auto res = tasks.size();
+                tasks.release_queue();
+
+                return res;
             }
 
             // Tick is expected to be called at least once a second to prevent missing schedules.
+            // Returns the number of expired tasks, including those dispatched to the executor, or
+            // skipped or queued as per their overlap policy.
             size_t
             tick()
             {
@@ -64,60 +321,173 @@ namespace libcron
             size_t
             tick(std::chrono::system_clock::time_point now);
 
+            // Zero if there are no tasks.
             std::chrono::system_clock::duration
             time_until_next() const;
 
+            // Returns false if no task will expire, as there are none or all of them are paused.
+            bool time_until_next(std::chrono::system_clock::duration& time_until) const;
+
+            // The listener is called after tasks have been added, removed or rescheduled, from the thread
+            // doing so. Used by CronRunner to wake up when the next task to expire may have changed.
+            void set_change_listener(std::function<void()> listener)
+            {
+                tasks.lock_queue();
+                change_listener = std::move(listener);
+                tasks.release_queue();
+            }
+
             ClockType& get_clock()
             {
                 return clock;
             }
 
+            const ClockType& get_clock() const
+            {
+                return clock;
+            }
+
+            ObserverType& get_observer()
+            {
+                return observer;
+            }
+
+            const ObserverType& get_observer() const
+            {
+                return observer;
+            }
+
+            // Calls func for each task, in no particular order.
+            template<typename Func>
+            void for_each_task(Func&& func) const
+            {
+                tasks.lock_queue();
+
+                for (const auto& t : tasks.get_tasks())
+                {
+                    func(t);
+                }
+
+                tasks.release_queue();
+            }
+
             void recalculate_schedule()
             {
+                using namespace std::chrono_literals;
+                // Ensure that next schedule is in the future
+                auto from = clock.now() + 1s;
+                // Tasks sharing an expression are calculated once, see CronData::create_shared().
+                Task::NextScheduleMemos memos{};
+
                 for (auto& t : tasks.get_tasks())
                 {
-                    using namespace std::chrono_literals;
-                    // Ensure that next schedule is in the future
-                    t.calculate_next(clock.now() + 1s);
+                    t.calculate_next(from, memos);
                 }
+
+                tasks.sort();
+                notify_change();
             }
 
             void get_time_until_expiry_for_tasks(
                     std::vector<std::tuple<std::string, std::chrono::system_clock::duration>>& status) const;
 
-            friend std::ostream& operator<<<>(std::ostream& stream, const Cron<ClockType, LockType>& c);
+            friend std::ostream& operator<<<>(std::ostream& stream, const Cron<ClockType, LockType, QueueType, ObserverType>& c);
 
         private:
-            TaskQueue<LockType> tasks{};
+            static void parse_changes(const Changeset& changeset,
+                                      std::vector<std::shared_ptr<const CronData>>& schedules,
+                                      std::vector<ChangeStatus>& status);
+
+            // With the queue locked.
+            size_t apply_parsed(const Changeset& changeset,
+                                const std::vector<std::shared_ptr<const CronData>>& schedules,
+                                std::vector<ChangeStatus>& status);
+
+            template<typename Key>
+            bool update_schedule_of(const Key& key, const std::string& schedule);
+
+            void apply_jitter(Task& t) const
+            {
+                t.set_offset(jitter > std::chrono::seconds{ 0 } ? jitter_of(t.get_name(), jitter) : std::chrono::seconds{ 0 });
+            }
+
+            template<typename Key>
+            bool pause_schedule_of(const Key& key);
+
+            template<typename Key>
+            bool resume_schedule_of(const Key& key);
+
+            template<typename Key>
+            bool set_overlap_policy_of(const Key& key, OverlapPolicy policy);
+
+            template<typename Key>
+            bool set_time_zone_of(const Key& key, std::shared_ptr<const TimeZone> zone);
+
+            void notify_change()
+            {
+                tasks.lock_queue();
+                auto listener = change_listener;
+                tasks.release_queue();
+
+                if (listener)
+                {
+                    listener();
+                }
+            }
+
+            QueueType<LockType> tasks{};
+            Executor executor{};
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource();
+            std::function<void()> change_listener{};
             ClockType clock{};
+            ObserverType observer{};
+            MisfireOptions misfire{};
+            MisfireStatistics misfire_statistics{};
+            std::chrono::seconds jitter{ 0 };
             bool first_tick = true;
             std::chrono::system_clock::time_point last_tick{};
     };
     
-    template<typename ClockType, typename LockType>
-    bool Cron<ClockType, LockType>::add_schedule(std::string name, const std::string& schedule, Task::TaskFunction work)
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
+    bool Cron<ClockType, LockType, QueueType, ObserverType>::add_schedule(std::string name, const std::string& schedule, Task::TaskFunction work)
     {
-        auto cron = CronData::create(schedule);
-        bool res = cron.is_valid();
+        TaskHandle handle;
+        return add_schedule(std::move(name), schedule, std::move(work), handle);
+    }
+
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
+    bool Cron<ClockType, LockType, QueueType, ObserverType>::add_schedule(std::string name, const std::string& schedule, Task::TaskFunction work,
+                                                            TaskHandle& handle)
+    {
+        return add_schedule(std::move(name), CronData::create_shared(schedule), std::move(work), handle);
+    }
+
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
+    bool Cron<ClockType, LockType, QueueType, ObserverType>::add_schedule(std::string name, std::shared_ptr<const CronData> schedule,
+                                                            Task::TaskFunction work, TaskHandle& handle)
+    {
+        handle = TaskHandle{};
+        bool res = schedule->is_valid();
         if (res)
         {
             tasks.lock_queue();
-            Task t{std::move(name), CronSchedule{cron}, work };
+            Task t{ name, CronSchedule{ std::move(schedule) }, std::move(work), resource };
+            apply_jitter(t);
             if (t.calculate_next(clock.now()))
             {
-                tasks.push(t);
-                tasks.sort();
+                handle = tasks.push(std::move(t));
             }
             tasks.release_queue();
+            notify_change();
         }
 
         return res;
     }
 
-    template<typename ClockType, typename LockType>
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
     template<typename Schedules>
     std::tuple<bool, std::string, std::string>
-    Cron<ClockType, LockType>::add_schedule(const Schedules& name_schedule_map, Task::TaskFunction work)
+    Cron<ClockType, LockType, QueueType, ObserverType>::add_schedule(const Schedules& name_schedule_map, Task::TaskFunction work)
     {
         bool is_valid = true;
         std::tuple<bool, std::string, std::string> res{false, "", ""};
@@ -128,11 +498,12 @@ namespace libcron
         for (auto it = name_schedule_map.begin(); is_valid && it != name_schedule_map.end(); ++it)
         {
             const auto& [name, schedule] = *it;
-            auto cron = CronData::create(schedule);
-            is_valid = cron.is_valid();
+            auto cron = CronData::create_shared(schedule);
+            is_valid = cron->is_valid();
             if (is_valid)
             {
-                Task t{std::move(name), CronSchedule{cron}, work };
+                Task t{ name, CronSchedule{ cron }, work, resource };
+                apply_jitter(t);
                 if (t.calculate_next(clock.now()))
                 {
                     tasks_to_add.push_back(std::move(t));
@@ -150,30 +521,513 @@ namespace libcron
         {
             tasks.lock_queue();
             tasks.push(tasks_to_add);
-            tasks.sort();
             tasks.release_queue();
+            notify_change();
         }
 
         std::get<0>(res) = is_valid;
         return res;
     }
 
-    template<typename ClockType, typename LockType>
-    void Cron<ClockType, LockType>::clear_schedules()
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
+    template<typename WorkOf>
+    bool Cron<ClockType, LockType, QueueType, ObserverType>::restore_snapshot(const void* data, size_t size, WorkOf&& work_of)
+    {
+        Snapshot snapshot{};
+        bool res = snapshot.open(data, size);
+
+        if (res && snapshot.size() > 0)
+        {
+            std::vector<Task> tasks_to_add;
+            tasks_to_add.reserve(snapshot.size());
+
+            for (size_t i = 0; i < snapshot.size(); ++i)
+            {
+                Task::TaskFunction work = work_of(snapshot.get_name(i));
+
+                if (work)
+                {
+                    snapshot.restore(i, std::move(work), tasks_to_add, resource);
+                }
+            }
+
+            tasks.lock_queue();
+            Task::NextScheduleMemos memos{};
+
+            // The restored next schedules were made with the offsets at the time of the snapshot. Those made
+            // with another jitter are calculated again from their schedule, so that missed ones stay missed.
+            // Runs for missed schedules made later keep their time, which doesn't depend on the offset.
+            for (auto& t : tasks_to_add)
+            {
+                auto offset = t.get_offset();
+                apply_jitter(t);
+
+                if (t.get_offset() != offset && t.is_valid() && t.get_catch_up_runs() == 0)
+                {
+                    t.calculate_next(t.get_next_schedule() - offset + t.get_offset(), memos);
+                }
+            }
+
+            tasks.push(tasks_to_add);
+            tasks.release_queue();
+            notify_change();
+        }
+
+        return res;
+    }
+
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
+    size_t Cron<ClockType, LockType, QueueType, ObserverType>::apply(const Changeset& changeset, std::vector<ChangeStatus>& status)
+    {
+        std::vector<std::shared_ptr<const CronData>> schedules;
+        parse_changes(changeset, schedules, status);
+
+        tasks.lock_queue();
+        auto res = apply_parsed(changeset, schedules, status);
+        tasks.release_queue();
+
+        if (res > 0)
+        {
+            notify_change();
+        }
+
+        return res;
+    }
+
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
+    void Cron<ClockType, LockType, QueueType, ObserverType>::parse_changes(const Changeset& changeset,
+                                                                           std::vector<std::shared_ptr<const CronData>>& schedules,
+                                                                           std::vector<ChangeStatus>& status)
+    {
+        const auto& changes = changeset.get_changes();
+        status.assign(changes.size(), ChangeStatus::Applied);
+        schedules.assign(changes.size(), nullptr);
+
+        // Changesets usually repeat a few expressions many times.
+        std::unordered_map<std::string_view, std::shared_ptr<const CronData>> parsed;
+
+        for (size_t i = 0; i < changes.size(); ++i)
+        {
+            if (changes[i].kind != Changeset::Kind::Remove)
+            {
+                auto& data = parsed[changes[i].schedule];
+
+                if (!data)
+                {
+                    data = CronData::create_shared(changes[i].schedule);
+                }
+
+                schedules[i] = data;
+                status[i] = data->is_valid() ? ChangeStatus::Applied : ChangeStatus::InvalidSchedule;
+            }
+        }
+    }
+
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
+    size_t Cron<ClockType, LockType, QueueType, ObserverType>::apply_parsed(const Changeset& changeset,
+                                                                            const std::vector<std::shared_ptr<const CronData>>& schedules,
+                                                                            std::vector<ChangeStatus>& status)
+    {
+        using Kind = Changeset::Kind;
+        const auto& changes = changeset.get_changes();
+
+        // The tasks to add are collected and put in the queue together, unless a later change is about one of them.
+        std::vector<Task> tasks_to_add;
+        std::unordered_set<std::string_view> names_to_add;
+
+        auto add_collected = [this, &tasks_to_add, &names_to_add]()
+        {
+            if (!tasks_to_add.empty())
+            {
+                tasks.push(tasks_to_add);
+                tasks_to_add.clear();
+                names_to_add.clear();
+            }
+        };
+
+        size_t res = 0;
+        Task::NextScheduleMemos memos{};
+        auto now = clock.now();
+
+        for (size_t i = 0; i < changes.size(); ++i)
+        {
+            const auto& change = changes[i];
+
+            if (status[i] != ChangeStatus::Applied)
+            {
+                // Invalid schedule
+            }
+            else if (change.kind == Kind::Add)
+            {
+                if (names_to_add.count(change.name) > 0 || tasks.contains(change.name))
+                {
+                    status[i] = ChangeStatus::AlreadyExists;
+                }
+                else
+                {
+                    Task t{ change.name, CronSchedule{ schedules[i] }, change.work, resource };
+                    apply_jitter(t);
+
+                    if (t.calculate_next(now, memos))
+                    {
+                        names_to_add.insert(change.name);
+                        tasks_to_add.push_back(std::move(t));
+                    }
+                    else
+                    {
+                        status[i] = ChangeStatus::NeverExpires;
+                    }
+                }
+            }
+            else
+            {
+                if (names_to_add.count(change.name) > 0)
+                {
+                    add_collected();
+                }
+
+                bool kept = change.kind == Kind::Replace;
+                bool found = tasks.update(change.name, [&change, &schedule = schedules[i], now, &memos, &kept](Task& t)
+                                          {
+                                              if (kept)
+                                              {
+                                                  t.set_schedule(CronSchedule{ schedule });
+
+                                                  if (change.work)
+                                                  {
+                                                      t.set_work(change.work);
+                                                  }
+
+                                                  // Like update_schedule, a task that can't be scheduled is dropped.
+                                                  kept = t.calculate_next(now, memos);
+                                              }
+
+                                              return kept;
+                                          });
+
+                if (!found)
+                {
+                    status[i] = ChangeStatus::NotFound;
+                }
+                else if (change.kind == Kind::Replace && !kept)
+                {
+                    status[i] = ChangeStatus::NeverExpires;
+                }
+            }
+
+            res += status[i] == ChangeStatus::Applied ? 1 : 0;
+        }
+
+        add_collected();
+
+        return res;
+    }
+
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
+    template<typename Schedules, typename WorkOf>
+    size_t Cron<ClockType, LockType, QueueType, ObserverType>::reconcile(const Schedules& desired, WorkOf&& work_of)
+    {
+        // Parsed before locking the queue, each expression once.
+        std::vector<std::shared_ptr<const CronData>> desired_data;
+        std::unordered_map<std::string_view, std::shared_ptr<const CronData>> parsed;
+        desired_data.reserve(desired.size());
+
+        for (const auto& entry : desired)
+        {
+            auto& data = parsed[std::get<1>(entry)];
+
+            if (!data)
+            {
+                data = CronData::create_shared(std::get<1>(entry));
+            }
+
+            desired_data.push_back(data);
+        }
+
+        Changeset changes;
+        size_t existing = 0;
+        size_t i = 0;
+
+        tasks.lock_queue();
+
+        for (const auto& [name, schedule] : desired)
+        {
+            const auto& data = desired_data[i++];
+            auto t = tasks.get(name);
+
+            if (t != nullptr)
+            {
+                ++existing;
+
+                if (data->is_valid() && t->get_schedule().get_data() != data && *t->get_schedule().get_data() != *data)
+                {
+                    changes.replace(name, schedule);
+                }
+            }
+            else if (data->is_valid())
+            {
+                Task::TaskFunction work = work_of(std::string_view{ name });
+
+                if (work)
+                {
+                    changes.add(name, schedule, std::move(work));
+                }
+            }
+        }
+
+        // Only when some of the tasks aren't desired are all of them looked at.
+        if (existing < tasks.size())
+        {
+            std::unordered_set<std::string_view> desired_names;
+            desired_names.reserve(desired.size());
+
+            for (const auto& entry : desired)
+            {
+                desired_names.insert(std::get<0>(entry));
+            }
+
+            for (const auto& t : tasks.get_tasks())
+            {
+                if (desired_names.count(t.get_name()) == 0)
+                {
+                    changes.remove(std::string{ t.get_name() });
+                }
+            }
+        }
+
+        size_t res = 0;
+
+        if (changes.size() > 0)
+        {
+            std::vector<std::shared_ptr<const CronData>> schedules;
+            std::vector<ChangeStatus> status;
+            parse_changes(changes, schedules, status);
+            res = apply_parsed(changes, schedules, status);
+        }
+
+        tasks.release_queue();
+
+        if (res > 0)
+        {
+            notify_change();
+        }
+
+        return res;
+    }
+
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
+    void Cron<ClockType, LockType, QueueType, ObserverType>::clear_schedules()
     {
         tasks.clear();
+        notify_change();
     }
     
-    template<typename ClockType, typename LockType>
-    void Cron<ClockType, LockType>::remove_schedule(const std::string& name)
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
+    void Cron<ClockType, LockType, QueueType, ObserverType>::set_jitter(std::chrono::seconds window)
+    {
+        tasks.lock_queue();
+        jitter = window;
+        auto now = clock.now();
+        Task::NextScheduleMemos memos{};
+
+        for (auto& t : tasks.get_tasks())
+        {
+            apply_jitter(t);
+            t.calculate_next(now, memos);
+        }
+
+        tasks.sort();
+        tasks.release_queue();
+        notify_change();
+    }
+
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
+    std::chrono::seconds Cron<ClockType, LockType, QueueType, ObserverType>::jitter_of(std::string_view name,
+                                                                                      std::chrono::seconds window)
+    {
+        return std::chrono::seconds{ window.count() > 0 ? static_cast<int64_t>(hash_of(name) % static_cast<uint64_t>(window.count())) : 0 };
+    }
+
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
+    std::chrono::seconds Cron<ClockType, LockType, QueueType, ObserverType>::spread_of(std::string_view name,
+                                                                                      std::chrono::seconds window)
+    {
+        constexpr uint64_t salt = 0x5370726561640001ull;
+        return std::chrono::seconds{ window.count() > 0 ? static_cast<int64_t>(hash_of(name, salt) % static_cast<uint64_t>(window.count())) : 0 };
+    }
+
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
+    uint64_t Cron<ClockType, LockType, QueueType, ObserverType>::hash_of(std::string_view name, uint64_t salt)
+    {
+        // FNV-1a
+        uint64_t res = 0xcbf29ce484222325ull;
+
+        for (auto c : name)
+        {
+            res = (res ^ static_cast<uint8_t>(c)) * 0x100000001b3ull;
+        }
+
+        if (salt != 0)
+        {
+            // The finalizer of splitmix64
+            res ^= salt;
+            res = (res ^ (res >> 30)) * 0xbf58476d1ce4e5b9ull;
+            res = (res ^ (res >> 27)) * 0x94d049bb133111ebull;
+            res ^= res >> 31;
+        }
+
+        return res;
+    }
+
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
+    void Cron<ClockType, LockType, QueueType, ObserverType>::remove_schedule(const std::string& name)
     {
         tasks.remove(name);
+        notify_change();
     }
 
-    template<typename ClockType, typename LockType>
-    std::chrono::system_clock::duration Cron<ClockType, LockType>::time_until_next() const
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
+    template<typename Key>
+    bool Cron<ClockType, LockType, QueueType, ObserverType>::update_schedule_of(const Key& key, const std::string& schedule)
+    {
+        auto cron = CronData::create_shared(schedule);
+        bool res = cron->is_valid();
+        if (res)
+        {
+            tasks.lock_queue();
+            auto now = clock.now();
+            // Like add_schedule, a task that can't be scheduled is dropped.
+            res = tasks.update(key, [&cron, now](Task& t)
+                               {
+                                   t.set_schedule(CronSchedule{ cron });
+                                   // A paused task stays paused, with the new schedule taking effect when resumed.
+                                   return t.calculate_next(now);
+                               });
+            tasks.release_queue();
+            notify_change();
+        }
+
+        return res;
+    }
+
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
+    template<typename Key>
+    bool Cron<ClockType, LockType, QueueType, ObserverType>::pause_schedule_of(const Key& key)
+    {
+        tasks.lock_queue();
+        bool res = tasks.update(key, [](Task& t)
+                                {
+                                    t.pause();
+                                    return true;
+                                });
+        tasks.release_queue();
+        notify_change();
+
+        return res;
+    }
+
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
+    template<typename Key>
+    bool Cron<ClockType, LockType, QueueType, ObserverType>::resume_schedule_of(const Key& key)
+    {
+        tasks.lock_queue();
+        auto now = clock.now();
+        bool res = tasks.update(key, [now](Task& t)
+                                {
+                                    bool keep = true;
+
+                                    if (t.is_paused())
+                                    {
+                                        t.resume();
+                                        keep = t.calculate_next(now);
+                                    }
+
+                                    return keep;
+                                });
+        tasks.release_queue();
+        notify_change();
+
+        return res;
+    }
+
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
+    template<typename Key>
+    bool Cron<ClockType, LockType, QueueType, ObserverType>::set_overlap_policy_of(const Key& key, OverlapPolicy policy)
+    {
+        tasks.lock_queue();
+        bool res = tasks.update(key, [policy](Task& t)
+                                {
+                                    t.set_overlap_policy(policy);
+                                    return true;
+                                });
+        tasks.release_queue();
+
+        return res;
+    }
+
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
+    template<typename Key>
+    bool Cron<ClockType, LockType, QueueType, ObserverType>::set_time_zone_of(const Key& key, std::shared_ptr<const TimeZone> zone)
+    {
+        bool res = zone != nullptr;
+
+        if (res)
+        {
+            tasks.lock_queue();
+            auto now = clock.now();
+            res = tasks.update(key, [now, &zone](Task& t)
+                               {
+                                   t.set_time_zone(zone);
+                                   return t.is_paused() || t.calculate_next(now);
+                               });
+            tasks.release_queue();
+            notify_change();
+        }
+
+        return res;
+    }
+
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
+    bool Cron<ClockType, LockType, QueueType, ObserverType>::get_time_until_expiry(TaskHandle handle,
+                                                                     std::chrono::system_clock::duration& time_until) const
+    {
+        tasks.lock_queue();
+        auto t = tasks.get(handle);
+        bool res = t != nullptr;
+
+        if (res)
+        {
+            time_until = t->time_until_expiry(clock.now());
+        }
+
+        tasks.release_queue();
+
+        return res;
+    }
+
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
+    bool Cron<ClockType, LockType, QueueType, ObserverType>::time_until_next(std::chrono::system_clock::duration& time_until) const
+    {
+        tasks.lock_queue();
+        // Tasks that never expire are ordered last.
+        bool res = !tasks.empty() && tasks.top().get_due_time() != std::chrono::system_clock::time_point::max();
+
+        if (res)
+        {
+            time_until = tasks.top().time_until_expiry(clock.now());
+        }
+
+        tasks.release_queue();
+
+        return res;
+    }
+
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
+    std::chrono::system_clock::duration Cron<ClockType, LockType, QueueType, ObserverType>::time_until_next() const
     {
         std::chrono::system_clock::duration d{};
+        tasks.lock_queue();
+
         if (tasks.empty())
         {
             d = std::chrono::minutes(0); // std::numeric_limits<std::chrono::minutes>::max();
@@ -183,15 +1037,30 @@ namespace libcron
             d = tasks.top().time_until_expiry(clock.now());
         }
 
+        tasks.release_queue();
+
         return d;
     }
 
-    template<typename ClockType, typename LockType>
-    size_t Cron<ClockType, LockType>::tick(std::chrono::system_clock::time_point now)
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
+    size_t Cron<ClockType, LockType, QueueType, ObserverType>::tick(std::chrono::system_clock::time_point now)
     {
+        std::chrono::steady_clock::time_point started{};
+        std::chrono::steady_clock::time_point locked{};
+
+        if constexpr (ObserverType::enabled)
+        {
+            started = std::chrono::steady_clock::now();
+        }
+
         tasks.lock_queue();
         size_t res = 0;
 
+        if constexpr (ObserverType::enabled)
+        {
+            locked = std::chrono::steady_clock::now();
+        }
+
         if(!first_tick)
         {
             // Only allow time to flow if at least one second has passed since the last tick,
@@ -221,14 +1090,18 @@ namespace libcron
             auto diff = now - last_tick;
             auto absolute_diff = diff > diff.zero() ? diff : -diff;
 
-            if(absolute_diff >= three_hours)
+            if(absolute_diff >= three_hours && !(misfire.catch_up_large_jumps && diff > diff.zero()))
             {
                 // Time changes of more than 3 hours are considered to be corrections to the
                 // clock or timezone, and the new time is used immediately.
+                Task::NextScheduleMemos memos{};
+
                 for (auto& t : tasks.get_tasks())
                 {
-                    t.calculate_next(now);
+                    t.calculate_next(now, memos);
                 }
+
+                tasks.sort();
             }
             else
             {
@@ -243,59 +1116,179 @@ namespace libcron
 
         last_tick = now;
 
-        if (!tasks.empty())
+        std::vector<std::function<void()>> jobs;
+        bool dispatch = static_cast<bool>(executor);
+
+        auto run = [this, now, dispatch, &jobs](Task& t)
         {
-            for (size_t i = 0; i < tasks.size(); i++)
+            if (dispatch)
             {
-                if (tasks.at(i).is_expired(now))
+                std::function<void()> job;
+
+                if (t.dispatch(now, job))
                 {
-                    auto& t = tasks.at(i);
-                    t.execute(now);
+                    jobs.push_back(std::move(job));
 
-                    using namespace std::chrono_literals;
-                    if (!t.calculate_next(now + 1s))
+                    if constexpr (ObserverType::enabled)
                     {
-                        tasks.remove(t);
+                        observer.on_fire(t.get_name(), t.get_delay());
                     }
+                }
+            }
+            else if constexpr (ObserverType::enabled)
+            {
+                auto run_started = std::chrono::steady_clock::now();
 
-                    res++;
+                // For work deferring the end of its run, the time until it returned.
+                if (t.execute(now))
+                {
+                    observer.on_fire(t.get_name(), t.get_delay());
+                    observer.on_run(t.get_name(), std::chrono::steady_clock::now() - run_started);
                 }
             }
+            else
+            {
+                t.execute(now);
+            }
+        };
+
+        // Runs for missed schedules made, and moved to later seconds, in this tick.
+        size_t catch_up_runs = 0;
+        size_t postponed_runs = 0;
+
+        // Makes the runs for the missed schedules of the task, unless they are to be made later.
+        // Returns false if the task has been moved to a later time instead.
+        auto catch_up = [this, now, &run, &catch_up_runs, &postponed_runs](Task& t, size_t runs, bool spread)
+        {
+            using namespace std::chrono_literals;
+            bool res = true;
+            auto window = std::chrono::duration_cast<std::chrono::seconds>(misfire.spread);
 
-            // Only sort if at least one task was executed
-            if (res > 0)
+            if (runs == 0)
             {
-                tasks.sort();
+                // Skipped
+            }
+            else if (spread && window > 1s)
+            {
+                // The same offset each time, and on all platforms, so that the runs of a task that misses its
+                // schedule regularly don't wander through the window.
+                t.defer_catch_up(now + 1s + spread_of(t.get_name(), window), runs);
+                res = false;
+            }
+            else if (misfire.max_runs_per_tick > 0 && catch_up_runs + runs > misfire.max_runs_per_tick)
+            {
+                auto later = 1 + postponed_runs / misfire.max_runs_per_tick;
+                postponed_runs += runs;
+                t.defer_catch_up(now + std::chrono::seconds{ static_cast<int64_t>(later) }, runs);
+                res = false;
+            }
+            else
+            {
+                catch_up_runs += runs;
+                misfire_statistics.runs += runs;
+
+                for (size_t i = 0; i < runs; ++i)
+                {
+                    run(t);
+                }
             }
+
+            return res;
+        };
+
+        // Expired tasks sharing an expression usually follow each other, as with GroupedTaskQueue, so
+        // their next schedule is only calculated once.
+        Task::NextScheduleMemo memo{};
+
+        res = tasks.for_each_expired(now, [this, now, &run, &catch_up, &memo](Task& t)
+                                     {
+                                         using namespace std::chrono_literals;
+                                         bool ran = true;
+
+                                         if (t.get_catch_up_runs() > 0)
+                                         {
+                                             // Deferred earlier, may be postponed again due to max_runs_per_tick.
+                                             ran = catch_up(t, t.get_catch_up_runs(), false);
+                                         }
+                                         else if (now - t.get_next_schedule() >= misfire.threshold)
+                                         {
+                                             auto missed = t.count_missed(now, misfire.max_counted);
+                                             size_t runs = 1;
+
+                                             if (misfire.policy == MisfirePolicy::RunAll)
+                                             {
+                                                 runs = std::min(missed, misfire.max_catch_up);
+                                             }
+                                             else if (misfire.policy == MisfirePolicy::Skip)
+                                             {
+                                                 runs = 0;
+                                             }
+
+                                             ++misfire_statistics.misfired;
+                                             misfire_statistics.coalesced += missed > runs ? missed - runs : 0;
+                                             ran = catch_up(t, runs, true);
+                                         }
+                                         else
+                                         {
+                                             run(t);
+                                         }
+
+                                         // Tasks that can't be scheduled again are removed.
+                                         return !ran || t.calculate_next(now + 1s, memo);
+                                     });
+
+        size_t queued = 0;
+
+        if constexpr (ObserverType::enabled)
+        {
+            queued = tasks.size();
         }
 
         tasks.release_queue();
+
+        for (auto& job : jobs)
+        {
+            executor(std::move(job));
+        }
+
+        if constexpr (ObserverType::enabled)
+        {
+            observer.on_tick(locked - started, std::chrono::steady_clock::now() - started, queued, res);
+        }
+
         return res;
     }
 
-    template<typename ClockType, typename LockType>
-    void Cron<ClockType, LockType>::get_time_until_expiry_for_tasks(std::vector<std::tuple<std::string,
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
+    void Cron<ClockType, LockType, QueueType, ObserverType>::get_time_until_expiry_for_tasks(std::vector<std::tuple<std::string,
                                                           std::chrono::system_clock::duration>>& status) const
     {
         auto now = clock.now();
         status.clear();
+        tasks.lock_queue();
 
         std::for_each(tasks.get_tasks().cbegin(), tasks.get_tasks().cend(),
                       [&status, &now](const Task& t)
                       {
                           status.emplace_back(t.get_name(), t.time_until_expiry(now));
                       });
+
+        tasks.release_queue();
     }
 
-    template<typename ClockType, typename LockType>
-    std::ostream& operator<<(std::ostream& stream, const Cron<ClockType, LockType>& c)
+    template<typename ClockType, typename LockType, template<typename> class QueueType, typename ObserverType>
+    std::ostream& operator<<(std::ostream& stream, const Cron<ClockType, LockType, QueueType, ObserverType>& c)
     {
+        c.tasks.lock_queue();
+
         std::for_each(c.tasks.get_tasks().cbegin(), c.tasks.get_tasks().cend(),
                       [&stream, &c](const Task& t)
                       {
                           stream << t.get_status(c.clock.now()) << '\n';
                       });
 
+        c.tasks.release_queue();
+
         return stream;
     }
 }
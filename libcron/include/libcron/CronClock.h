@@ -1,6 +1,11 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include "TimeZone.h"
 
 namespace libcron
 {
@@ -39,4 +44,46 @@ namespace libcron
 
 			std::chrono::seconds utc_offset(std::chrono::system_clock::time_point now) const override;
     };
+
+    // Local time in a given time zone. Unlike LocalClock, which asks the operating system for the
+    // UTC offset on each call, the offset is cached until the next transition of the zone.
+    class ZonedClock
+            : public ICronClock
+    {
+        public:
+            // UTC until another zone is set
+            ZonedClock()
+                    : zone(TimeZone::utc())
+            {
+            }
+
+            explicit ZonedClock(std::shared_ptr<const TimeZone> zone)
+                    : zone(zone ? std::move(zone) : TimeZone::utc())
+            {
+            }
+
+            // Returns false, keeping the current zone, if there is no such zone. Not to be called
+            // while other threads use the clock.
+            bool set_time_zone(const std::string& name);
+
+            void set_time_zone(std::shared_ptr<const TimeZone> new_zone);
+
+            const std::shared_ptr<const TimeZone>& get_time_zone() const
+            {
+                return zone;
+            }
+
+            std::chrono::system_clock::time_point now() const override
+            {
+                auto now = std::chrono::system_clock::now();
+                return now + utc_offset(now);
+            }
+
+            std::chrono::seconds utc_offset(std::chrono::system_clock::time_point now) const override;
+
+        private:
+            std::shared_ptr<const TimeZone> zone;
+            // The period of the zone last looked up
+            mutable std::atomic<size_t> cached_period{ 0 };
+    };
 }
@@ -1,11 +1,12 @@
 #pragma once
 
-#include <set>
-#include <regex>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <libcron/TimeTypes.h>
+#include <libcron/CronField.h>
 
 namespace libcron
 {
@@ -15,10 +16,25 @@ namespace libcron
             static const int NUMBER_OF_LONG_MONTHS = 7;
             static const libcron::Months months_with_31[NUMBER_OF_LONG_MONTHS];
 
+            // Both look the expression up in CronDataCache::global(), parsing it only when it isn't cached.
             static CronData create(const std::string& cron_expression);
 
+            // The returned instance is shared by all users of the same expression.
+            static std::shared_ptr<const CronData> create_shared(const std::string& cron_expression);
+
             CronData() = default;
 
+            // Parses the expression without consulting the cache used by create().
+            explicit CronData(const std::string& cron_expression)
+            {
+                parse(cron_expression);
+            }
+
+            // Assembles the parsed fields of an expression, e.g. as stored by a Snapshot. The result is
+            // valid if each field allows a value and the days of the month exist in the allowed months.
+            CronData(CronField<Seconds> seconds, CronField<Minutes> minutes, CronField<Hours> hours,
+                     CronField<DayOfMonth> day_of_month, CronField<Months> months, CronField<DayOfWeek> day_of_week);
+
             CronData(const CronData&) = default;
 
             CronData& operator=(const CronData&) = default;
@@ -28,36 +44,53 @@ namespace libcron
                 return valid;
             }
 
-            const std::set<Seconds>& get_seconds() const
+            const CronField<Seconds>& get_seconds() const
             {
                 return seconds;
             }
 
-            const std::set<Minutes>& get_minutes() const
+            const CronField<Minutes>& get_minutes() const
             {
                 return minutes;
             }
 
-            const std::set<Hours>& get_hours() const
+            const CronField<Hours>& get_hours() const
             {
                 return hours;
             }
 
-            const std::set<DayOfMonth>& get_day_of_month() const
+            const CronField<DayOfMonth>& get_day_of_month() const
             {
                 return day_of_month;
             }
 
-            const std::set<Months>& get_months() const
+            const CronField<Months>& get_months() const
             {
                 return months;
             }
 
-            const std::set<DayOfWeek>& get_day_of_week() const
+            const CronField<DayOfWeek>& get_day_of_week() const
             {
                 return day_of_week;
             }
 
+            // True if both allow the same points in time, however the expressions were written.
+            bool operator==(const CronData& other) const
+            {
+                return valid == other.valid
+                       && seconds == other.seconds
+                       && minutes == other.minutes
+                       && hours == other.hours
+                       && day_of_month == other.day_of_month
+                       && months == other.months
+                       && day_of_week == other.day_of_week;
+            }
+
+            bool operator!=(const CronData& other) const
+            {
+                return !(*this == other);
+            }
+
             template<typename T>
             static uint8_t value_of(T t)
             {
@@ -65,143 +98,162 @@ namespace libcron
             }
 
             template<typename T>
-            static bool has_any_in_range(const std::set<T>& set, uint8_t low, uint8_t high)
+            static bool has_any_in_range(const CronField<T>& set, uint8_t low, uint8_t high)
             {
                 bool found = false;
 
                 for (auto i = low; !found && i <= high; ++i)
                 {
-                    found |= set.find(static_cast<T>(i)) != set.end();
+                    found |= set.contains(static_cast<T>(i));
                 }
 
                 return found;
             }
 
             template<typename T>
-            bool convert_from_string_range_to_number_range(const std::string& range, std::set<T>& numbers);
+            bool convert_from_string_range_to_number_range(std::string_view range, CronField<T>& numbers);
 
             template<typename T>
             static std::string& replace_string_name_with_numeric(std::string& s);
 
         private:
+            // Builds the values of the expression directly from its fields.
+            friend class CronRandomization;
+
             void parse(const std::string& cron_expression);
 
+            // The six fields of an expression, separated and with convenience schedules expanded.
+            void parse_fields(const std::string_view (&fields)[6]);
+
             template<typename T>
-            bool validate_numeric(const std::string& s, std::set<T>& numbers);
+            bool validate_numeric(std::string_view s, CronField<T>& numbers);
 
             template<typename T>
-            bool validate_literal(const std::string& s,
-                                  std::set<T>& numbers,
+            bool validate_literal(std::string_view s,
+                                  CronField<T>& numbers,
                                   const std::vector<std::string>& names);
 
             template<typename T>
-            bool process_parts(const std::vector<std::string>& parts, std::set<T>& numbers);
+            bool process_parts(std::string_view s, CronField<T>& numbers, const std::vector<std::string>* names);
 
             template<typename T>
-            bool add_number(std::set<T>& set, int32_t number);
+            bool add_number(CronField<T>& set, int32_t number);
 
             template<typename T>
             bool is_within_limits(int32_t low, int32_t high);
 
+            // True if the field allows a value and only values within the limits of T.
             template<typename T>
-            bool get_range(const std::string& s, T& low, T& high);
+            static bool is_within_limits(const CronField<T>& field);
 
             template<typename T>
-            bool get_step(const std::string& s, uint8_t& start, uint8_t& step);
+            bool get_range(std::string_view s, T& low, T& high);
+
+            template<typename T>
+            bool get_step(std::string_view s, uint8_t& start, uint8_t& step);
+
+            static std::string expand_convenience_schedules(std::string_view s);
+
+            static bool split_fields(std::string_view s, std::string_view (&fields)[6]);
 
-            std::vector<std::string> split(const std::string& s, char token);
+            static bool replace_names(std::string_view s,
+                                      const std::vector<std::string>& names,
+                                      int value_of_first_name,
+                                      std::string& replaced);
 
-            bool is_number(const std::string& s);
+            static bool is_number(std::string_view s);
+
+            static bool to_number(std::string_view s, int32_t& value);
+
+            static bool is_space(char c)
+            {
+                // Same set of characters as matched by \s in the ECMAScript grammar for the "C" locale.
+                return c == ' ' || (c >= '\t' && c <= '\r');
+            }
 
             bool is_between(int32_t value, int32_t low_limit, int32_t high_limit);
 
             bool validate_date_vs_months() const;
 
-            bool check_dom_vs_dow(const std::string& dom, const std::string& dow) const;
+            bool check_dom_vs_dow(std::string_view dom, std::string_view dow) const;
 
-            std::set<Seconds> seconds{};
-            std::set<Minutes> minutes{};
-            std::set<Hours> hours{};
-            std::set<DayOfMonth> day_of_month{};
-            std::set<Months> months{};
-            std::set<DayOfWeek> day_of_week{};
+            CronField<Seconds> seconds{};
+            CronField<Minutes> minutes{};
+            CronField<Hours> hours{};
+            CronField<DayOfMonth> day_of_month{};
+            CronField<Months> months{};
+            CronField<DayOfWeek> day_of_week{};
             bool valid = false;
 
             static const std::vector<std::string> month_names;
             static const std::vector<std::string> day_names;
-            static std::unordered_map<std::string, CronData> cache;
 
             template<typename T>
-            void add_full_range(std::set<T>& set);
+            void add_full_range(CronField<T>& set);
     };
 
     template<typename T>
-    bool CronData::validate_numeric(const std::string& s, std::set<T>& numbers)
+    bool CronData::validate_numeric(std::string_view s, CronField<T>& numbers)
     {
-        std::vector<std::string> parts = split(s, ',');
-
-        return process_parts(parts, numbers);
+        return process_parts(s, numbers, nullptr);
     }
 
     template<typename T>
-    bool CronData::validate_literal(const std::string& s,
-                                    std::set<T>& numbers,
+    bool CronData::validate_literal(std::string_view s,
+                                    CronField<T>& numbers,
                                     const std::vector<std::string>& names)
     {
-        std::vector<std::string> parts = split(s, ',');
+        return process_parts(s, numbers, &names);
+    }
 
-        auto value_of_first_name = value_of(T::First);
+    template<typename T>
+    bool CronData::process_parts(std::string_view s, CronField<T>& numbers, const std::vector<std::string>* names)
+    {
+        bool res = true;
+        std::string replaced;
+        size_t start = 0;
+        size_t end = 0;
 
-        // Replace each found name with the corresponding value.
-        for (const auto& name : names)
+        do
         {
-            std::regex m(name, std::regex_constants::ECMAScript | std::regex_constants::icase);
+            end = s.find(',', start);
+            auto part = s.substr(start, end == std::string_view::npos ? end : end - start);
 
-            for (auto& part : parts)
+            // A single empty part following the last ',' is not considered a part, i.e. "1," is the same as "1".
+            if (end != std::string_view::npos || !part.empty() || start == 0)
             {
-                std::string replaced;
-                std::regex_replace(std::back_inserter(replaced), part.begin(), part.end(), m,
-                                   std::to_string(value_of_first_name));
+                // Replace each found name with the corresponding value.
+                if (names != nullptr && replace_names(part, *names, value_of(T::First), replaced))
+                {
+                    part = replaced;
+                }
 
-                part = replaced;
+                res &= convert_from_string_range_to_number_range(part, numbers);
             }
 
-            value_of_first_name++;
-        }
-
-        return process_parts(parts, numbers);
-    }
-
-    template<typename T>
-    bool CronData::process_parts(const std::vector<std::string>& parts, std::set<T>& numbers)
-    {
-        bool res = true;
-
-        for (const auto& p : parts)
-        {
-            res &= convert_from_string_range_to_number_range(p, numbers);
+            start = end + 1;
         }
+        while (end != std::string_view::npos);
 
         return res;
     }
 
     template<typename T>
-    bool CronData::get_range(const std::string& s, T& low, T& high)
+    bool CronData::get_range(std::string_view s, T& low, T& high)
     {
         bool res = false;
 
-        auto value_range = R"#((\d+)-(\d+))#";
-
-        std::regex range(value_range, std::regex_constants::ECMAScript);
-
-        std::smatch match;
+        // <number>-<number>
+        auto dash = s.find('-');
 
-        if (std::regex_match(s.begin(), s.end(), match, range))
+        if (dash != std::string_view::npos)
         {
-            auto left = std::stoi(match[1].str());
-            auto right = std::stoi(match[2].str());
+            auto left_part = s.substr(0, dash);
+            auto right_part = s.substr(dash + 1);
+            int32_t left;
+            int32_t right;
 
-            if (is_within_limits<T>(left, right))
+            if (to_number(left_part, left) && to_number(right_part, right) && is_within_limits<T>(left, right))
             {
                 low = static_cast<T>(left);
                 high = static_cast<T>(right);
@@ -213,36 +265,29 @@ namespace libcron
     }
 
     template<typename T>
-    bool CronData::get_step(const std::string& s, uint8_t& start, uint8_t& step)
+    bool CronData::get_step(std::string_view s, uint8_t& start, uint8_t& step)
     {
         bool res = false;
 
-        auto value_range = R"#((\d+|\*)/(\d+))#";
+        // <number or *>/<number>
+        auto slash = s.find('/');
 
-        std::regex range(value_range, std::regex_constants::ECMAScript);
-
-        std::smatch match;
-
-        if (std::regex_match(s.begin(), s.end(), match, range))
+        if (slash != std::string_view::npos)
         {
-            int raw_start;
+            auto start_part = s.substr(0, slash);
+            auto step_part = s.substr(slash + 1);
+            int32_t raw_start = value_of(T::First);
+            int32_t raw_step;
 
-            if (match[1].str() == "*")
+            if ((start_part == "*" || to_number(start_part, raw_start)) && to_number(step_part, raw_step))
             {
-                raw_start = value_of(T::First);
-            }
-            else
-            {
-                raw_start = std::stoi(match[1].str());
-            }
-
-            auto raw_step = std::stoi(match[2].str());
-
-            if (is_within_limits<T>(raw_start, raw_start) && raw_step > 0)
-            {
-                start = static_cast<uint8_t>(raw_start);
-                step = static_cast<uint8_t>(raw_step);
-                res = true;
+                // A step that truncates to zero would never reach the end of the range.
+                if (is_within_limits<T>(raw_start, raw_start) && raw_step > 0 && static_cast<uint8_t>(raw_step) != 0)
+                {
+                    start = static_cast<uint8_t>(raw_start);
+                    step = static_cast<uint8_t>(raw_step);
+                    res = true;
+                }
             }
         }
 
@@ -250,24 +295,21 @@ namespace libcron
     }
 
     template<typename T>
-    void CronData::add_full_range(std::set<T>& set)
+    void CronData::add_full_range(CronField<T>& set)
     {
         for (auto v = value_of(T::First); v <= value_of(T::Last); ++v)
         {
-            if (set.find(static_cast<T>(v)) == set.end())
-            {
-                set.emplace(static_cast<T>(v));
-            }
+            set.emplace(static_cast<T>(v));
         }
     }
 
     template<typename T>
-    bool CronData::add_number(std::set<T>& set, int32_t number)
+    bool CronData::add_number(CronField<T>& set, int32_t number)
     {
         bool res = true;
 
         // Don't add if already there
-        if (set.find(static_cast<T>(number)) == set.end())
+        if (!set.contains(static_cast<T>(number)))
         {
             // Check range
             if (is_within_limits<T>(number, number))
@@ -291,8 +333,22 @@ namespace libcron
     }
 
     template<typename T>
-    bool CronData::convert_from_string_range_to_number_range(const std::string& range, std::set<T>& numbers)
+    bool CronData::is_within_limits(const CronField<T>& field)
+    {
+        bool res = !field.empty();
+
+        for (auto it = field.begin(); res && it != field.end(); ++it)
+        {
+            res = value_of(*it) >= value_of(T::First) && value_of(*it) <= value_of(T::Last);
+        }
+
+        return res;
+    }
+
+    template<typename T>
+    bool CronData::convert_from_string_range_to_number_range(std::string_view range, CronField<T>& numbers)
     {
+        int32_t number;
         T left;
         T right;
         uint8_t step_start;
@@ -305,9 +361,9 @@ namespace libcron
             // We treat the ignore-character '?' the same as the full range being allowed.
             add_full_range<T>(numbers);
         }
-        else if (is_number(range))
+        else if (to_number(range, number))
         {
-            res = add_number<T>(numbers, std::stoi(range));
+            res = add_number<T>(numbers, number);
         }
         else if (get_range<T>(range, left, right))
         {
@@ -371,17 +427,11 @@ namespace libcron
             name_source = &day_names;
         }
 
-        for (const auto& name : *name_source)
-        {
-            std::regex m(name, std::regex_constants::ECMAScript | std::regex_constants::icase);
-
-            std::string replaced;
-
-            std::regex_replace(std::back_inserter(replaced), s.begin(), s.end(), m, std::to_string(value));
+        std::string replaced;
 
+        if (replace_names(s, *name_source, value, replaced))
+        {
             s = replaced;
-
-            ++value;
         }
 
         return s;
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "libcron/CronData.h"
+
+namespace libcron
+{
+    // A bounded cache of parsed cron expressions, safe to use from multiple threads.
+    //
+    // The cache is split into shards, each with its own lock and least-recently-used order,
+    // so that threads parsing different expressions rarely contend. Entries are immutable and
+    // shared; evicting an entry only drops the cache's reference to it.
+    class CronDataCache
+    {
+        public:
+            static constexpr size_t number_of_shards = 16;
+            static constexpr size_t default_capacity = 4096;
+
+            struct Statistics
+            {
+                uint64_t hits;
+                uint64_t misses;
+                size_t size;
+            };
+
+            explicit CronDataCache(size_t capacity = default_capacity);
+
+            CronDataCache(const CronDataCache&) = delete;
+
+            CronDataCache& operator=(const CronDataCache&) = delete;
+
+            // The cache used by CronData::create().
+            static CronDataCache& global();
+
+            // Returns the parsed expression, parsing it on a miss. Invalid expressions are cached too.
+            std::shared_ptr<const CronData> get(const std::string& cron_expression);
+
+            // Returns an instance equal to data that is still in use, one returned by get() or intern(), or
+            // otherwise a copy of data that is kept track of in the same way. For expressions assembled from
+            // their fields, e.g. by a Snapshot, to be shared with the parsed ones. Instances are looked up by
+            // value only as long as someone holds them; with no capacity, data is always copied.
+            std::shared_ptr<const CronData> intern(const CronData& data);
+
+            Statistics get_statistics() const;
+
+            // The capacity is spread evenly over the shards, so at most 'capacity' rounded up to a
+            // multiple of number_of_shards entries are kept. Shrinking evicts entries as needed.
+            void set_capacity(size_t capacity);
+
+            // Removes all entries and resets the counters.
+            void clear();
+
+        private:
+            struct Shard
+            {
+                using Entry = std::pair<std::string, std::shared_ptr<const CronData>>;
+
+                mutable std::mutex lock{};
+                // Most recently used first
+                std::list<Entry> entries{};
+                // Keys refer to the strings in the entries
+                std::unordered_map<std::string_view, std::list<Entry>::iterator> index{};
+                size_t capacity = 0;
+
+                void evict();
+            };
+
+            struct ValueHash
+            {
+                size_t operator()(const CronData& data) const;
+            };
+
+            Shard& shard_of(const std::string& cron_expression);
+
+            // Adds the valid instance to the instances looked up by value, unless an equal one is still in use.
+            void remember(const std::shared_ptr<const CronData>& data);
+
+            Shard shards[number_of_shards];
+            // The instances handed out, by value. Expired ones are swept as the map grows, so that it holds
+            // about as many as are in use.
+            std::mutex values_lock{};
+            std::unordered_map<CronData, std::weak_ptr<const CronData>, ValueHash> values{};
+            size_t values_swept = 0;
+            std::atomic<bool> remembering{ true };
+            std::atomic<uint64_t> hits{ 0 };
+            std::atomic<uint64_t> misses{ 0 };
+    };
+}
@@ -0,0 +1,488 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include "libcron/CronData.h"
+#include "libcron/CronField.h"
+#include "libcron/TimeTypes.h"
+
+namespace libcron
+{
+    // A cron expression parsed at compile time, for schedules that are fixed in code:
+    //
+    //     constexpr CronExpression every_five_minutes{ "0 */5 * * * ?" };
+    //     static_assert(every_five_minutes.is_valid());
+    //
+    // The expression is parsed as CronData does, but without the CronDataCache. Expressions longer than
+    // max_length characters, after expanding convenience schedules such as @daily, are invalid.
+    // With C++20, cron_expr<"0 */5 * * * ?"> also rejects invalid expressions with a compile error.
+    class CronExpression
+    {
+        public:
+            static constexpr size_t max_length = 256;
+
+            constexpr explicit CronExpression(std::string_view cron_expression)
+            {
+                parse(cron_expression);
+            }
+
+            constexpr bool is_valid() const
+            {
+                return valid;
+            }
+
+            constexpr CronField<Seconds> get_seconds() const
+            {
+                return CronField<Seconds>{ seconds };
+            }
+
+            constexpr CronField<Minutes> get_minutes() const
+            {
+                return CronField<Minutes>{ minutes };
+            }
+
+            constexpr CronField<Hours> get_hours() const
+            {
+                return CronField<Hours>{ static_cast<uint32_t>(hours) };
+            }
+
+            constexpr CronField<DayOfMonth> get_day_of_month() const
+            {
+                return CronField<DayOfMonth>{ static_cast<uint32_t>(day_of_month) };
+            }
+
+            constexpr CronField<Months> get_months() const
+            {
+                return CronField<Months>{ static_cast<uint16_t>(months) };
+            }
+
+            constexpr CronField<DayOfWeek> get_day_of_week() const
+            {
+                return CronField<DayOfWeek>{ static_cast<uint8_t>(day_of_week) };
+            }
+
+            // The same as CronData::create() of the expression, without parsing it again.
+            CronData to_data() const
+            {
+                return CronData{ get_seconds(), get_minutes(), get_hours(), get_day_of_month(), get_months(), get_day_of_week() };
+            }
+
+        private:
+            // The limits of a field and the names that may be used for its values.
+            struct Field
+            {
+                int32_t first;
+                int32_t last;
+                int width;
+                const std::string_view* names;
+                int32_t name_count;
+            };
+
+            // A string of at most max_length characters, as std::string can't be used in constant expressions.
+            struct Text
+            {
+                char data[max_length]{};
+                size_t size = 0;
+                bool overflow = false;
+
+                constexpr void append(char c)
+                {
+                    if (size < max_length)
+                    {
+                        data[size++] = c;
+                    }
+                    else
+                    {
+                        overflow = true;
+                    }
+                }
+
+                constexpr void append(std::string_view s)
+                {
+                    for (auto c : s)
+                    {
+                        append(c);
+                    }
+                }
+
+                constexpr std::string_view view() const
+                {
+                    return std::string_view{ data, size };
+                }
+            };
+
+            static constexpr std::string_view month_names[]{ "JAN", "FEB", "MAR", "APR", "MAY", "JUN", "JUL", "AUG", "SEP", "OCT", "NOV", "DEC" };
+            static constexpr std::string_view day_names[]{ "SUN", "MON", "TUE", "WED", "THU", "FRI", "SAT" };
+
+            constexpr void parse(std::string_view expression)
+            {
+                Text expanded{};
+                bool res = true;
+
+                if (expression.find('@') != std::string_view::npos)
+                {
+                    expand_convenience_schedules(expression, expanded);
+                    expression = expanded.view();
+                    res = !expanded.overflow;
+                }
+
+                std::string_view fields[6]{};
+                res = res && split_fields(expression, fields);
+
+                if (res)
+                {
+                    res = process_parts(fields[0], Field{ 0, 59, 64, nullptr, 0 }, seconds);
+                    res &= process_parts(fields[1], Field{ 0, 59, 64, nullptr, 0 }, minutes);
+                    res &= process_parts(fields[2], Field{ 0, 23, 32, nullptr, 0 }, hours);
+                    res &= process_parts(fields[3], Field{ 1, 31, 32, nullptr, 0 }, day_of_month);
+                    res &= process_parts(fields[4], Field{ 1, 12, 16, month_names, 12 }, months);
+                    res &= process_parts(fields[5], Field{ 0, 6, 8, day_names, 7 }, day_of_week);
+                    res &= check_dom_vs_dow(fields[3], fields[5]);
+                    res &= validate_date_vs_months();
+                }
+
+                valid = res;
+            }
+
+            static constexpr void expand_convenience_schedules(std::string_view s, Text& expanded)
+            {
+                constexpr std::string_view tokens[]{ "@yearly", "@annually", "@monthly", "@weekly", "@daily", "@hourly" };
+                constexpr std::string_view replacements[]{ "0 0 1 1 *", "0 0 1 1 *", "0 0 1 * *", "0 0 * * 0", "0 0 * * *", "0 * * * *" };
+
+                for (size_t i = 0; i < s.size();)
+                {
+                    bool replaced = false;
+
+                    if (s[i] == '@')
+                    {
+                        for (size_t t = 0; !replaced && t < 6; ++t)
+                        {
+                            if (s.compare(i, tokens[t].size(), tokens[t]) == 0)
+                            {
+                                expanded.append(replacements[t]);
+                                i += tokens[t].size();
+                                replaced = true;
+                            }
+                        }
+                    }
+
+                    if (!replaced)
+                    {
+                        expanded.append(s[i++]);
+                    }
+                }
+            }
+
+            static constexpr bool is_space(char c)
+            {
+                return c == ' ' || (c >= '\t' && c <= '\r');
+            }
+
+            static constexpr bool split_fields(std::string_view s, std::string_view (&fields)[6])
+            {
+                size_t count = 0;
+                size_t i = 0;
+
+                while (count <= 6 && i < s.size())
+                {
+                    while (i < s.size() && is_space(s[i]))
+                    {
+                        ++i;
+                    }
+
+                    auto start = i;
+
+                    while (i < s.size() && !is_space(s[i]))
+                    {
+                        ++i;
+                    }
+
+                    if (i > start)
+                    {
+                        if (count < 6)
+                        {
+                            fields[count] = s.substr(start, i - start);
+                        }
+
+                        ++count;
+                    }
+                }
+
+                return count == 6;
+            }
+
+            static constexpr bool process_parts(std::string_view s, const Field& field, uint64_t& mask)
+            {
+                bool res = true;
+                size_t start = 0;
+                size_t end = 0;
+
+                do
+                {
+                    end = s.find(',', start);
+                    auto part = s.substr(start, end == std::string_view::npos ? end : end - start);
+
+                    // As with CronData, "1," is the same as "1".
+                    if (end != std::string_view::npos || !part.empty() || start == 0)
+                    {
+                        Text replaced{};
+
+                        if (field.names != nullptr && replace_names(part, field, replaced))
+                        {
+                            part = replaced.view();
+                            res &= !replaced.overflow;
+                        }
+
+                        res &= convert(part, field, mask);
+                    }
+
+                    start = end + 1;
+                }
+                while (end != std::string_view::npos);
+
+                return res;
+            }
+
+            static constexpr char to_upper(char c)
+            {
+                return c >= 'a' && c <= 'z' ? static_cast<char>(c - 'a' + 'A') : c;
+            }
+
+            static constexpr bool replace_names(std::string_view s, const Field& field, Text& replaced)
+            {
+                bool has_names = false;
+
+                for (auto c : s)
+                {
+                    has_names |= (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+                }
+
+                for (size_t i = 0; has_names && i < s.size();)
+                {
+                    bool found = false;
+
+                    for (int32_t n = 0; !found && n < field.name_count; ++n)
+                    {
+                        auto name = field.names[n];
+                        found = s.size() - i >= name.size();
+
+                        for (size_t k = 0; found && k < name.size(); ++k)
+                        {
+                            found = name[k] == to_upper(s[i + k]);
+                        }
+
+                        if (found)
+                        {
+                            auto value = field.first + n;
+
+                            if (value >= 10)
+                            {
+                                replaced.append(static_cast<char>('0' + value / 10));
+                            }
+
+                            replaced.append(static_cast<char>('0' + value % 10));
+                            i += name.size();
+                        }
+                    }
+
+                    if (!found)
+                    {
+                        replaced.append(s[i++]);
+                    }
+                }
+
+                return has_names;
+            }
+
+            static constexpr bool to_number(std::string_view s, int32_t& value)
+            {
+                bool res = !s.empty();
+                int64_t v = 0;
+
+                for (size_t i = 0; res && i < s.size(); ++i)
+                {
+                    res = s[i] >= '0' && s[i] <= '9';
+                    v = v * 10 + (s[i] - '0');
+                    res = res && v <= INT32_MAX;
+                }
+
+                if (res)
+                {
+                    value = static_cast<int32_t>(v);
+                }
+
+                return res;
+            }
+
+            static constexpr bool is_within_limits(const Field& field, int32_t value)
+            {
+                return value >= field.first && value <= field.last;
+            }
+
+            // As CronData::add_number(), values already allowed are accepted as is.
+            static constexpr bool add_number(const Field& field, int32_t number, uint64_t& mask)
+            {
+                auto v = static_cast<uint8_t>(number);
+                bool res = v < field.width && (mask & (uint64_t{ 1 } << v)) != 0;
+
+                if (!res && is_within_limits(field, number))
+                {
+                    mask |= uint64_t{ 1 } << number;
+                    res = true;
+                }
+
+                return res;
+            }
+
+            static constexpr bool convert(std::string_view range, const Field& field, uint64_t& mask)
+            {
+                int32_t number = 0;
+                int32_t left = 0;
+                int32_t right = 0;
+                bool res = true;
+
+                auto dash = range.find('-');
+                auto slash = range.find('/');
+
+                if (range == "*" || range == "?")
+                {
+                    for (auto v = field.first; v <= field.last; ++v)
+                    {
+                        mask |= uint64_t{ 1 } << v;
+                    }
+                }
+                else if (to_number(range, number))
+                {
+                    res = add_number(field, number, mask);
+                }
+                else if (dash != std::string_view::npos
+                         && to_number(range.substr(0, dash), left)
+                         && to_number(range.substr(dash + 1), right)
+                         && is_within_limits(field, left)
+                         && is_within_limits(field, right))
+                {
+                    // 22-1 wraps around, i.e. 22, 23, 0, 1 for hours.
+                    if (left <= right)
+                    {
+                        for (auto v = left; v <= right; ++v)
+                        {
+                            res &= add_number(field, v, mask);
+                        }
+                    }
+                    else
+                    {
+                        for (auto v = left; v <= field.last; ++v)
+                        {
+                            res = add_number(field, v, mask);
+                        }
+
+                        for (auto v = field.first; v <= right; ++v)
+                        {
+                            res = add_number(field, v, mask);
+                        }
+                    }
+                }
+                else if (slash != std::string_view::npos)
+                {
+                    auto start_part = range.substr(0, slash);
+                    int32_t start = field.first;
+                    int32_t step = 0;
+
+                    bool is_step = (start_part == "*" || to_number(start_part, start))
+                                   && to_number(range.substr(slash + 1), step)
+                                   && is_within_limits(field, start)
+                                   && step > 0
+                                   && static_cast<uint8_t>(step) != 0;
+                    res = is_step;
+
+                    // Counting in eight bits as CronData does, where large steps wrap around.
+                    for (auto v = static_cast<uint8_t>(start); is_step && v <= field.last; v = static_cast<uint8_t>(v + static_cast<uint8_t>(step)))
+                    {
+                        res = add_number(field, v, mask);
+                    }
+                }
+                else
+                {
+                    res = false;
+                }
+
+                return res;
+            }
+
+            static constexpr bool check_dom_vs_dow(std::string_view dom, std::string_view dow)
+            {
+                // See CronData::check_dom_vs_dow()
+                return dom == "?" || dow == "?"
+                       || (dom == "*" && dow != "*")
+                       || (dow == "*" && dom != "*");
+            }
+
+            constexpr bool validate_date_vs_months() const
+            {
+                bool res = true;
+
+                // Only February, so one of the days must be 29 or below.
+                if (months == uint64_t{ 1 } << 2)
+                {
+                    res = (day_of_month & 0x3FFFFFFE) != 0;
+                }
+
+                // Only the 31st, so one of the months must have that many days.
+                if (res && day_of_month == uint64_t{ 1 } << 31)
+                {
+                    constexpr uint64_t months_with_31 = (1 << 1) | (1 << 3) | (1 << 5) | (1 << 7) | (1 << 8) | (1 << 10) | (1 << 12);
+                    res = (months & months_with_31) != 0;
+                }
+
+                return res;
+            }
+
+            uint64_t seconds = 0;
+            uint64_t minutes = 0;
+            uint64_t hours = 0;
+            uint64_t day_of_month = 0;
+            uint64_t months = 0;
+            uint64_t day_of_week = 0;
+            bool valid = false;
+    };
+
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+    // The characters of a string literal, for use as a template argument.
+    template<size_t N>
+    struct FixedString
+    {
+        char value[N]{};
+
+        constexpr FixedString(const char (&s)[N])
+        {
+            for (size_t i = 0; i < N; ++i)
+            {
+                value[i] = s[i];
+            }
+        }
+
+        constexpr std::string_view view() const
+        {
+            return std::string_view{ value, N - 1 };
+        }
+    };
+
+    // An expression that is checked at compile time, e.g. cron.add_schedule("Task", cron_expr<"0 */5 * * * ?">::data(), work).
+    template<FixedString Expression>
+    struct cron_expr
+    {
+        static constexpr CronExpression expression{ Expression.view() };
+
+        static_assert(expression.is_valid(), "Invalid cron expression");
+
+        // Shared by all users of the expression, built from the bits parsed at compile time.
+        static const std::shared_ptr<const CronData>& data()
+        {
+            static const auto res = std::make_shared<const CronData>(expression.to_data());
+            return res;
+        }
+    };
+#endif
+}
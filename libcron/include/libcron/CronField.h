@@ -0,0 +1,305 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include "TimeTypes.h"
+
+namespace libcron
+{
+    template<typename T>
+    struct CronFieldTraits;
+
+    template<>
+    struct CronFieldTraits<Seconds>
+    {
+        using word_type = uint64_t;
+    };
+
+    template<>
+    struct CronFieldTraits<Minutes>
+    {
+        using word_type = uint64_t;
+    };
+
+    template<>
+    struct CronFieldTraits<Hours>
+    {
+        using word_type = uint32_t;
+    };
+
+    template<>
+    struct CronFieldTraits<DayOfMonth>
+    {
+        using word_type = uint32_t;
+    };
+
+    template<>
+    struct CronFieldTraits<Months>
+    {
+        using word_type = uint16_t;
+    };
+
+    template<>
+    struct CronFieldTraits<DayOfWeek>
+    {
+        using word_type = uint8_t;
+    };
+
+    namespace bits
+    {
+        inline int count(uint64_t word)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            return __builtin_popcountll(word);
+#else
+            int res = 0;
+
+            for (; word != 0; word &= word - 1)
+            {
+                ++res;
+            }
+
+            return res;
+#endif
+        }
+
+        // Index of the lowest set bit. The word must not be zero.
+        inline int lowest(uint64_t word)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            return __builtin_ctzll(word);
+#else
+            int res = 0;
+
+            for (; (word & 1) == 0; word >>= 1)
+            {
+                ++res;
+            }
+
+            return res;
+#endif
+        }
+
+        // Index of the highest set bit. The word must not be zero.
+        inline int highest(uint64_t word)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            return 63 - __builtin_clzll(word);
+#else
+            int res = 0;
+
+            while ((word >>= 1) != 0)
+            {
+                ++res;
+            }
+
+            return res;
+#endif
+        }
+    }
+
+    // The allowed values of one field in a cron expression, stored as a bitmask where
+    // bit n is set when the value n is allowed. The interface mimics the parts of
+    // std::set that are relevant for a set of small integers.
+    template<typename T>
+    class CronField
+    {
+        public:
+            using word_type = typename CronFieldTraits<T>::word_type;
+            using value_type = T;
+            using size_type = size_t;
+
+            static constexpr int width = static_cast<int>(sizeof(word_type) * 8);
+
+            class const_iterator
+            {
+                public:
+                    using iterator_category = std::forward_iterator_tag;
+                    using value_type = T;
+                    using difference_type = std::ptrdiff_t;
+                    using pointer = const T*;
+                    using reference = T;
+
+                    const_iterator() = default;
+
+                    explicit const_iterator(word_type remaining)
+                            : remaining(remaining)
+                    {
+                    }
+
+                    T operator*() const
+                    {
+                        return static_cast<T>(bits::lowest(remaining));
+                    }
+
+                    const_iterator& operator++()
+                    {
+                        remaining = static_cast<word_type>(remaining & (remaining - 1));
+                        return *this;
+                    }
+
+                    const_iterator operator++(int)
+                    {
+                        auto res = *this;
+                        ++(*this);
+                        return res;
+                    }
+
+                    bool operator==(const const_iterator& other) const
+                    {
+                        return remaining == other.remaining;
+                    }
+
+                    bool operator!=(const const_iterator& other) const
+                    {
+                        return remaining != other.remaining;
+                    }
+
+                private:
+                    // The values not yet visited, the lowest bit being the current one.
+                    word_type remaining = 0;
+            };
+
+            using iterator = const_iterator;
+
+            CronField() = default;
+
+            explicit constexpr CronField(word_type bits)
+                    : word(bits)
+            {
+            }
+
+            const_iterator begin() const
+            {
+                return const_iterator{ word };
+            }
+
+            const_iterator end() const
+            {
+                return const_iterator{};
+            }
+
+            size_t size() const
+            {
+                return static_cast<size_t>(bits::count(word));
+            }
+
+            bool empty() const
+            {
+                return word == 0;
+            }
+
+            bool contains(T value) const
+            {
+                auto v = static_cast<uint8_t>(value);
+                return v < width && (word & bit(v)) != 0;
+            }
+
+            size_t count(T value) const
+            {
+                return contains(value) ? 1 : 0;
+            }
+
+            const_iterator find(T value) const
+            {
+                auto v = static_cast<uint8_t>(value);
+                // All values below the one searched for are excluded from the returned iterator.
+                return contains(value) ? const_iterator{ static_cast<word_type>(word & ~(bit(v) - 1)) } : end();
+            }
+
+            std::pair<iterator, bool> emplace(T value)
+            {
+                bool inserted = !contains(value);
+
+                if (inserted)
+                {
+                    word = static_cast<word_type>(word | bit(static_cast<uint8_t>(value)));
+                }
+
+                return { find(value), inserted };
+            }
+
+            std::pair<iterator, bool> insert(T value)
+            {
+                return emplace(value);
+            }
+
+            iterator erase(const_iterator pos)
+            {
+                auto value = *pos;
+                word = static_cast<word_type>(word & ~bit(static_cast<uint8_t>(value)));
+                return ++pos;
+            }
+
+            size_t erase(T value)
+            {
+                auto res = count(value);
+                word = static_cast<word_type>(word & ~(res != 0 ? bit(static_cast<uint8_t>(value)) : 0));
+                return res;
+            }
+
+            void clear()
+            {
+                word = 0;
+            }
+
+            // Finds the lowest allowed value that is >= from.
+            bool find_next(uint8_t from, uint8_t& next) const
+            {
+                bool res = false;
+
+                if (from < width)
+                {
+                    auto remaining = static_cast<word_type>(word & ~(bit(from) - 1));
+
+                    if (remaining != 0)
+                    {
+                        next = static_cast<uint8_t>(bits::lowest(remaining));
+                        res = true;
+                    }
+                }
+
+                return res;
+            }
+
+            // Finds the highest allowed value that is <= from.
+            bool find_previous(uint8_t from, uint8_t& previous) const
+            {
+                bool res = false;
+                auto remaining = from < width - 1 ? static_cast<word_type>(word & (bit(static_cast<uint8_t>(from + 1)) - 1)) : word;
+
+                if (remaining != 0)
+                {
+                    previous = static_cast<uint8_t>(bits::highest(remaining));
+                    res = true;
+                }
+
+                return res;
+            }
+
+            constexpr word_type get_bits() const
+            {
+                return word;
+            }
+
+            bool operator==(const CronField& other) const
+            {
+                return word == other.word;
+            }
+
+            bool operator!=(const CronField& other) const
+            {
+                return word != other.word;
+            }
+
+        private:
+            static constexpr word_type bit(uint8_t value)
+            {
+                return static_cast<word_type>(word_type{ 1 } << value);
+            }
+
+            word_type word = 0;
+    };
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+
+namespace libcron
+{
+    // The observer of a Cron instance is told what each tick did, see Cron's ObserverType.
+    // An observer provides the same members as NullObserver; the calls are only made, and the
+    // time taken only measured, when its 'enabled' is true. They are made from the ticking
+    // thread, with the queue locked except for on_tick().
+    class NullObserver
+    {
+        public:
+            static constexpr bool enabled = false;
+
+            // After each tick. lock_wait is the time spent waiting for the queue, duration the time
+            // of the whole tick including lock_wait, tasks the number of tasks in the queue and expired
+            // the number returned by tick().
+            void on_tick(std::chrono::steady_clock::duration /*lock_wait*/,
+                         std::chrono::steady_clock::duration /*duration*/,
+                         size_t /*tasks*/,
+                         size_t /*expired*/)
+            {
+            }
+
+            // A task was run or dispatched to the executor, 'delay' after it was scheduled.
+            void on_fire(std::string_view /*name*/, std::chrono::system_clock::duration /*delay*/)
+            {
+            }
+
+            // A task run by tick() itself has finished. Not called for tasks run through an executor.
+            void on_run(std::string_view /*name*/, std::chrono::steady_clock::duration /*run_time*/)
+            {
+            }
+    };
+
+    // An observer keeping totals in atomic counters, so that they can be read from any thread,
+    // e.g. by a metrics exporter, while the Cron instance ticks.
+    class CronMetrics
+    {
+        public:
+            static constexpr bool enabled = true;
+
+            // Upper bounds of the buckets of the fire delay histogram, the last bucket holds the rest.
+            static constexpr std::chrono::microseconds delay_bounds[]{
+                    std::chrono::milliseconds{ 1 }, std::chrono::milliseconds{ 10 }, std::chrono::milliseconds{ 100 },
+                    std::chrono::seconds{ 1 }, std::chrono::seconds{ 10 }, std::chrono::seconds{ 60 }
+            };
+            static constexpr size_t delay_buckets = std::size(delay_bounds) + 1;
+
+            struct Values
+            {
+                uint64_t ticks;
+                std::chrono::nanoseconds tick_time;
+                std::chrono::nanoseconds longest_tick;
+                std::chrono::nanoseconds lock_wait;
+                // The sum of the tasks in the queue over all ticks
+                uint64_t tasks_scanned;
+                uint64_t expired;
+                uint64_t fired;
+                // Fires per delay, not cumulative; bucket i counts delays up to delay_bounds[i]
+                uint64_t delays[delay_buckets];
+                uint64_t runs;
+                std::chrono::nanoseconds run_time;
+                // Of CronDataCache::global(), shared by all instances
+                uint64_t cache_hits;
+                uint64_t cache_misses;
+            };
+
+            void on_tick(std::chrono::steady_clock::duration lock_wait,
+                         std::chrono::steady_clock::duration duration,
+                         size_t tasks,
+                         size_t expired);
+
+            void on_fire(std::string_view name, std::chrono::system_clock::duration delay);
+
+            void on_run(std::string_view name, std::chrono::steady_clock::duration run_time);
+
+            // The totals since creation or the last reset(), which leaves the cache counters as they are.
+            // Each counter is read on its own, so values read during a tick may be from slightly
+            // different points in time.
+            Values get() const;
+
+            void reset();
+
+        private:
+            std::atomic<uint64_t> ticks{ 0 };
+            std::atomic<int64_t> tick_time{ 0 };
+            std::atomic<int64_t> longest_tick{ 0 };
+            std::atomic<int64_t> lock_wait{ 0 };
+            std::atomic<uint64_t> tasks_scanned{ 0 };
+            std::atomic<uint64_t> expired{ 0 };
+            std::atomic<uint64_t> fired{ 0 };
+            std::atomic<uint64_t> delays[delay_buckets]{};
+            std::atomic<uint64_t> runs{ 0 };
+            std::atomic<int64_t> run_time{ 0 };
+    };
+}
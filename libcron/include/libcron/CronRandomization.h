@@ -1,100 +1,64 @@
 #pragma once
 
+#include <cstdint>
 #include <tuple>
 #include <random>
-#include <regex>
-#include <functional>
+#include <string>
+#include <string_view>
 #include "CronData.h"
 
 namespace libcron
 {
+    // Expressions with random ranges, R(<low>-<high>), in place of single values. Each random range
+    // is replaced with a value picked from it.
     class CronRandomization
     {
         public:
             std::tuple<bool, std::string> parse(const std::string& cron_schedule);
 
+            // As parse(), but producing the parsed expression instead of a string to parse. Check is_valid().
+            CronData create(const std::string& cron_schedule);
+
+            // Picks the values by a hash of the seed and the key, e.g. the name of a task, instead of from a
+            // random sequence. The same seed, key and expression always give the same schedule, on all platforms.
+            static CronData create(const std::string& cron_schedule, uint64_t seed, std::string_view key);
+
+            // Seeded from std::random_device.
             CronRandomization();
 
+            // The same seed gives the same sequence of schedules, with the same standard library.
+            explicit CronRandomization(uint32_t seed);
+
             CronRandomization(const CronRandomization&) = delete;
 
             CronRandomization & operator=(const CronRandomization &) = delete;
 
         private:
-            template<typename T>
-            std::pair<bool, std::string> get_random_in_range(const std::string& section,
-                                                             int& selected_value,
-                                                             std::pair<int, int> limit = std::make_pair(-1, -1));
-
-            std::pair<int, int> day_limiter(const std::set<Months>& month);
-
-            int cap(int value, int lower, int upper);
+            // A section of an expression, with names of months and days replaced by their numbers
+            // and a random range by the value picked from it.
+            struct Section
+            {
+                std::string text{};
+                bool random = false;
+                int value = -1;
+            };
 
-            std::regex const rand_expression{ R"#([rR]\((\d+)\-(\d+)\))#", std::regex_constants::ECMAScript };
-            std::random_device rd{};
-            std::mt19937 twister;
-    };
+            using Sections = Section[6];
 
-    template<typename T>
-    std::pair<bool, std::string> CronRandomization::get_random_in_range(const std::string& section,
-                                                                        int& selected_value,
-                                                                        std::pair<int, int> limit)
-    {
-        auto res = std::make_pair(true, std::string{});
-        selected_value = -1;
+            // pick(n) returns a value in [0, n).
+            template<typename Pick>
+            static bool randomize(const std::string& cron_schedule, Pick&& pick, Sections& sections);
 
-        std::smatch random_match;
+            template<typename T, typename Pick>
+            static bool get_random_in_range(Section& section, Pick&& pick,
+                                            std::pair<int, int> limit = std::make_pair(-1, -1));
 
-        if (std::regex_match(section.cbegin(), section.cend(), random_match, rand_expression))
-        {
-            // Random range, get left and right numbers.
-            auto left = std::stoi(random_match[1].str());
-            auto right = std::stoi(random_match[2].str());
+            static CronData to_data(const Sections& sections);
 
-            if (limit.first != -1 && limit.second != -1)
-            {
-                left = cap(left, limit.first, limit.second);
-                right = cap(right, limit.first, limit.second);
-            }
+            static std::pair<int, int> day_limiter(const CronField<Months>& month);
 
-            libcron::CronData cd;
-            std::set<T> numbers;
-            res.first = cd.convert_from_string_range_to_number_range<T>(
-                    std::to_string(left) + "-" + std::to_string(right), numbers);
+            static int cap(int value, int lower, int upper);
 
-            // Remove items outside limits.
-            if (limit.first != -1 && limit.second != -1)
-            {
-                for (auto it = numbers.begin(); it != numbers.end(); )
-                {
-                    if (CronData::value_of(*it) < limit.first || CronData::value_of(*it) > limit.second)
-                    {
-                        it = numbers.erase(it);
-                    }
-                    else
-                    {
-                        ++it;
-                    }
-                }
-            }
-
-            if (res.first)
-            {
-                // Generate random indexes to select one of the numbers in the range.
-                std::uniform_int_distribution<> dis(0, static_cast<int>(numbers.size() - 1));
-
-                // Select the random number to use as the schedule
-                auto it = numbers.begin();
-                std::advance(it, dis(twister));
-                selected_value = CronData::value_of(*it);
-                res.second = std::to_string(selected_value);
-            }
-        }
-        else
-        {
-            // Not random, just append input to output.
-            res.second = section;
-        }
-
-        return res;
-    }
+            std::mt19937 twister;
+    };
 }
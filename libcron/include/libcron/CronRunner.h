@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace libcron
+{
+    // Calls tick() on a Cron instance whenever a task expires, sleeping in between
+    // instead of polling. The Cron instance must use libcron::Locker if tasks are added
+    // or removed from other threads than the one calling run().
+    //
+    // run() wakes up early when tasks are added, removed or rescheduled, and when the clock
+    // of the Cron instance changes. The latter is noticed by comparing how far it and the
+    // steady clock have moved every clock_check while sleeping, so once the clock has jumped
+    // the tasks that are due are run, and the time until the next one is looked at again,
+    // within about clock_check. Call notify() to have a change noticed right away.
+    template<typename CronType>
+    class CronRunner
+    {
+        public:
+            static constexpr std::chrono::seconds default_max_sleep{ 60 };
+            static constexpr std::chrono::seconds default_clock_check{ 1 };
+
+            explicit CronRunner(CronType& cron, std::chrono::steady_clock::duration max_sleep = default_max_sleep,
+                                std::chrono::steady_clock::duration clock_check = default_clock_check)
+                    : cron(cron), max_sleep(max_sleep), clock_check(clock_check)
+            {
+                cron.set_change_listener([this]()
+                                         {
+                                             notify();
+                                         });
+            }
+
+            ~CronRunner()
+            {
+                cron.set_change_listener({});
+            }
+
+            CronRunner(const CronRunner&) = delete;
+
+            CronRunner& operator=(const CronRunner&) = delete;
+
+            // Blocks until stop() is called.
+            void run()
+            {
+                std::unique_lock<std::mutex> guard{ lock };
+
+                while (!stopping)
+                {
+                    // Changes from here on must be looked at before sleeping.
+                    changed = false;
+                    guard.unlock();
+
+                    cron.tick();
+                    auto last_tick = std::chrono::steady_clock::now();
+                    auto last_time = cron.get_clock().now();
+
+                    std::chrono::system_clock::duration time_until{};
+                    auto sleep = cron.time_until_next(time_until)
+                                 ? std::min<std::chrono::steady_clock::duration>(
+                                         std::chrono::duration_cast<std::chrono::steady_clock::duration>(time_until),
+                                         max_sleep)
+                                 : max_sleep;
+
+                    // Cron::tick() lets time flow in steps of at least one second, ticking sooner is futile.
+                    auto wake_up = std::max(last_tick + sleep, last_tick + std::chrono::seconds{ 1 });
+
+                    guard.lock();
+                    bool woken = false;
+
+                    while (!woken)
+                    {
+                        auto until = std::min(wake_up, std::chrono::steady_clock::now() + clock_check);
+
+                        woken = wakeups.wait_until(guard, until, [this]()
+                        {
+                            return stopping || changed;
+                        }) || until == wake_up || clock_changed(last_tick, last_time);
+                    }
+                }
+
+                stopping = false;
+            }
+
+            // Makes run() return. May be called from any thread, including from within a task.
+            void stop()
+            {
+                {
+                    std::lock_guard<std::mutex> guard{ lock };
+                    stopping = true;
+                }
+
+                wakeups.notify_all();
+            }
+
+            // Makes run() look at the time until the next task again, e.g. after changing the clock.
+            void notify()
+            {
+                {
+                    std::lock_guard<std::mutex> guard{ lock };
+                    changed = true;
+                }
+
+                wakeups.notify_all();
+            }
+
+        private:
+            // True if the clock of the Cron instance has moved at least a second more or less than the steady clock.
+            bool clock_changed(std::chrono::steady_clock::time_point last_tick,
+                               std::chrono::system_clock::time_point last_time) const
+            {
+                auto elapsed = std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                        std::chrono::steady_clock::now() - last_tick);
+                auto drift = cron.get_clock().now() - last_time - elapsed;
+
+                return drift >= std::chrono::seconds{ 1 } || drift <= -std::chrono::seconds{ 1 };
+            }
+
+            CronType& cron;
+            std::chrono::steady_clock::duration max_sleep;
+            std::chrono::steady_clock::duration clock_check;
+            std::mutex lock{};
+            std::condition_variable wakeups{};
+            bool stopping = false;
+            bool changed = false;
+    };
+}
@@ -2,13 +2,16 @@
 
 #include "libcron/CronData.h"
 #include <chrono>
+#include <cstddef>
+#include <iterator>
+#include <memory>
 
 #if defined(_MSC_VER)
 #pragma warning(push)
 #pragma warning(disable:4244)
 #endif
 
-#ifdef __cplusplus > 201703L
+#if __cplusplus > 201703L
 #else
 #include <date/date.h>
 #endif
@@ -18,14 +21,21 @@
 #endif
 
 #include "libcron/DateTime.h"
+#include "libcron/TimeZone.h"
 
 namespace libcron
 {
     class CronSchedule
     {
         public:
-            explicit CronSchedule(CronData& data)
-                    : data(data)
+            explicit CronSchedule(const CronData& data)
+                    : data(std::make_shared<const CronData>(data))
+            {
+            }
+
+            // Shares the parsed expression, see CronData::create_shared().
+            explicit CronSchedule(std::shared_ptr<const CronData> data)
+                    : data(std::move(data))
             {
             }
 
@@ -33,13 +43,122 @@ namespace libcron
 
             CronSchedule& operator=(const CronSchedule&) = default;
 
+            // Schedules created from the same shared CronData have the same data.
+            const std::shared_ptr<const CronData>& get_data() const
+            {
+                return data;
+            }
+
             std::tuple<bool, std::chrono::system_clock::time_point>
             calculate_from(const std::chrono::system_clock::time_point& from) const;
 
+            // As above, but with the schedule in the local time of the zone while from and the calculated
+            // schedule are in UTC. See TimeZone for how schedules around its transitions are handled. Schedules
+            // within local times that occur twice, as when daylight saving time ends, only happen the first time.
+            std::tuple<bool, std::chrono::system_clock::time_point>
+            calculate_from(const std::chrono::system_clock::time_point& from, const TimeZone& zone) const;
+
+            // Calculates the last schedule before, not at, the given point in time.
+            std::tuple<bool, std::chrono::system_clock::time_point>
+            calculate_previous(const std::chrono::system_clock::time_point& from) const;
+
+            // Iterates over the schedules from one point in time to the next, continuing where the
+            // previous schedule was found instead of starting over as calculate_from() does.
+            // The iterator refers to the CronSchedule, which must outlive it.
+            class occurrence_iterator
+            {
+                public:
+                    using iterator_category = std::forward_iterator_tag;
+                    using value_type = std::chrono::system_clock::time_point;
+                    using difference_type = std::ptrdiff_t;
+                    using pointer = const value_type*;
+                    using reference = const value_type&;
+
+                    // The end iterator
+                    occurrence_iterator() = default;
+
+                    occurrence_iterator(const CronSchedule& schedule,
+                                        std::chrono::system_clock::time_point from,
+                                        std::chrono::system_clock::time_point to);
+
+                    reference operator*() const
+                    {
+                        return current;
+                    }
+
+                    pointer operator->() const
+                    {
+                        return &current;
+                    }
+
+                    occurrence_iterator& operator++();
+
+                    occurrence_iterator operator++(int)
+                    {
+                        auto res = *this;
+                        ++(*this);
+                        return res;
+                    }
+
+                    bool operator==(const occurrence_iterator& other) const
+                    {
+                        return schedule == other.schedule && (schedule == nullptr || current == other.current);
+                    }
+
+                    bool operator!=(const occurrence_iterator& other) const
+                    {
+                        return !(*this == other);
+                    }
+
+                private:
+                    void find_next();
+
+                    // nullptr once past the end
+                    const CronSchedule* schedule = nullptr;
+                    DateTime position{};
+                    std::chrono::system_clock::time_point current{};
+                    std::chrono::system_clock::time_point to{};
+            };
+
+            class occurrence_range
+            {
+                public:
+                    occurrence_range(occurrence_iterator first)
+                            : first(first)
+                    {
+                    }
+
+                    occurrence_iterator begin() const
+                    {
+                        return first;
+                    }
+
+                    occurrence_iterator end() const
+                    {
+                        return occurrence_iterator{};
+                    }
+
+                private:
+                    occurrence_iterator first;
+            };
+
+            // The schedules in [from, to), for use in a range-based for loop.
+            occurrence_range occurrences(std::chrono::system_clock::time_point from,
+                                         std::chrono::system_clock::time_point to) const
+            {
+                return occurrence_range{ occurrence_iterator{ *this, from, to } };
+            }
+
+            // Fills out with up to count schedules, the first being at or after from.
+            // Returns the number of schedules written, which is less than count only if the schedule ends.
+            size_t next_n(std::chrono::system_clock::time_point from,
+                          std::chrono::system_clock::time_point* out,
+                          size_t count) const;
+
             // https://github.com/HowardHinnant/date/wiki/Examples-and-Recipes#obtaining-ymd-hms-components-from-a-time_point
             static DateTime to_calendar_time(std::chrono::system_clock::time_point time)
             {
-#ifdef __cplusplus > 201703L
+#if __cplusplus > 201703L
                 auto daypoint = std::chrono::floor<std::chrono::days>(time);
                 auto ymd = std::chrono::year_month_day(daypoint);   // calendar date
                 auto time_of_day = std::chrono::hh_mm_ss(time - daypoint);
@@ -61,7 +180,22 @@ namespace libcron
             }
 
         private:
-            CronData data;
+            // Moves the position forward to the first allowed point in time, returns false if there is none.
+            // The position doesn't have to be a valid point in time; out-of-range fields carry over.
+            bool find_from(DateTime& position) const;
+
+            // As find_from(), but moves the position backward to the last allowed point in time.
+            bool find_previous_from(DateTime& position) const;
+
+            static std::chrono::system_clock::time_point to_time_point(const DateTime& position);
+
+            // Finds the first allowed day in the given month that is >= from_day.
+            bool find_day(int in_year, uint8_t in_month, uint8_t from_day, uint8_t& allowed_day) const;
+
+            // Finds the last allowed day in the given month that is <= from_day, which may be past the end of the month.
+            bool find_previous_day(int in_year, uint8_t in_month, uint8_t from_day, uint8_t& allowed_day) const;
+
+            std::shared_ptr<const CronData> data;
     };
 
 }
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace libcron
+{
+    template<typename Signature>
+    class FunctionRef;
+
+    // A non-owning reference to a callable, which must outlive it.
+    //
+    // Being the size of two pointers, it fits within the small buffer of std::function,
+    // so passing one as the work of a task avoids allocating a copy of the callable:
+    //
+    //     cron.add_schedule("Task", "* * * * * ?", libcron::FunctionRef<void(const libcron::TaskInformation&)>{ callable });
+    template<typename Result, typename... Args>
+    class FunctionRef<Result(Args...)>
+    {
+        public:
+            template<typename Callable,
+                     typename = std::enable_if_t<!std::is_same<std::decay_t<Callable>, FunctionRef>::value>>
+            FunctionRef(Callable& callable) noexcept
+                    : object(const_cast<void*>(static_cast<const void*>(std::addressof(callable)))),
+                      invoke(&call<Callable>)
+            {
+            }
+
+            Result operator()(Args... args) const
+            {
+                return invoke(object, std::forward<Args>(args)...);
+            }
+
+        private:
+            template<typename Callable>
+            static Result call(void* object, Args... args)
+            {
+                return (*static_cast<Callable*>(object))(std::forward<Args>(args)...);
+            }
+
+            void* object;
+            Result (* invoke)(void*, Args...);
+    };
+}
@@ -0,0 +1,610 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "NameIndex.h"
+#include "Task.h"
+#include "TaskHandle.h"
+
+namespace libcron
+{
+    // A task queue for many tasks sharing few expressions. Tasks with the same parsed expression
+    // (see CronDataCache), time zone and next schedule form a group, which is a single entry of a
+    // binary min-heap. A tick then takes one group at a time off the heap and goes through its
+    // members in order; as they move on to the same next schedule, they form a new group together.
+    //
+    // As with HeapTaskQueue, tasks are stored densely and indexed by name and handle, so names
+    // are unique and pushing a task with the name of an existing task replaces that task.
+    template<typename LockType>
+    class GroupedTaskQueue
+    {
+        public:
+            // All storage, that of the tasks and groups included, comes from the memory resource.
+            explicit GroupedTaskQueue(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+                    : c(resource), member_of(resource), groups(resource), free_groups(resource), heap(resource),
+                      families(resource), names(resource), slots(resource), expiring(resource), removed(resource)
+            {
+            }
+
+            const std::pmr::vector<Task>& get_tasks() const
+            {
+                return c;
+            }
+
+            // Call sort() after modifying the tasks.
+            std::pmr::vector<Task>& get_tasks()
+            {
+                return c;
+            }
+
+            size_t size() const noexcept
+            {
+                return c.size();
+            }
+
+            bool empty() const noexcept
+            {
+                return c.empty();
+            }
+
+            TaskHandle push(Task&& t)
+            {
+                auto index = append(std::move(t));
+                attach(index);
+                return c[index].get_handle();
+            }
+
+            void push(std::vector<Task>& tasks_to_insert)
+            {
+                c.reserve(c.size() + tasks_to_insert.size());
+                member_of.reserve(c.capacity());
+                names.reserve(c.capacity());
+
+                for (auto& t : tasks_to_insert)
+                {
+                    append(std::move(t));
+                }
+
+                sort();
+            }
+
+            const Task& top() const
+            {
+                return c[groups[heap[0]].members[0]];
+            }
+
+            Task& at(const size_t i)
+            {
+                return c[i];
+            }
+
+            // Regroups all tasks, after they have been modified via get_tasks(). The groups of each family
+            // are kept for reuse by the same family, so that regrouping after a jump of the clock needn't allocate.
+            void sort()
+            {
+                heap.clear();
+
+                for (auto& family : families)
+                {
+                    for (auto g : family.second)
+                    {
+                        groups[g].members.clear();
+                        groups[g].position = no_group;
+                    }
+                }
+
+                for (size_t i = 0; i < c.size(); ++i)
+                {
+                    member_of[i] = Member{};
+                    attach(i);
+                }
+
+                // Groups not needed anymore
+                for (auto& family : families)
+                {
+                    auto& family_groups = family.second;
+
+                    for (size_t i = family_groups.size(); i > 0; --i)
+                    {
+                        auto g = family_groups[i - 1];
+
+                        if (groups[g].position == no_group)
+                        {
+                            family_groups[i - 1] = family_groups.back();
+                            family_groups.pop_back();
+                            free_groups.push_back(g);
+                        }
+                    }
+                }
+            }
+
+            void clear()
+            {
+                lock.lock();
+                c.clear();
+                member_of.clear();
+                groups.clear();
+                free_groups.clear();
+                heap.clear();
+                families.clear();
+                names.clear();
+                slots.clear();
+                lock.unlock();
+            }
+
+            void remove(Task& to_remove)
+            {
+                size_t index;
+
+                if (find(to_remove.get_name(), index))
+                {
+                    remove_at(index);
+                }
+            }
+
+            void remove(const std::string& to_remove)
+            {
+                lock.lock();
+                size_t index;
+
+                if (find(to_remove, index))
+                {
+                    remove_at(index);
+                }
+
+                lock.unlock();
+            }
+
+            void remove(TaskHandle to_remove)
+            {
+                lock.lock();
+                size_t index;
+
+                if (slots.find(to_remove, index))
+                {
+                    remove_at(index);
+                }
+
+                lock.unlock();
+            }
+
+            bool contains(const std::string& name) const
+            {
+                size_t index;
+                return find(name, index);
+            }
+
+            bool contains(TaskHandle handle) const
+            {
+                size_t index;
+                return slots.find(handle, index);
+            }
+
+            // Returns nullptr if the handle is stale.
+            const Task* get(TaskHandle handle) const
+            {
+                size_t index;
+                return slots.find(handle, index) ? &c[index] : nullptr;
+            }
+
+            // Returns nullptr if there is no such task.
+            const Task* get(const std::string& name) const
+            {
+                size_t index;
+                return find(name, index) ? &c[index] : nullptr;
+            }
+
+            // Calls func on the task with the given name or handle, removing the task if func returns false.
+            // Returns false if there is no such task.
+            template<typename Key, typename Func>
+            bool update(const Key& key, Func&& func)
+            {
+                size_t index;
+                bool res = find(key, index);
+
+                if (res)
+                {
+                    detach(index);
+
+                    if (func(c[index]))
+                    {
+                        attach(index);
+                    }
+                    else
+                    {
+                        remove_at(index);
+                    }
+                }
+
+                return res;
+            }
+
+            // Calls func for each expired task, removing the task if func returns false.
+            // func must move the next schedule of a task it keeps past 'now'.
+            template<typename Func>
+            size_t for_each_expired(std::chrono::system_clock::time_point now, Func&& func)
+            {
+                size_t res = 0;
+
+                while (!heap.empty() && top().is_expired(now))
+                {
+                    // Take the members out of the group, which then goes away. The group keeps its buffer,
+                    // and is usually the one reused for the members as they move on together.
+                    auto group = heap[0];
+                    expiring.assign(groups[group].members.begin(), groups[group].members.end());
+                    groups[group].members.clear();
+
+                    for (auto index : expiring)
+                    {
+                        member_of[index] = Member{};
+                    }
+
+                    drop_group(group);
+
+                    for (auto index : expiring)
+                    {
+                        bool keep = true;
+
+                        if (c[index].is_expired(now))
+                        {
+                            keep = func(c[index]);
+                            res++;
+                        }
+
+                        if (keep)
+                        {
+                            attach(index);
+                        }
+                        else
+                        {
+                            removed.push_back(index);
+                        }
+                    }
+
+                    expiring.clear();
+
+                    // Removing a task moves the last one into its place, so start from the back to not
+                    // move any of the others that are to be removed.
+                    std::sort(removed.begin(), removed.end(), std::greater<size_t>{});
+
+                    for (auto index : removed)
+                    {
+                        remove_at(index);
+                    }
+
+                    removed.clear();
+                }
+
+                return res;
+            }
+
+            void lock_queue() const
+            {
+                /* Do not allow to manipulate the Queue */
+                lock.lock();
+            }
+
+            void release_queue() const
+            {
+                /* Allow Access to the Queue Manipulating-Functions */
+                lock.unlock();
+            }
+
+        private:
+            static constexpr size_t no_group = static_cast<size_t>(-1);
+
+            // Tasks with the same expression and zone may share groups.
+            using Family = std::pair<const CronData*, const TimeZone*>;
+
+            struct FamilyHash
+            {
+                size_t operator()(const Family& f) const
+                {
+                    return std::hash<const void*>{}(f.first) ^ (std::hash<const void*>{}(f.second) << 1);
+                }
+            };
+
+            struct Group
+            {
+                explicit Group(std::pmr::memory_resource* resource)
+                        : members(resource)
+                {
+                }
+
+                std::chrono::system_clock::time_point next{};
+                Family family{};
+                std::pmr::vector<size_t> members;
+                // Where the group is in the heap, no_group when left out by sort()
+                size_t position = 0;
+            };
+
+            struct Member
+            {
+                size_t group = no_group;
+                // Where the task is in the members of the group
+                size_t position = 0;
+            };
+
+            static Family family_of(const Task& t)
+            {
+                return Family{ t.get_schedule().get_data().get(), t.get_time_zone().get() };
+            }
+
+            bool find(std::string_view name, size_t& index) const
+            {
+                return names.find(name, index, [this](size_t i)
+                {
+                    return c[i].get_name();
+                });
+            }
+
+            bool find(TaskHandle handle, size_t& index) const
+            {
+                return slots.find(handle, index);
+            }
+
+            // Stores the task without adding it to a group.
+            size_t append(Task&& t)
+            {
+                size_t index;
+
+                if (find(t.get_name(), index))
+                {
+                    // The replaced task's handle becomes stale.
+                    detach(index);
+                    slots.release(c[index].get_handle());
+                    c[index] = std::move(t);
+                }
+                else
+                {
+                    index = c.size();
+                    names.insert(t.get_name(), index);
+                    c.push_back(std::move(t));
+                    member_of.emplace_back();
+                }
+
+                c[index].set_handle(slots.acquire(index));
+
+                return index;
+            }
+
+            void attach(size_t index)
+            {
+                auto family = family_of(c[index]);
+                auto next = c[index].get_due_time();
+                auto& family_groups = families[family];
+                auto group = no_group;
+                // A group of the family left out of the heap by sort()
+                auto spare = no_group;
+
+                // Usually a family has a single group, or two while a tick goes through them.
+                for (auto g : family_groups)
+                {
+                    if (groups[g].position == no_group)
+                    {
+                        spare = g;
+                    }
+                    else if (groups[g].next == next)
+                    {
+                        group = g;
+                    }
+                }
+
+                if (group == no_group)
+                {
+                    if (spare == no_group)
+                    {
+                        group = create_group(family);
+                        family_groups.push_back(group);
+                    }
+                    else
+                    {
+                        group = spare;
+                    }
+
+                    groups[group].next = next;
+                    enqueue(group);
+                }
+
+                auto& members = groups[group].members;
+                member_of[index] = Member{ group, members.size() };
+                members.push_back(index);
+            }
+
+            void detach(size_t index)
+            {
+                auto member = member_of[index];
+
+                if (member.group != no_group)
+                {
+                    auto& members = groups[member.group].members;
+                    auto last = members.back();
+                    members[member.position] = last;
+                    member_of[last].position = member.position;
+                    members.pop_back();
+                    member_of[index] = Member{};
+
+                    if (members.empty())
+                    {
+                        drop_group(member.group);
+                    }
+                }
+            }
+
+            size_t create_group(const Family& family)
+            {
+                size_t res;
+
+                // Reusing groups reuses the memory of their members.
+                if (free_groups.empty())
+                {
+                    res = groups.size();
+                    groups.emplace_back(groups.get_allocator().resource());
+                }
+                else
+                {
+                    res = free_groups.back();
+                    free_groups.pop_back();
+                }
+
+                groups[res].family = family;
+
+                return res;
+            }
+
+            void enqueue(size_t group)
+            {
+                groups[group].position = heap.size();
+                heap.push_back(group);
+                sift_up(heap.size() - 1);
+            }
+
+            void drop_group(size_t group)
+            {
+                auto pos = groups[group].position;
+                auto last = heap.size() - 1;
+
+                if (pos != last)
+                {
+                    heap[pos] = heap[last];
+                    groups[heap[pos]].position = pos;
+                }
+
+                heap.pop_back();
+
+                if (pos < heap.size())
+                {
+                    sift_up(pos);
+                    sift_down(pos);
+                }
+
+                auto& family_groups = families[groups[group].family];
+                auto it = std::find(family_groups.begin(), family_groups.end(), group);
+                *it = family_groups.back();
+                family_groups.pop_back();
+
+                free_groups.push_back(group);
+            }
+
+            void remove_at(size_t index)
+            {
+                detach(index);
+
+                auto family = family_of(c[index]);
+                names.erase(c[index].get_name(), index);
+                slots.release(c[index].get_handle());
+
+                // Keep the tasks dense by moving the last one into the hole.
+                auto last_task = c.size() - 1;
+
+                if (index != last_task)
+                {
+                    c[index] = std::move(c[last_task]);
+                    member_of[index] = member_of[last_task];
+
+                    if (member_of[index].group != no_group)
+                    {
+                        groups[member_of[index].group].members[member_of[index].position] = index;
+                    }
+
+                    names.move(c[index].get_name(), last_task, index);
+                    slots.move(c[index].get_handle(), index);
+                }
+
+                c.pop_back();
+                member_of.pop_back();
+
+                // Families of expressions no longer used go away, so their CronData may too.
+                auto f = families.find(family);
+
+                if (f != families.end() && f->second.empty())
+                {
+                    families.erase(f);
+                }
+            }
+
+            bool earlier(size_t a, size_t b) const
+            {
+                return groups[heap[a]].next < groups[heap[b]].next;
+            }
+
+            void swap_entries(size_t a, size_t b)
+            {
+                std::swap(heap[a], heap[b]);
+                groups[heap[a]].position = a;
+                groups[heap[b]].position = b;
+            }
+
+            void sift_up(size_t pos)
+            {
+                while (pos > 0)
+                {
+                    auto parent = (pos - 1) / 2;
+
+                    if (earlier(pos, parent))
+                    {
+                        swap_entries(pos, parent);
+                        pos = parent;
+                    }
+                    else
+                    {
+                        pos = 0;
+                    }
+                }
+            }
+
+            void sift_down(size_t pos)
+            {
+                auto count = heap.size();
+                bool done = false;
+
+                while (!done)
+                {
+                    auto smallest = pos;
+                    auto left = 2 * pos + 1;
+                    auto right = left + 1;
+
+                    if (left < count && earlier(left, smallest))
+                    {
+                        smallest = left;
+                    }
+
+                    if (right < count && earlier(right, smallest))
+                    {
+                        smallest = right;
+                    }
+
+                    done = smallest == pos;
+
+                    if (!done)
+                    {
+                        swap_entries(pos, smallest);
+                        pos = smallest;
+                    }
+                }
+            }
+
+            mutable LockType lock;
+            std::pmr::vector<Task> c;
+            // member_of[i] is the group of c[i]
+            std::pmr::vector<Member> member_of;
+            std::pmr::vector<Group> groups;
+            std::pmr::vector<size_t> free_groups;
+            // Indices in groups, ordered by their next schedule
+            std::pmr::vector<size_t> heap;
+            // The groups of each family
+            std::pmr::unordered_map<Family, std::pmr::vector<size_t>, FamilyHash> families;
+            // The index in c of each task, by name
+            NameIndex names;
+            TaskSlots slots;
+            // Reused by for_each_expired()
+            std::pmr::vector<size_t> expiring;
+            std::pmr::vector<size_t> removed;
+    };
+}
@@ -0,0 +1,424 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include "NameIndex.h"
+#include "Task.h"
+#include "TaskHandle.h"
+
+namespace libcron
+{
+    // A task queue ordered as a binary min-heap on the next schedule of each task.
+    // Unlike TaskQueue, which scans and sorts all tasks, a tick only touches the tasks
+    // that are due and rescheduling or removing a task is O(log n).
+    //
+    // The tasks are stored densely, in no particular order, while the heap holds
+    // the next schedule of each task along with its index. Tasks are also indexed by
+    // name, so names are unique; pushing a task with the name of an existing task
+    // replaces that task.
+    template<typename LockType>
+    class HeapTaskQueue
+    {
+        public:
+            // All storage, that of the tasks included, comes from the memory resource.
+            explicit HeapTaskQueue(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+                    : c(resource), heap(resource), position(resource), names(resource), slots(resource)
+            {
+            }
+
+            const std::pmr::vector<Task>& get_tasks() const
+            {
+                return c;
+            }
+
+            // Call sort() after modifying the tasks.
+            std::pmr::vector<Task>& get_tasks()
+            {
+                return c;
+            }
+
+            size_t size() const noexcept
+            {
+                return c.size();
+            }
+
+            bool empty() const noexcept
+            {
+                return c.empty();
+            }
+
+            TaskHandle push(Task&& t)
+            {
+                size_t index;
+                restore(append(std::move(t), index));
+                return c[index].get_handle();
+            }
+
+            void push(std::vector<Task>& tasks_to_insert)
+            {
+                c.reserve(c.size() + tasks_to_insert.size());
+                heap.reserve(c.capacity());
+                position.reserve(c.capacity());
+                names.reserve(c.capacity());
+
+                // Restoring the heap for each task takes O(k log n), rebuilding it O(n + k).
+                size_t depth = 1;
+
+                for (auto n = c.size() + tasks_to_insert.size(); n > 1; n /= 2)
+                {
+                    ++depth;
+                }
+
+                bool rebuild = tasks_to_insert.size() * depth >= c.size();
+                size_t index;
+
+                for (auto& t : tasks_to_insert)
+                {
+                    auto pos = append(std::move(t), index);
+
+                    if (!rebuild)
+                    {
+                        restore(pos);
+                    }
+                }
+
+                if (rebuild)
+                {
+                    sort();
+                }
+            }
+
+            const Task& top() const
+            {
+                return c[heap[0].index];
+            }
+
+            Task& at(const size_t i)
+            {
+                return c[i];
+            }
+
+            // Rebuilds the heap, in O(n), after tasks have been modified via get_tasks().
+            void sort()
+            {
+                for (size_t i = 0; i < heap.size(); ++i)
+                {
+                    heap[i] = Entry{ key_of(c[i]), i };
+                    position[i] = i;
+                }
+
+                for (auto i = heap.size() / 2; i-- > 0;)
+                {
+                    sift_down(i);
+                }
+            }
+
+            void clear()
+            {
+                lock.lock();
+                c.clear();
+                heap.clear();
+                position.clear();
+                names.clear();
+                slots.clear();
+                lock.unlock();
+            }
+
+            void remove(Task& to_remove)
+            {
+                size_t index;
+
+                if (find(to_remove.get_name(), index))
+                {
+                    remove_at(index);
+                }
+            }
+
+            void remove(const std::string& to_remove)
+            {
+                lock.lock();
+                size_t index;
+
+                if (find(to_remove, index))
+                {
+                    remove_at(index);
+                }
+
+                lock.unlock();
+            }
+
+            void remove(TaskHandle to_remove)
+            {
+                lock.lock();
+                size_t index;
+
+                if (slots.find(to_remove, index))
+                {
+                    remove_at(index);
+                }
+
+                lock.unlock();
+            }
+
+            bool contains(const std::string& name) const
+            {
+                size_t index;
+                return find(name, index);
+            }
+
+            bool contains(TaskHandle handle) const
+            {
+                size_t index;
+                return slots.find(handle, index);
+            }
+
+            // Returns nullptr if the handle is stale.
+            const Task* get(TaskHandle handle) const
+            {
+                size_t index;
+                return slots.find(handle, index) ? &c[index] : nullptr;
+            }
+
+            // Returns nullptr if there is no such task.
+            const Task* get(const std::string& name) const
+            {
+                size_t index;
+                return find(name, index) ? &c[index] : nullptr;
+            }
+
+            // Calls func on the task with the given name or handle, removing the task if func returns false.
+            // Returns false if there is no such task.
+            template<typename Key, typename Func>
+            bool update(const Key& key, Func&& func)
+            {
+                size_t index;
+                bool res = find(key, index);
+
+                if (res)
+                {
+                    if (func(c[index]))
+                    {
+                        heap[position[index]].next = key_of(c[index]);
+                        restore(position[index]);
+                    }
+                    else
+                    {
+                        remove_at(index);
+                    }
+                }
+
+                return res;
+            }
+
+            // Calls func for each expired task, removing the task if func returns false.
+            // func must move the next schedule of a task it keeps past 'now'.
+            template<typename Func>
+            size_t for_each_expired(std::chrono::system_clock::time_point now, Func&& func)
+            {
+                size_t res = 0;
+
+                while (!heap.empty() && c[heap[0].index].is_expired(now))
+                {
+                    auto index = heap[0].index;
+
+                    if (func(c[index]))
+                    {
+                        heap[0].next = key_of(c[index]);
+                        sift_down(0);
+                    }
+                    else
+                    {
+                        remove_at(index);
+                    }
+
+                    res++;
+                }
+
+                return res;
+            }
+
+            void lock_queue() const
+            {
+                /* Do not allow to manipulate the Queue */
+                lock.lock();
+            }
+
+            void release_queue() const
+            {
+                /* Allow Access to the Queue Manipulating-Functions */
+                lock.unlock();
+            }
+
+        private:
+            struct Entry
+            {
+                std::chrono::system_clock::time_point next;
+                size_t index;
+            };
+
+            static std::chrono::system_clock::time_point key_of(const Task& t)
+            {
+                // Tasks that never expire are kept at the bottom.
+                return t.get_due_time();
+            }
+
+            bool find(std::string_view name, size_t& index) const
+            {
+                return names.find(name, index, [this](size_t i)
+                {
+                    return c[i].get_name();
+                });
+            }
+
+            bool find(TaskHandle handle, size_t& index) const
+            {
+                return slots.find(handle, index);
+            }
+
+            // Returns the position in the heap of the entry that has to be restored.
+            size_t append(Task&& t, size_t& index)
+            {
+                size_t res;
+
+                if (find(t.get_name(), index))
+                {
+                    // The replaced task's handle becomes stale.
+                    slots.release(c[index].get_handle());
+                    res = position[index];
+                    heap[res].next = key_of(t);
+                    c[index] = std::move(t);
+                }
+                else
+                {
+                    index = c.size();
+                    names.insert(t.get_name(), index);
+                    heap.push_back(Entry{ key_of(t), index });
+                    position.push_back(heap.size() - 1);
+                    c.push_back(std::move(t));
+                    res = heap.size() - 1;
+                }
+
+                c[index].set_handle(slots.acquire(index));
+
+                return res;
+            }
+
+            // The entry at pos goes either up or down, calling both is harmless.
+            void restore(size_t pos)
+            {
+                sift_up(pos);
+                sift_down(pos);
+            }
+
+            void remove_at(size_t index)
+            {
+                // Replace the heap entry with the last one and restore the heap from there.
+                auto pos = position[index];
+                auto last_entry = heap.size() - 1;
+
+                if (pos != last_entry)
+                {
+                    move_entry(last_entry, pos);
+                }
+
+                heap.pop_back();
+
+                if (pos < heap.size())
+                {
+                    restore(pos);
+                }
+
+                names.erase(c[index].get_name(), index);
+                slots.release(c[index].get_handle());
+
+                // Keep the tasks dense by moving the last one into the hole.
+                auto last_task = c.size() - 1;
+
+                if (index != last_task)
+                {
+                    c[index] = std::move(c[last_task]);
+                    position[index] = position[last_task];
+                    heap[position[index]].index = index;
+                    names.move(c[index].get_name(), last_task, index);
+                    slots.move(c[index].get_handle(), index);
+                }
+
+                c.pop_back();
+                position.pop_back();
+            }
+
+            void sift_up(size_t pos)
+            {
+                while (pos > 0)
+                {
+                    auto parent = (pos - 1) / 2;
+
+                    if (heap[pos].next < heap[parent].next)
+                    {
+                        swap_entries(pos, parent);
+                        pos = parent;
+                    }
+                    else
+                    {
+                        pos = 0;
+                    }
+                }
+            }
+
+            void sift_down(size_t pos)
+            {
+                auto count = heap.size();
+                bool done = false;
+
+                while (!done)
+                {
+                    auto smallest = pos;
+                    auto left = 2 * pos + 1;
+                    auto right = left + 1;
+
+                    if (left < count && heap[left].next < heap[smallest].next)
+                    {
+                        smallest = left;
+                    }
+
+                    if (right < count && heap[right].next < heap[smallest].next)
+                    {
+                        smallest = right;
+                    }
+
+                    done = smallest == pos;
+
+                    if (!done)
+                    {
+                        swap_entries(pos, smallest);
+                        pos = smallest;
+                    }
+                }
+            }
+
+            void swap_entries(size_t a, size_t b)
+            {
+                std::swap(heap[a], heap[b]);
+                position[heap[a].index] = a;
+                position[heap[b].index] = b;
+            }
+
+            void move_entry(size_t from, size_t to)
+            {
+                heap[to] = heap[from];
+                position[heap[to].index] = to;
+            }
+
+            mutable LockType lock;
+            std::pmr::vector<Task> c;
+            std::pmr::vector<Entry> heap;
+            // position[i] is the index in the heap of the entry for c[i]
+            std::pmr::vector<size_t> position;
+            // The index in c of each task, by name
+            NameIndex names;
+            TaskSlots slots;
+    };
+}
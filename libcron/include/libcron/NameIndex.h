@@ -0,0 +1,176 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+namespace libcron
+{
+    // Indexes the tasks of a queue by name, as an open addressing hash table of their indices.
+    // The names themselves are not stored, they are those of the tasks, so indexing a task
+    // neither copies its name nor allocates a node.
+    class NameIndex
+    {
+        public:
+            explicit NameIndex(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+                    : slots(resource)
+            {
+            }
+
+            // name_of(index) gives the name of the task at index.
+            template<typename NameOf>
+            bool find(std::string_view name, size_t& index, const NameOf& name_of) const
+            {
+                bool res = false;
+
+                if (!slots.empty())
+                {
+                    auto h = hash_of(name);
+                    auto mask = slots.size() - 1;
+
+                    for (auto i = h & mask; !res && slots[i].index != empty_slot; i = (i + 1) & mask)
+                    {
+                        if (slots[i].hash == h && name_of(slots[i].index) == name)
+                        {
+                            index = slots[i].index;
+                            res = true;
+                        }
+                    }
+                }
+
+                return res;
+            }
+
+            // The name must not be indexed yet.
+            void insert(std::string_view name, size_t index)
+            {
+                reserve(count + 1);
+                place(Slot{ hash_of(name), index });
+                ++count;
+            }
+
+            void erase(std::string_view name, size_t index)
+            {
+                size_t i;
+
+                if (locate(name, index, i))
+                {
+                    // Shift back the following entries of the run, so that no tombstones are needed.
+                    auto mask = slots.size() - 1;
+
+                    for (auto j = (i + 1) & mask; slots[j].index != empty_slot; j = (j + 1) & mask)
+                    {
+                        auto ideal = slots[j].hash & mask;
+
+                        // Only move an entry that would no longer be found past the hole at i.
+                        if (((j - ideal) & mask) >= ((j - i) & mask))
+                        {
+                            slots[i] = slots[j];
+                            i = j;
+                        }
+                    }
+
+                    slots[i] = Slot{};
+                    --count;
+                }
+            }
+
+            // The task with the name moved from one index to another.
+            void move(std::string_view name, size_t from, size_t to)
+            {
+                size_t i;
+
+                if (locate(name, from, i))
+                {
+                    slots[i].index = to;
+                }
+            }
+
+            void reserve(size_t names)
+            {
+                // Kept at most half full, for short runs.
+                if (names * 2 > slots.size())
+                {
+                    size_t size = 16;
+
+                    while (size < names * 2)
+                    {
+                        size *= 2;
+                    }
+
+                    std::pmr::vector<Slot> old(size, Slot{}, slots.get_allocator());
+                    old.swap(slots);
+
+                    for (const auto& s : old)
+                    {
+                        if (s.index != empty_slot)
+                        {
+                            place(s);
+                        }
+                    }
+                }
+            }
+
+            void clear()
+            {
+                std::fill(slots.begin(), slots.end(), Slot{});
+                count = 0;
+            }
+
+        private:
+            static constexpr size_t empty_slot = std::numeric_limits<size_t>::max();
+
+            struct Slot
+            {
+                size_t hash = 0;
+                size_t index = empty_slot;
+            };
+
+            static size_t hash_of(std::string_view name)
+            {
+                return std::hash<std::string_view>{}(name);
+            }
+
+            bool locate(std::string_view name, size_t index, size_t& pos) const
+            {
+                bool res = false;
+
+                if (!slots.empty())
+                {
+                    auto h = hash_of(name);
+                    auto mask = slots.size() - 1;
+
+                    for (auto i = h & mask; !res && slots[i].index != empty_slot; i = (i + 1) & mask)
+                    {
+                        if (slots[i].index == index)
+                        {
+                            pos = i;
+                            res = true;
+                        }
+                    }
+                }
+
+                return res;
+            }
+
+            void place(Slot s)
+            {
+                auto mask = slots.size() - 1;
+                auto i = s.hash & mask;
+
+                while (slots[i].index != empty_slot)
+                {
+                    i = (i + 1) & mask;
+                }
+
+                slots[i] = s;
+            }
+
+            std::pmr::vector<Slot> slots;
+            size_t count = 0;
+    };
+}
@@ -0,0 +1,296 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "Cron.h"
+#include "CronRunner.h"
+
+namespace libcron
+{
+    // Pins the thread to the core, modulo the number of cores. Returns false where that isn't supported.
+    bool pin_to_core(std::thread& thread, size_t core);
+
+    // Spreads tasks over several Cron instances, the shards, by a hash of their names, each ticked by a
+    // thread of its own. A burst of tasks due at the same time, e.g. at the top of each minute, is then
+    // run by all shards at once instead of one after another by a single tick.
+    //
+    // The shards use a Locker, so tasks may be changed from any thread. Tasks run on the thread of their
+    // shard, with its queue locked; work that changes tasks of other shards should be run through an
+    // executor, so that no two shards wait for each other.
+    template<typename ClockType = libcron::LocalClock,
+             template<typename> class QueueType = libcron::HeapTaskQueue,
+             typename ObserverType = libcron::NullObserver>
+    class ShardedCron
+    {
+        public:
+            using CronType = Cron<ClockType, Locker, QueueType, ObserverType>;
+
+            static size_t default_shard_count()
+            {
+                return std::max(1u, std::thread::hardware_concurrency());
+            }
+
+            explicit ShardedCron(size_t shard_count = default_shard_count())
+            {
+                for (size_t i = 0; i < std::max<size_t>(shard_count, 1); ++i)
+                {
+                    shards.push_back(std::make_unique<Shard>());
+                }
+            }
+
+            // Each shard runs its tasks through the executor, see Cron(Executor).
+            ShardedCron(size_t shard_count, const Executor& executor)
+            {
+                for (size_t i = 0; i < std::max<size_t>(shard_count, 1); ++i)
+                {
+                    shards.push_back(std::make_unique<Shard>(executor));
+                }
+            }
+
+            ~ShardedCron()
+            {
+                stop();
+            }
+
+            ShardedCron(const ShardedCron&) = delete;
+
+            ShardedCron& operator=(const ShardedCron&) = delete;
+
+            // Starts a thread for each shard, ticking it whenever one of its tasks expires, see CronRunner.
+            // With pin, the thread of shard i is pinned to core i.
+            void start(bool pin = true)
+            {
+                for (size_t i = 0; i < shards.size(); ++i)
+                {
+                    auto& s = *shards[i];
+
+                    if (!s.thread.joinable())
+                    {
+                        s.thread = std::thread{ [&s]()
+                                                {
+                                                    s.runner.run();
+                                                } };
+
+                        if (pin)
+                        {
+                            pin_to_core(s.thread, i);
+                        }
+                    }
+                }
+            }
+
+            // Stops the threads once their current tick is done.
+            void stop()
+            {
+                for (auto& s : shards)
+                {
+                    if (s->thread.joinable())
+                    {
+                        s->runner.stop();
+                        s->thread.join();
+                    }
+                }
+            }
+
+            bool add_schedule(std::string name, const std::string& schedule, Task::TaskFunction work)
+            {
+                auto& cron = shard_for(name);
+                return cron.add_schedule(std::move(name), schedule, std::move(work));
+            }
+
+            bool add_schedule(std::string name, std::shared_ptr<const CronData> schedule, Task::TaskFunction work)
+            {
+                auto& cron = shard_for(name);
+                return cron.add_schedule(std::move(name), std::move(schedule), std::move(work));
+            }
+
+            void remove_schedule(const std::string& name)
+            {
+                shard_for(name).remove_schedule(name);
+            }
+
+            void clear_schedules()
+            {
+                for (auto& s : shards)
+                {
+                    s->cron.clear_schedules();
+                }
+            }
+
+            bool has_schedule(const std::string& name) const
+            {
+                return shard_for(name).has_schedule(name);
+            }
+
+            bool update_schedule(const std::string& name, const std::string& schedule)
+            {
+                return shard_for(name).update_schedule(name, schedule);
+            }
+
+            bool pause_schedule(const std::string& name)
+            {
+                return shard_for(name).pause_schedule(name);
+            }
+
+            bool resume_schedule(const std::string& name)
+            {
+                return shard_for(name).resume_schedule(name);
+            }
+
+            bool set_overlap_policy(const std::string& name, OverlapPolicy policy)
+            {
+                return shard_for(name).set_overlap_policy(name, policy);
+            }
+
+            bool set_time_zone(const std::string& name, const std::string& zone)
+            {
+                return shard_for(name).set_time_zone(name, zone);
+            }
+
+            void set_misfire_options(const MisfireOptions& options)
+            {
+                for (auto& s : shards)
+                {
+                    s->cron.set_misfire_options(options);
+                }
+            }
+
+            // The offsets only depend on the names, so they are the same whatever the number of shards.
+            void set_jitter(std::chrono::seconds window)
+            {
+                for (auto& s : shards)
+                {
+                    s->cron.set_jitter(window);
+                }
+            }
+
+            MisfireStatistics get_misfire_statistics() const
+            {
+                MisfireStatistics res{};
+
+                for (const auto& s : shards)
+                {
+                    auto m = s->cron.get_misfire_statistics();
+                    res.misfired += m.misfired;
+                    res.runs += m.runs;
+                    res.coalesced += m.coalesced;
+                }
+
+                return res;
+            }
+
+            size_t count() const
+            {
+                size_t res = 0;
+
+                for (const auto& s : shards)
+                {
+                    res += s->cron.count();
+                }
+
+                return res;
+            }
+
+            // The time until the next task of any shard expires. Returns false if there are no tasks.
+            bool time_until_next(std::chrono::system_clock::duration& time_until) const
+            {
+                bool res = false;
+
+                for (const auto& s : shards)
+                {
+                    std::chrono::system_clock::duration d{};
+
+                    if (s->cron.time_until_next(d) && (!res || d < time_until))
+                    {
+                        time_until = d;
+                        res = true;
+                    }
+                }
+
+                return res;
+            }
+
+            // Ticks each shard in turn on the calling thread, instead of start(). Returns the number of expired tasks.
+            size_t tick()
+            {
+                size_t res = 0;
+
+                for (auto& s : shards)
+                {
+                    res += s->cron.tick();
+                }
+
+                return res;
+            }
+
+            size_t shard_count() const
+            {
+                return shards.size();
+            }
+
+            // The same on all platforms. Salted, so that independent of the jitter of the task: otherwise, with
+            // a window that is a multiple of the number of shards, the tasks due in a second would share a shard.
+            size_t shard_of(std::string_view name) const
+            {
+                constexpr uint64_t salt = 0x5368617264000001ull;
+                return static_cast<size_t>(CronType::hash_of(name, salt) % shards.size());
+            }
+
+            // E.g. to set the clock of each shard; changing tasks must go through the ShardedCron.
+            CronType& get_shard(size_t index)
+            {
+                return shards[index]->cron;
+            }
+
+            const CronType& get_shard(size_t index) const
+            {
+                return shards[index]->cron;
+            }
+
+        private:
+            struct Shard
+            {
+                Shard() = default;
+
+                explicit Shard(const Executor& executor)
+                        : cron(executor)
+                {
+                }
+
+                CronType cron{};
+                CronRunner<CronType> runner{ cron };
+                std::thread thread{};
+            };
+
+            CronType& shard_for(std::string_view name)
+            {
+                return shards[shard_of(name)]->cron;
+            }
+
+            const CronType& shard_for(std::string_view name) const
+            {
+                return shards[shard_of(name)]->cron;
+            }
+
+            std::vector<std::unique_ptr<Shard>> shards{};
+    };
+
+    template<typename ClockType, template<typename> class QueueType, typename ObserverType>
+    std::ostream& operator<<(std::ostream& stream, const ShardedCron<ClockType, QueueType, ObserverType>& c)
+    {
+        for (size_t i = 0; i < c.shard_count(); ++i)
+        {
+            stream << c.get_shard(i);
+        }
+
+        return stream;
+    }
+}
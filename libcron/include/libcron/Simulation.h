@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "CronSchedule.h"
+#include "Task.h"
+#include "TimeZone.h"
+
+namespace libcron
+{
+    // The fire events of a Simulation, in columns. The events at the same point in time share their entry in times.
+    struct FireEvents
+    {
+        // The points in time at which schedules fire, in order, in seconds since the epoch.
+        std::vector<int64_t> times{};
+        // The events at times[i] are those in schedules from ends[i - 1], or the start, up to ends[i].
+        std::vector<uint64_t> ends{};
+        // The index of the schedule of each event, see Simulation::add().
+        std::vector<uint32_t> schedules{};
+
+        // The number of events
+        size_t size() const
+        {
+            return schedules.size();
+        }
+
+        void clear();
+
+        // The number of events in each interval from from until to, the last one possibly being shorter.
+        std::vector<uint64_t> counts(std::chrono::system_clock::time_point from, std::chrono::system_clock::time_point to,
+                                     std::chrono::seconds interval) const;
+
+        // The largest number of events at a single point in time, i.e. the most tasks a tick would have to run.
+        uint64_t peak() const;
+    };
+
+    // Runs schedules over a period of time without waiting for it, jumping from one schedule to the next
+    // rather than ticking each second, e.g. to find out the load a set of schedules puts on a Cron instance
+    // before deploying them. Schedules with the same expression, time zone and offset are calculated once
+    // for all of them.
+    class Simulation
+    {
+        public:
+            // Returns the index of the schedule in the events. The zone and offset are as for Task::set_time_zone()
+            // and Task::set_offset().
+            uint32_t add(std::string name, CronSchedule schedule, std::shared_ptr<const TimeZone> zone = {},
+                         std::chrono::seconds offset = std::chrono::seconds{ 0 });
+
+            // Adds the tasks of the Cron instance, in no particular order. Paused tasks are left out, as they don't
+            // fire. With work, the work of the tasks is copied too, see run().
+            template<typename CronType>
+            void add_tasks(const CronType& cron, bool with_work = false)
+            {
+                cron.for_each_task([this, with_work](const Task& t)
+                                   {
+                                       if (!t.is_paused())
+                                       {
+                                           auto index = add(std::string{ t.get_name() }, t.get_schedule(),
+                                                            t.get_time_zone(), t.get_offset());
+
+                                           if (with_work)
+                                           {
+                                               set_work(index, t.get_work());
+                                           }
+                                       }
+                                   });
+            }
+
+            void set_work(uint32_t index, Task::TaskFunction work);
+
+            size_t size() const
+            {
+                return names.size();
+            }
+
+            const std::string& get_name(uint32_t index) const
+            {
+                return names[index];
+            }
+
+            // Calls fire(time, first, last) for the schedules firing at each point in time from from until to,
+            // in order of time, passing the range [first, last) of their indexes. The schedules firing at the same
+            // time may be passed in more than one call.
+            template<typename Fire>
+            void for_each_fire(std::chrono::system_clock::time_point from, std::chrono::system_clock::time_point to,
+                               Fire&& fire) const;
+
+            // Adds the events from from until to to out. With run_work, the work of each schedule that has
+            // been given one is also run as it fires, on the calling thread and with a delay of zero.
+            void run(std::chrono::system_clock::time_point from, std::chrono::system_clock::time_point to,
+                     FireEvents& out, bool run_work = false) const;
+
+        private:
+            struct Group
+            {
+                CronSchedule schedule;
+                std::shared_ptr<const TimeZone> zone;
+                std::chrono::seconds offset;
+                std::vector<uint32_t> members;
+            };
+
+            // Where a group is in its schedules.
+            struct Cursor
+            {
+                CronSchedule::occurrence_iterator occurrence{};
+                std::chrono::system_clock::time_point next{};
+            };
+
+            // Groups are looked up by the value of their expression, to also share the calculation
+            // between tasks whose schedules have been parsed separately.
+            struct Key
+            {
+                const CronData* data;
+                const TimeZone* zone;
+                std::chrono::seconds offset;
+
+                bool operator==(const Key& other) const
+                {
+                    return *data == *other.data && zone == other.zone && offset == other.offset;
+                }
+            };
+
+            struct KeyHash
+            {
+                size_t operator()(const Key& key) const;
+            };
+
+            // Both return false once the group has no more schedules before to.
+            bool start(const Group& group, Cursor& cursor, std::chrono::system_clock::time_point from,
+                       std::chrono::system_clock::time_point to) const;
+
+            bool advance(const Group& group, Cursor& cursor, std::chrono::system_clock::time_point to) const;
+
+            std::vector<Group> groups{};
+            std::unordered_map<Key, uint32_t, KeyHash> group_of{};
+            std::vector<std::string> names{};
+            std::vector<Task::TaskFunction> works{};
+    };
+
+    template<typename Fire>
+    void Simulation::for_each_fire(std::chrono::system_clock::time_point from, std::chrono::system_clock::time_point to,
+                                   Fire&& fire) const
+    {
+        std::vector<Cursor> cursors(groups.size());
+
+        // The next schedule of each group, earliest first and, at the same time, by group.
+        using Next = std::pair<std::chrono::system_clock::time_point, uint32_t>;
+        std::vector<Next> heap{};
+        heap.reserve(groups.size());
+
+        for (uint32_t g = 0; g < groups.size(); ++g)
+        {
+            if (start(groups[g], cursors[g], from, to))
+            {
+                heap.emplace_back(cursors[g].next, g);
+            }
+        }
+
+        std::make_heap(heap.begin(), heap.end(), std::greater<Next>{});
+
+        while (!heap.empty())
+        {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<Next>{});
+            auto& next = heap.back();
+            const auto& members = groups[next.second].members;
+
+            fire(next.first, members.data(), members.data() + members.size());
+
+            if (advance(groups[next.second], cursors[next.second], to))
+            {
+                next.first = cursors[next.second].next;
+                std::push_heap(heap.begin(), heap.end(), std::greater<Next>{});
+            }
+            else
+            {
+                heap.pop_back();
+            }
+        }
+    }
+}
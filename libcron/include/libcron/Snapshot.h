@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+#include "libcron/CronData.h"
+#include "libcron/Task.h"
+#include "libcron/TimeZone.h"
+
+namespace libcron
+{
+    // The state of a set of tasks in a compact binary format, for restarting without parsing and
+    // calculating all schedules again, or for handing the tasks over to another process.
+    //
+    // A snapshot holds, for each task, its name, parsed expression, zone name, next schedule, last run,
+    // delay, overlap policy, jitter offset and the state of catching up on missed schedules. Expressions
+    // and zones are stored once, however many tasks use them. All values are little-endian and of fixed
+    // size, so snapshots can be shared between machines, and records are read in place, so a memory
+    // mapped file can be opened as is. The work of the tasks is not stored; it is provided when
+    // restoring.
+    //
+    // Layout, each part aligned to 8 bytes:
+    //   header       magic "LCSS", version, number of expressions, zones and tasks, size of the strings
+    //   expressions  the bits of the six fields
+    //   zones        name as offset and length in the strings
+    //   tasks        name, index of expression and zone, flags and the state and offset in microseconds
+    //   strings      the names of the zones and tasks
+    class Snapshot
+    {
+        public:
+            static constexpr uint32_t version = 2;
+
+            // Appends the snapshot of the tasks to out.
+            static void write(const Task* tasks, size_t count, std::vector<uint8_t>& out);
+
+            static void write(const std::vector<Task>& tasks, std::vector<uint8_t>& out)
+            {
+                write(tasks.data(), tasks.size(), out);
+            }
+
+            static void write(const std::pmr::vector<Task>& tasks, std::vector<uint8_t>& out)
+            {
+                write(tasks.data(), tasks.size(), out);
+            }
+
+            // Refers to the data, which must outlive the Snapshot and not change. Returns false, leaving the
+            // Snapshot empty, if the data is not a snapshot of this version or is inconsistent.
+            // Looks up the zones used by the tasks, see TimeZone::locate(), and shares the expressions with
+            // the tasks already using them, see CronDataCache::intern().
+            bool open(const void* data, size_t size);
+
+            size_t size() const
+            {
+                return task_count;
+            }
+
+            std::string_view get_name(size_t index) const;
+
+            // Appends the task with the given index to tasks, with its state and offset as in the snapshot.
+            // Returns false if the task can't be restored as its zone is unknown, e.g. since it was made
+            // with TimeZone::from_posix(). The name of the task is allocated from the memory resource.
+            bool restore(size_t index, Task::TaskFunction work, std::vector<Task>& tasks,
+                         std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
+
+        private:
+            static constexpr size_t header_size = 32;
+            static constexpr size_t expression_size = 32;
+            static constexpr size_t zone_size = 16;
+            static constexpr size_t task_size = 72;
+            static constexpr uint32_t no_zone = static_cast<uint32_t>(-1);
+
+            const uint8_t* task_at(size_t index) const
+            {
+                return task_records + index * task_size;
+            }
+
+            const uint8_t* task_records = nullptr;
+            const char* strings = nullptr;
+            size_t task_count = 0;
+            std::vector<std::shared_ptr<const CronData>> expressions{};
+            // nullptr for zones that are unknown here
+            std::vector<std::shared_ptr<const TimeZone>> zones{};
+    };
+}
@@ -2,19 +2,78 @@
 
 #include <functional>
 #include <chrono>
+#include <cstdint>
+#include <deque>
 #include <limits>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
 #include <utility>
 #include "CronData.h"
 #include "CronSchedule.h"
+#include "TaskHandle.h"
+#include "FunctionRef.h"
 
 namespace libcron
 {
+    // Ends a run of a task whose work returned before it was done, see TaskInformation::defer_completion().
+    // Copies may be passed around, e.g. into the completion handler of an I/O operation; the run ends when
+    // one of them is called, or else when the last one is destroyed.
+    class RunCompletion
+    {
+        public:
+            RunCompletion() = default;
+
+            // May be called from any thread. Until the run has ended, overlapping runs are skipped or queued
+            // as per the overlap policy of the task; queued runs are made by the calling thread.
+            void operator()() const;
+
+            // False if the run isn't tracked, i.e. the overlap policy is OverlapPolicy::Allow.
+            explicit operator bool() const
+            {
+                return run != nullptr;
+            }
+
+        private:
+            friend class Task;
+
+            struct Run;
+
+            explicit RunCompletion(std::shared_ptr<Run> run)
+                    : run(std::move(run))
+            {
+            }
+
+            std::shared_ptr<Run> run{};
+    };
+
     class TaskInformation
     {
         public:
             virtual ~TaskInformation() = default;
             virtual std::chrono::system_clock::duration get_delay() const = 0;
-            virtual std::string get_name() const = 0;
+            // Valid during the call of the task's work.
+            virtual std::string_view get_name() const = 0;
+
+            // Called by work that goes on after it has returned, e.g. waiting for I/O on an event loop, to end
+            // the run when it is actually done rather than on returning. Calling it again returns the same
+            // completion. See RunCompletion.
+            virtual RunCompletion defer_completion() const
+            {
+                return {};
+            }
+    };
+
+    // What to do when a task is due while its previous run, dispatched to an executor or deferring its end,
+    // is still in progress.
+    enum class OverlapPolicy
+    {
+        Allow,  // Run concurrently with the previous run
+        Skip,   // Don't run this time
+        Queue   // Run once the previous run has finished
     };
 
     class Task : public TaskInformation
@@ -23,46 +82,252 @@ namespace libcron
             using TaskFunction = std::function<void(const TaskInformation&)>;
 
             Task(std::string name, const CronSchedule schedule, TaskFunction task)
-                    : name(std::move(name)), schedule(std::move(schedule)), task(std::move(task))
+                    : Task(std::string_view{ name }, std::move(schedule), std::move(task), std::pmr::get_default_resource())
             {
             }
 
-            void execute(std::chrono::system_clock::time_point now)
+            // The name is allocated from the memory resource, which should be that of the queue the task goes in.
+            Task(std::string_view name, const CronSchedule schedule, TaskFunction task, std::pmr::memory_resource* resource)
+                    : schedule(std::move(schedule)), name(name, resource), task(std::move(task))
             {
-                // Next Schedule is still the current schedule, calculate delay (actual execution - planned execution)
-                delay = now - next_schedule;
-
-                last_run = now;
-                task(*this);
             }
 
+            // Runs the task on the calling thread. Overlapping runs are only possible when the work defers the
+            // end of its runs; returns false if the run is skipped or queued as per the overlap policy.
+            bool execute(std::chrono::system_clock::time_point now);
+
+            // Prepares a run of the task for an executor, i.e. on another thread. The task passed to the
+            // work is a snapshot, with the delay including the time it took the executor to start the run.
+            // Returns false, leaving job empty, if the run is skipped or queued as per the overlap policy.
+            bool dispatch(std::chrono::system_clock::time_point now, std::function<void()>& job);
+
             std::chrono::system_clock::duration get_delay() const override
             {
                 return delay;
             }
 
-            Task(const Task& other) = default;
+            OverlapPolicy get_overlap_policy() const
+            {
+                return overlap_policy;
+            }
+
+            void set_overlap_policy(OverlapPolicy policy)
+            {
+                overlap_policy = policy;
+            }
+
+            // Tasks are moved rather than copied, as copying the name and work may allocate.
+            Task(const Task& other) = delete;
+
+            Task& operator=(const Task&) = delete;
 
-            Task& operator=(const Task&) = default;
+            Task(Task&& other) = default;
 
+            Task& operator=(Task&&) = default;
+
+            // The last calculation of a next schedule, to reuse for tasks sharing the same schedule.
+            struct NextScheduleMemo
+            {
+                const CronData* data = nullptr;
+                const TimeZone* zone = nullptr;
+                std::chrono::system_clock::time_point from{};
+                std::tuple<bool, std::chrono::system_clock::time_point> result{};
+            };
+
+            // The memos of several expressions, for calculating the next schedules of many tasks at once.
+            // Each memo is shared by the expressions and offsets mapping to it, so usually each expression
+            // is only calculated once per offset however the tasks using it are ordered.
+            struct NextScheduleMemos
+            {
+                // Small enough for the stack, at 20KB.
+                static constexpr size_t bits = 9;
+                static constexpr size_t count = size_t{ 1 } << bits;
+
+                NextScheduleMemo& of(const CronData* data, const TimeZone* zone,
+                                     std::chrono::seconds offset = std::chrono::seconds{ 0 })
+                {
+                    auto key = reinterpret_cast<uintptr_t>(data) ^ (reinterpret_cast<uintptr_t>(zone) >> 3)
+                               ^ static_cast<uintptr_t>(offset.count());
+                    // Fibonacci hashing, as the low bits of addresses are mostly the same.
+                    return memos[(static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ull) >> (64 - bits)];
+                }
+
+                NextScheduleMemo memos[count]{};
+            };
+
+            // Also ends catching up on missed schedules.
             bool calculate_next(std::chrono::system_clock::time_point from);
 
+            // As above, but reuses the result in the memo if it was calculated from the same point in time,
+            // less the offset, for the same shared CronData and zone, and otherwise stores the new result in it.
+            bool calculate_next(std::chrono::system_clock::time_point from, NextScheduleMemo& memo);
+
+            bool calculate_next(std::chrono::system_clock::time_point from, NextScheduleMemos& memos)
+            {
+                return calculate_next(from, memos.of(schedule.get_data().get(), time_zone.get(), offset));
+            }
+
+            // Runs the task this long after each of its schedules, see Cron::set_jitter().
+            // Call calculate_next() afterwards.
+            void set_offset(std::chrono::seconds new_offset)
+            {
+                offset = new_offset;
+            }
+
+            std::chrono::seconds get_offset() const
+            {
+                return offset;
+            }
+
+            // The number of schedules from the next schedule up to and including now, counting at most limit.
+            size_t count_missed(std::chrono::system_clock::time_point now, size_t limit) const;
+
+            // Postpones runs for missed schedules until the given time, by making that the next schedule.
+            // The delay of these runs is relative to the first missed schedule rather than that time.
+            void defer_catch_up(std::chrono::system_clock::time_point until, size_t runs)
+            {
+                if (catch_up_runs == 0)
+                {
+                    missed_schedule = next_schedule;
+                }
+
+                catch_up_runs = runs;
+                next_schedule = until;
+                last_run = until - std::chrono::seconds{ 1 };
+            }
+
+            // Runs that have been deferred by defer_catch_up().
+            size_t get_catch_up_runs() const
+            {
+                return catch_up_runs;
+            }
+
+            // With a zone, the schedule is in its local time and the time of the Cron instance is taken
+            // to be UTC. Call calculate_next() afterwards.
+            void set_time_zone(std::shared_ptr<const TimeZone> zone)
+            {
+                time_zone = std::move(zone);
+            }
+
+            const std::shared_ptr<const TimeZone>& get_time_zone() const
+            {
+                return time_zone;
+            }
+
+            const CronSchedule& get_schedule() const
+            {
+                return schedule;
+            }
+
+            // Call calculate_next() afterwards.
+            void set_schedule(const CronSchedule& new_schedule)
+            {
+                schedule = new_schedule;
+            }
+
+            // Runs already dispatched to an executor keep the work they were dispatched with.
+            void set_work(TaskFunction work)
+            {
+                task = std::move(work);
+            }
+
+            const TaskFunction& get_work() const
+            {
+                return task;
+            }
+
+            // The scheduling state of a task, apart from its name, schedule, zone and work. See Snapshot.
+            struct State
+            {
+                std::chrono::system_clock::time_point next_schedule{};
+                std::chrono::system_clock::time_point last_run{};
+                std::chrono::system_clock::duration delay{};
+                std::chrono::system_clock::time_point missed_schedule{};
+                size_t catch_up_runs = 0;
+                bool valid = false;
+                bool paused = false;
+                OverlapPolicy overlap_policy = OverlapPolicy::Allow;
+            };
+
+            State get_state() const
+            {
+                return State{ next_schedule, last_run, delay, missed_schedule, catch_up_runs, valid, paused, overlap_policy };
+            }
+
+            // Restores the state instead of calculating the next schedule.
+            void set_state(const State& state)
+            {
+                next_schedule = state.next_schedule;
+                last_run = state.last_run;
+                delay = state.delay;
+                missed_schedule = state.missed_schedule;
+                catch_up_runs = state.catch_up_runs;
+                valid = state.valid;
+                paused = state.paused;
+                overlap_policy = state.overlap_policy;
+            }
+
+            // Tasks that never expire are ordered after all others.
             bool operator>(const Task& other) const
             {
-                return next_schedule > other.next_schedule;
+                return get_due_time() > other.get_due_time();
             }
 
             bool operator<(const Task& other) const
             {
-                return next_schedule < other.next_schedule;
+                return get_due_time() < other.get_due_time();
             }
 
             bool is_expired(std::chrono::system_clock::time_point now) const;
 
+            // False if the last calculation of the next schedule failed, in which case the task never expires.
+            bool is_valid() const
+            {
+                return valid;
+            }
+
+            std::chrono::system_clock::time_point get_next_schedule() const
+            {
+                return next_schedule;
+            }
+
+            // The next schedule, or time_point::max() if the task is invalid or paused.
+            std::chrono::system_clock::time_point get_due_time() const
+            {
+                return valid && !paused ? next_schedule : std::chrono::system_clock::time_point::max();
+            }
+
+            // A paused task does not expire until it is resumed. Call calculate_next() after resuming.
+            void pause()
+            {
+                paused = true;
+            }
+
+            void resume()
+            {
+                paused = false;
+            }
+
+            bool is_paused() const
+            {
+                return paused;
+            }
+
+            // Assigned by the task queue.
+            TaskHandle get_handle() const
+            {
+                return handle;
+            }
+
+            void set_handle(TaskHandle new_handle)
+            {
+                handle = new_handle;
+            }
+
             std::chrono::system_clock::duration
             time_until_expiry(std::chrono::system_clock::time_point now) const;
 
-            std::string get_name() const override
+            std::string_view get_name() const override
             {
                 return name;
             }
@@ -70,13 +335,55 @@ namespace libcron
             std::string get_status(std::chrono::system_clock::time_point now) const;
 
         private:
-            std::string name;
-            CronSchedule schedule;
+            friend class RunCompletion;
+
+            // What the work of a task sees when its runs are tracked.
+            class RunInformation;
+
+            // Shared by the runs of a task that may overlap, i.e. are dispatched to an executor or defer their end.
+            struct RunState
+            {
+                std::mutex lock{};
+                bool running = false;
+                // Delay and dispatch time of the queued runs
+                std::deque<std::pair<std::chrono::system_clock::duration, std::chrono::steady_clock::time_point>> queued{};
+            };
+
+            // Marks the task as running, unless it already is, in which case the run is skipped or queued.
+            bool begin_run(const std::shared_ptr<RunState>& state, std::chrono::steady_clock::time_point dispatched);
+
+            // Returns false if the work deferred the end of the run.
+            static bool run_work(std::string_view name, const TaskFunction& work, const std::shared_ptr<RunState>& state,
+                                 std::chrono::system_clock::duration delay);
+
+            // Makes the queued runs, until there are none left or one of them defers its end.
+            static void end_run(std::string_view name, const TaskFunction& work, const std::shared_ptr<RunState>& state);
+
+            bool apply_next(const std::tuple<bool, std::chrono::system_clock::time_point>& result);
+
+            // The schedule the next run is for.
+            std::chrono::system_clock::time_point get_scheduled_time() const
+            {
+                return catch_up_runs > 0 ? missed_schedule : next_schedule;
+            }
+
+            // What ordering, scanning and rescheduling the tasks reads is kept together at the start,
+            // next to the vtable pointer; the rest is mostly used when the task runs.
             std::chrono::system_clock::time_point next_schedule;
+            std::chrono::system_clock::time_point last_run = std::chrono::system_clock::from_time_t(0); // std::numeric_limits<std::chrono::system_clock::time_point>::min();
+            size_t catch_up_runs = 0;
+            bool valid = false;
+            bool paused = false;
+            std::chrono::seconds offset{ 0 };
+            CronSchedule schedule;
+            std::shared_ptr<const TimeZone> time_zone{};
+            std::chrono::system_clock::time_point missed_schedule{};
             std::chrono::system_clock::duration delay = std::chrono::seconds(-1);
+            std::pmr::string name;
             TaskFunction task;
-            bool valid = false;
-            std::chrono::system_clock::time_point last_run = std::chrono::system_clock::from_time_t(0); // std::numeric_limits<std::chrono::system_clock::time_point>::min();
+            TaskHandle handle{};
+            OverlapPolicy overlap_policy = OverlapPolicy::Allow;
+            std::shared_ptr<RunState> run_state{};
     };
 }
 
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <vector>
+
+namespace libcron
+{
+    // Identifies a task within a Cron instance without referring to it by name.
+    // The generation makes a handle to a removed task stale, even if its slot is reused.
+    struct TaskHandle
+    {
+        static constexpr uint32_t invalid_slot = std::numeric_limits<uint32_t>::max();
+
+        uint32_t slot = invalid_slot;
+        uint32_t generation = 0;
+
+        bool is_valid() const
+        {
+            return slot != invalid_slot;
+        }
+
+        bool operator==(const TaskHandle& other) const
+        {
+            return slot == other.slot && generation == other.generation;
+        }
+
+        bool operator!=(const TaskHandle& other) const
+        {
+            return !(*this == other);
+        }
+    };
+
+    // Hands out task handles and maps them to the current index of their task in a queue.
+    class TaskSlots
+    {
+        public:
+            explicit TaskSlots(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+                    : slots(resource), free_slots(resource)
+            {
+            }
+
+            TaskHandle acquire(size_t index)
+            {
+                uint32_t slot;
+
+                if (free_slots.empty())
+                {
+                    slot = static_cast<uint32_t>(slots.size());
+                    slots.emplace_back();
+                    // So that releasing a handle never allocates
+                    free_slots.reserve(slots.capacity());
+                }
+                else
+                {
+                    slot = free_slots.back();
+                    free_slots.pop_back();
+                }
+
+                slots[slot].index = index;
+                slots[slot].used = true;
+
+                return TaskHandle{ slot, slots[slot].generation };
+            }
+
+            void release(TaskHandle handle)
+            {
+                if (is_current(handle))
+                {
+                    auto& s = slots[handle.slot];
+                    s.used = false;
+                    ++s.generation;
+                    free_slots.push_back(handle.slot);
+                }
+            }
+
+            // False if the handle is stale.
+            bool find(TaskHandle handle, size_t& index) const
+            {
+                bool res = is_current(handle);
+
+                if (res)
+                {
+                    index = slots[handle.slot].index;
+                }
+
+                return res;
+            }
+
+            void move(TaskHandle handle, size_t index)
+            {
+                if (is_current(handle))
+                {
+                    slots[handle.slot].index = index;
+                }
+            }
+
+            // Releases all handles.
+            void clear()
+            {
+                for (uint32_t i = 0; i < slots.size(); ++i)
+                {
+                    release(TaskHandle{ i, slots[i].generation });
+                }
+            }
+
+        private:
+            struct Slot
+            {
+                size_t index = 0;
+                uint32_t generation = 0;
+                bool used = false;
+            };
+
+            bool is_current(TaskHandle handle) const
+            {
+                return handle.slot < slots.size()
+                       && slots[handle.slot].used
+                       && slots[handle.slot].generation == handle.generation;
+            }
+
+            std::pmr::vector<Slot> slots;
+            std::pmr::vector<uint32_t> free_slots;
+    };
+}
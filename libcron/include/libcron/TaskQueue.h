@@ -1,23 +1,39 @@
 #pragma once
 
+#include <algorithm>
+#include <chrono>
 #include <vector>
 #include <map>
+#include <memory_resource>
+#include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 #include "Task.h"
+#include "TaskHandle.h"
 
 namespace libcron
 {           
+    // The default queue, a vector of the tasks sorted by due time. Ticking only looks at the front, but
+    // looking up a task by name or handle scans all tasks, i.e. is O(n), as does removing or updating
+    // one. With many tasks that are looked up, use HeapTaskQueue or GroupedTaskQueue, which index the
+    // tasks by name and handle.
     template<typename LockType>
     class TaskQueue
     {
         public:
-            const std::vector<Task>& get_tasks() const
+            // All storage, that of the tasks included, comes from the memory resource.
+            explicit TaskQueue(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+                    : c(resource), order(resource), slots(resource)
+            {
+            }
+
+            const std::pmr::vector<Task>& get_tasks() const
             {
                 return c;
             }
             
-            std::vector<Task>& get_tasks()
+            std::pmr::vector<Task>& get_tasks()
             {
                 return c;
             }
@@ -32,20 +48,79 @@ namespace libcron
                 return c.empty();
             }
             
-            void push(Task& t)
+            // A task with the name of an existing one replaces it, as with the other queues; the replaced
+            // task's handle becomes stale.
+            TaskHandle push(Task&& t)
             {
-                c.push_back(std::move(t));
-            }
-            
-            void push(Task&& t)
-            {
-                c.push_back(std::move(t));
+                auto name = t.get_name();
+                auto existing = std::find_if(c.begin(), c.end(), [name](const Task& to_compare) {
+                                    return name == to_compare.get_name();
+                                    });
+
+                if (existing != c.end())
+                {
+                    erase(existing);
+                }
+
+                auto res = slots.acquire(0);
+                t.set_handle(res);
+
+                // Insert at the right position to keep the queue sorted.
+                auto it = std::upper_bound(c.begin(), c.end(), t, std::less<>());
+                c.insert(it, std::move(t));
+
+                return res;
             }
             
             void push(std::vector<Task>& tasks_to_insert)
             {
-                c.reserve(c.size() + tasks_to_insert.size());
-                c.insert(c.end(), std::make_move_iterator(tasks_to_insert.begin()), std::make_move_iterator(tasks_to_insert.end()));
+                // Of the tasks sharing a name, the last one added is kept, in a single pass over the existing tasks.
+                std::unordered_map<std::string_view, size_t> last_of{};
+                last_of.reserve(tasks_to_insert.size());
+
+                for (size_t i = 0; i < tasks_to_insert.size(); ++i)
+                {
+                    last_of[tasks_to_insert[i].get_name()] = i;
+                }
+
+                auto replaced = std::remove_if(c.begin(), c.end(), [this, &last_of](const Task& t)
+                {
+                    bool res = last_of.count(t.get_name()) > 0;
+
+                    if (res)
+                    {
+                        slots.release(t.get_handle());
+                    }
+
+                    return res;
+                });
+
+                c.erase(replaced, c.end());
+
+                // Decided before moving any task, as the keys refer to their names.
+                std::vector<size_t> kept{};
+                kept.reserve(tasks_to_insert.size());
+
+                for (size_t i = 0; i < tasks_to_insert.size(); ++i)
+                {
+                    if (last_of[tasks_to_insert[i].get_name()] == i)
+                    {
+                        kept.push_back(i);
+                    }
+                }
+
+                c.reserve(c.size() + kept.size());
+                auto first_new = c.end() - c.begin();
+
+                for (auto i : kept)
+                {
+                    tasks_to_insert[i].set_handle(slots.acquire(0));
+                    c.push_back(std::move(tasks_to_insert[i]));
+                }
+
+                // Only the new tasks are sorted, then merged with the already sorted ones.
+                std::sort(c.begin() + first_new, c.end(), std::less<>());
+                std::inplace_merge(c.begin(), c.begin() + first_new, c.end(), std::less<>());
             }
             
             const Task& top() const
@@ -58,31 +133,67 @@ namespace libcron
                 return c[i];
             }
             
+            // Restores the order of the queue after tasks have been modified via get_tasks().
+            // Sorts the due times along with the index of each task rather than the tasks themselves,
+            // then moves each task that is out of place once.
             void sort()
             {
-                std::sort(c.begin(), c.end(), std::less<>());
+                order.clear();
+                order.reserve(c.size());
+
+                for (size_t i = 0; i < c.size(); ++i)
+                {
+                    order.push_back(Entry{ c[i].get_due_time(), i });
+                }
+
+                std::sort(order.begin(), order.end(), [](const Entry& a, const Entry& b)
+                {
+                    return a.due < b.due || (a.due == b.due && a.index < b.index);
+                });
+
+                // Follow each cycle of the permutation, order[i].index being the task that belongs at i.
+                for (size_t i = 0; i < c.size(); ++i)
+                {
+                    if (order[i].index != i)
+                    {
+                        Task t = std::move(c[i]);
+                        auto to = i;
+
+                        while (order[to].index != i)
+                        {
+                            auto from = order[to].index;
+                            c[to] = std::move(c[from]);
+                            order[to].index = to;
+                            to = from;
+                        }
+
+                        c[to] = std::move(t);
+                        order[to].index = to;
+                    }
+                }
             }
             
             void clear()
             {
                 lock.lock();
                 c.clear();
+                slots.clear();
                 lock.unlock();
             }
             
             void remove(Task& to_remove)
             {
                 auto it = std::find_if(c.begin(), c.end(), [&to_remove] (const Task& to_compare) { 
-                                    return to_remove.get_name() == to_compare;
+                                    return to_remove.get_name() == to_compare.get_name();
                                     });
                 
                 if (it != c.end())
                 {
-                    c.erase(it);
+                    erase(it);
                 }
             }
 
-            void remove(std::string to_remove)
+            void remove(const std::string& to_remove)
             {
                 lock.lock();
                 auto it = std::find_if(c.begin(), c.end(), [&to_remove] (const Task& to_compare) { 
@@ -90,26 +201,170 @@ namespace libcron
                                     });
                 if (it != c.end())
                 {
-                    c.erase(it);
+                    erase(it);
                 } 
                 
                 lock.unlock();
             }
+
+            void remove(TaskHandle to_remove)
+            {
+                lock.lock();
+                auto it = find(to_remove);
+
+                if (it != c.end())
+                {
+                    erase(it);
+                }
+
+                lock.unlock();
+            }
             
-            void lock_queue()
+            bool contains(const std::string& name) const
+            {
+                return find(name) != c.end();
+            }
+
+            bool contains(TaskHandle handle) const
+            {
+                return find(handle) != c.end();
+            }
+
+            // Returns nullptr if the handle is stale.
+            const Task* get(TaskHandle handle) const
+            {
+                auto it = find(handle);
+                return it != c.end() ? &*it : nullptr;
+            }
+
+            // Returns nullptr if there is no such task.
+            const Task* get(const std::string& name) const
+            {
+                auto it = find(name);
+                return it != c.end() ? &*it : nullptr;
+            }
+
+            // Calls func on the task with the given name or handle, removing the task if func returns false.
+            // Returns false if there is no such task.
+            template<typename Key, typename Func>
+            bool update(const Key& key, Func&& func)
+            {
+                auto it = find(key);
+                bool res = it != c.end();
+
+                if (res)
+                {
+                    if (func(*it))
+                    {
+                        // Move the task to its new position.
+                        Task t = std::move(*it);
+                        c.erase(it);
+                        c.insert(std::upper_bound(c.begin(), c.end(), t, std::less<>()), std::move(t));
+                    }
+                    else
+                    {
+                        erase(it);
+                    }
+                }
+
+                return res;
+            }
+
+            // Calls func for each expired task, removing the task if func returns false.
+            template<typename Func>
+            size_t for_each_expired(std::chrono::system_clock::time_point now, Func&& func)
+            {
+                size_t res = 0;
+
+                for (size_t i = 0; i < c.size();)
+                {
+                    bool keep = true;
+
+                    if (c[i].is_expired(now))
+                    {
+                        keep = func(c[i]);
+                        res++;
+                    }
+
+                    if (keep)
+                    {
+                        i++;
+                    }
+                    else
+                    {
+                        erase(c.begin() + static_cast<std::ptrdiff_t>(i));
+                    }
+                }
+
+                // Only sort if at least one task was executed
+                if (res > 0)
+                {
+                    sort();
+                }
+
+                return res;
+            }
+
+            void lock_queue() const
             {
                 /* Do not allow to manipulate the Queue */
                 lock.lock();
             }
             
-            void release_queue()
+            void release_queue() const
             {
                 /* Allow Access to the Queue Manipulating-Functions */
                 lock.unlock();
             }
             
         private:
-            LockType lock;
-            std::vector<Task> c;
+            // Linear scans, see the class comment.
+            std::pmr::vector<Task>::const_iterator find(const std::string& name) const
+            {
+                return std::find_if(c.begin(), c.end(), [&name] (const Task& to_compare) {
+                                    return name == to_compare;
+                                    });
+            }
+
+            std::pmr::vector<Task>::iterator find(const std::string& name)
+            {
+                return std::find_if(c.begin(), c.end(), [&name] (const Task& to_compare) {
+                                    return name == to_compare;
+                                    });
+            }
+
+            // A linear scan, as the slots don't know where in the vector their task is. The generation in
+            // the handle still tells a stale handle from one whose slot has been reused.
+            std::pmr::vector<Task>::const_iterator find(TaskHandle handle) const
+            {
+                return std::find_if(c.begin(), c.end(), [handle] (const Task& to_compare) {
+                                    return handle == to_compare.get_handle();
+                                    });
+            }
+
+            std::pmr::vector<Task>::iterator find(TaskHandle handle)
+            {
+                return std::find_if(c.begin(), c.end(), [handle] (const Task& to_compare) {
+                                    return handle == to_compare.get_handle();
+                                    });
+            }
+
+            void erase(std::pmr::vector<Task>::iterator it)
+            {
+                slots.release(it->get_handle());
+                c.erase(it);
+            }
+
+            struct Entry
+            {
+                std::chrono::system_clock::time_point due;
+                size_t index;
+            };
+
+            mutable LockType lock;
+            std::pmr::vector<Task> c;
+            // Kept between sorts, so that sorting needn't allocate.
+            std::pmr::vector<Entry> order;
+            TaskSlots slots;
     };
 }
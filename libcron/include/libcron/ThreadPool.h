@@ -0,0 +1,53 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace libcron
+{
+    // Runs a job, usually on another thread. See Cron(Executor).
+    using Executor = std::function<void(std::function<void()>)>;
+
+    // A fixed number of threads working through the posted jobs in order.
+    // The destructor waits for all posted jobs to finish.
+    class ThreadPool
+    {
+        public:
+            explicit ThreadPool(size_t number_of_threads = std::thread::hardware_concurrency());
+
+            ~ThreadPool();
+
+            ThreadPool(const ThreadPool&) = delete;
+
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            void post(std::function<void()> job);
+
+            // An executor posting to this pool, which must outlive it.
+            Executor get_executor()
+            {
+                return [this](std::function<void()> job)
+                {
+                    post(std::move(job));
+                };
+            }
+
+            size_t size() const
+            {
+                return threads.size();
+            }
+
+        private:
+            void work();
+
+            std::mutex lock{};
+            std::condition_variable available{};
+            std::deque<std::function<void()>> jobs{};
+            bool stopping = false;
+            std::vector<std::thread> threads{};
+    };
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace libcron
+{
+    // The UTC offsets of a time zone from the IANA time zone database and when they change.
+    //
+    // Local times are expressed as system_clock time points shifted by the UTC offset, as with
+    // LocalClock. Converting a local time to UTC is ambiguous around transitions, which is resolved as:
+    //  - A local time skipped by a transition, e.g. 02:30 when clocks go from 02:00 to 03:00,
+    //    becomes the moment of the transition.
+    //  - A local time that occurs twice, e.g. 02:30 when clocks go from 03:00 back to 02:00,
+    //    becomes its first occurrence.
+    class TimeZone
+    {
+        public:
+            // A span of time with the same UTC offset, from begin up to but not including end, in UTC.
+            struct Period
+            {
+                std::chrono::system_clock::time_point begin;
+                std::chrono::system_clock::time_point end;
+                std::chrono::seconds offset;
+            };
+
+            // Loads a zone, e.g. "Europe/Berlin", from the zone info directory. Zones are loaded once and
+            // then shared by all callers. Returns nullptr if there is no such zone, which is also the case
+            // for every zone but UTC where there is no zone info directory, e.g. on Windows; use
+            // set_zoneinfo_directory() or from_posix() there.
+            static std::shared_ptr<const TimeZone> locate(const std::string& name);
+
+            // A zone following a POSIX TZ rule, e.g. "CET-1CEST,M3.5.0,M10.5.0/3". Returns nullptr if the rule is invalid.
+            static std::shared_ptr<const TimeZone> from_posix(const std::string& name, const std::string& rule);
+
+            static std::shared_ptr<const TimeZone> utc();
+
+            // Where locate() looks for zones. Defaults to $TZDIR, or /usr/share/zoneinfo if it isn't set.
+            // Zones already loaded are kept.
+            static void set_zoneinfo_directory(std::string directory);
+
+            const std::string& get_name() const
+            {
+                return name;
+            }
+
+            // The period containing the given UTC point in time.
+            Period get_period(std::chrono::system_clock::time_point utc) const;
+
+            std::chrono::seconds utc_offset(std::chrono::system_clock::time_point utc) const
+            {
+                return get_period(utc).offset;
+            }
+
+            std::chrono::system_clock::time_point to_local(std::chrono::system_clock::time_point utc) const
+            {
+                return utc + utc_offset(utc);
+            }
+
+            std::chrono::system_clock::time_point to_utc(std::chrono::system_clock::time_point local) const;
+
+        private:
+            friend class ZonedClock;
+
+            // The rule of a POSIX TZ string, which continues the transitions listed in a zone info file.
+            struct Rule
+            {
+                struct Date
+                {
+                    char kind = 'M';    // 'M' for Mm.w.d, 'J' for Jn, 'N' for n
+                    int month = 0;
+                    int week = 0;
+                    int day = 0;
+                    std::chrono::seconds time{ 7200 };
+                };
+
+                std::chrono::seconds std_offset{};
+                std::chrono::seconds dst_offset{};
+                bool has_dst = false;
+                Date start{};
+                Date end{};
+            };
+
+            static constexpr size_t no_period = static_cast<size_t>(-1);
+
+            TimeZone(std::string name, Rule rule)
+                    : name(std::move(name)), rule(rule)
+            {
+            }
+
+            static bool parse_rule(const std::string& text, Rule& rule);
+
+            static std::shared_ptr<const TimeZone> load(const std::string& name, const std::string& path);
+
+            // Adds the periods following from the rule up to last_stored_year.
+            void extend_periods();
+
+            // The transitions of the rule within the given year, in order, with the offset they change to.
+            void rule_transitions(int in_year,
+                                  std::pair<std::chrono::system_clock::time_point, std::chrono::seconds>* transitions) const;
+
+            // The index of the stored period containing utc, or no_period if it is beyond them.
+            size_t find_period(std::chrono::system_clock::time_point utc) const;
+
+            bool contains(size_t index, std::chrono::system_clock::time_point utc) const
+            {
+                return index < periods.size() && periods[index].begin <= utc && utc < periods[index].end;
+            }
+
+            std::string name;
+            Rule rule;
+            // In order, covering all time up to the end of the last one. Later periods follow from the rule.
+            std::vector<Period> periods{};
+    };
+}
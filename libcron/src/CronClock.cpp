@@ -36,4 +36,50 @@ namespace libcron
 #endif
 		return offset;
 	}
-}
\ No newline at end of file
+
+	bool ZonedClock::set_time_zone(const std::string& name)
+	{
+		auto located = TimeZone::locate(name);
+		bool res = located != nullptr;
+
+		if (res)
+		{
+			set_time_zone(located);
+		}
+
+		return res;
+	}
+
+	void ZonedClock::set_time_zone(std::shared_ptr<const TimeZone> new_zone)
+	{
+		zone = new_zone ? std::move(new_zone) : TimeZone::utc();
+		cached_period = 0;
+	}
+
+	std::chrono::seconds ZonedClock::utc_offset(std::chrono::system_clock::time_point now) const
+	{
+		seconds offset;
+		auto index = cached_period.load(std::memory_order_relaxed);
+
+		if (zone->contains(index, now))
+		{
+			offset = zone->periods[index].offset;
+		}
+		else
+		{
+			index = zone->find_period(now);
+
+			if (index != TimeZone::no_period)
+			{
+				cached_period.store(index, std::memory_order_relaxed);
+				offset = zone->periods[index].offset;
+			}
+			else
+			{
+				offset = zone->utc_offset(now);
+			}
+		}
+
+		return offset;
+	}
+}
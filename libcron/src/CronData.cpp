@@ -1,12 +1,16 @@
-#ifdef __cplusplus > 201703L
+#if __cplusplus > 201703L
 #include <chrono>
 #else
 #include <date/date.h>
 #endif
+#include <algorithm>
+#include <cctype>
+#include <limits>
 #include "libcron/CronData.h"
+#include "libcron/CronDataCache.h"
 
 using namespace std::chrono;
-#ifdef __cplusplus > 201703L
+#if __cplusplus > 201703L
 #else
 using namespace date;
 #endif
@@ -23,83 +27,214 @@ namespace libcron
 
     const std::vector<std::string> CronData::month_names{ "JAN", "FEB", "MAR", "APR", "MAY", "JUN", "JUL", "AUG", "SEP", "OCT", "NOV", "DEC" };
     const std::vector<std::string> CronData::day_names{ "SUN", "MON", "TUE", "WED", "THU", "FRI", "SAT" };
-    std::unordered_map<std::string, CronData> CronData::cache{};
+
+    CronData::CronData(CronField<Seconds> seconds, CronField<Minutes> minutes, CronField<Hours> hours,
+                       CronField<DayOfMonth> day_of_month, CronField<Months> months, CronField<DayOfWeek> day_of_week)
+            : seconds(seconds), minutes(minutes), hours(hours), day_of_month(day_of_month), months(months),
+              day_of_week(day_of_week)
+    {
+        valid = is_within_limits(seconds) && is_within_limits(minutes) && is_within_limits(hours)
+                && is_within_limits(day_of_month) && is_within_limits(months) && is_within_limits(day_of_week)
+                && validate_date_vs_months();
+    }
 
     CronData CronData::create(const std::string& cron_expression)
     {
-        CronData c;
-        auto found = cache.find(cron_expression);
+        return *create_shared(cron_expression);
+    }
 
-        if (found == cache.end())
-        {
-            c.parse(cron_expression);
-            cache[cron_expression] = c;
-        }
-        else
-        {
-            c = found->second;
-        }
-        
-        return c;
+    std::shared_ptr<const CronData> CronData::create_shared(const std::string& cron_expression)
+    {
+        return CronDataCache::global().get(cron_expression);
     }
 
     void CronData::parse(const std::string& cron_expression)
     {
         // First, check for "convenience scheduling" using @yearly, @annually,
         // @monthly, @weekly, @daily or @hourly.
-        std::string tmp = std::regex_replace(cron_expression, std::regex("@yearly"), "0 0 1 1 *");
-        tmp = std::regex_replace(tmp, std::regex("@annually"), "0 0 1 1 *");
-        tmp = std::regex_replace(tmp, std::regex("@monthly"), "0 0 1 * *");
-        tmp = std::regex_replace(tmp, std::regex("@weekly"), "0 0 * * 0");
-        tmp = std::regex_replace(tmp, std::regex("@daily"), "0 0 * * *");
-        const std::string expression = std::regex_replace(tmp, std::regex("@hourly"), "0 * * * *");
+        std::string expanded;
+        std::string_view expression = cron_expression;
 
-        // Second, split on white-space. We expect six parts.
-        std::regex split{ R"#(^\s*(.*?)\s+(.*?)\s+(.*?)\s+(.*?)\s+(.*?)\s+(.*?)\s*$)#",
-                          std::regex_constants::ECMAScript };
+        if (expression.find('@') != std::string_view::npos)
+        {
+            expanded = expand_convenience_schedules(expression);
+            expression = expanded;
+        }
 
-        std::smatch match;
+        // Second, split on white-space. We expect six parts.
+        std::string_view fields[6];
 
-        if (std::regex_match(expression.begin(), expression.end(), match, split))
+        if (split_fields(expression, fields))
         {
-            valid = validate_numeric<Seconds>(match[1], seconds);
-            valid &= validate_numeric<Minutes>(match[2], minutes);
-            valid &= validate_numeric<Hours>(match[3], hours);
-            valid &= validate_numeric<DayOfMonth>(match[4], day_of_month);
-            valid &= validate_literal<Months>(match[5], months, month_names);
-            valid &= validate_literal<DayOfWeek>(match[6], day_of_week, day_names);
-            valid &= check_dom_vs_dow(match[4], match[6]);
-            valid &= validate_date_vs_months();
+            parse_fields(fields);
         }
     }
 
-    std::vector<std::string> CronData::split(const std::string& s, char token)
+    void CronData::parse_fields(const std::string_view (&fields)[6])
+    {
+        valid = validate_numeric<Seconds>(fields[0], seconds);
+        valid &= validate_numeric<Minutes>(fields[1], minutes);
+        valid &= validate_numeric<Hours>(fields[2], hours);
+        valid &= validate_numeric<DayOfMonth>(fields[3], day_of_month);
+        valid &= validate_literal<Months>(fields[4], months, month_names);
+        valid &= validate_literal<DayOfWeek>(fields[5], day_of_week, day_names);
+        valid &= check_dom_vs_dow(fields[3], fields[5]);
+        valid &= validate_date_vs_months();
+    }
+
+    std::string CronData::expand_convenience_schedules(std::string_view s)
     {
-        std::vector<std::string> res;
+        static const std::pair<std::string_view, std::string_view> convenience[] = {
+                { "@yearly",   "0 0 1 1 *" },
+                { "@annually", "0 0 1 1 *" },
+                { "@monthly",  "0 0 1 * *" },
+                { "@weekly",   "0 0 * * 0" },
+                { "@daily",    "0 0 * * *" },
+                { "@hourly",   "0 * * * *" }};
 
-        std::string r = "[";
-        r += token;
-        r += "]";
-        std::regex splitter{ r, std::regex_constants::ECMAScript };
+        std::string res;
+        res.reserve(s.size() + 8);
 
-        std::copy(std::sregex_token_iterator(s.begin(), s.end(), splitter, -1),
-                  std::sregex_token_iterator(),
-                  std::back_inserter(res));
+        for (size_t i = 0; i < s.size();)
+        {
+            bool replaced = false;
+
+            if (s[i] == '@')
+            {
+                for (const auto& [token, replacement] : convenience)
+                {
+                    if (!replaced && s.compare(i, token.size(), token) == 0)
+                    {
+                        res += replacement;
+                        i += token.size();
+                        replaced = true;
+                    }
+                }
+            }
+
+            if (!replaced)
+            {
+                res += s[i++];
+            }
+        }
 
         return res;
     }
 
-    bool CronData::is_number(const std::string& s)
+    bool CronData::split_fields(std::string_view s, std::string_view (&fields)[6])
+    {
+        size_t count = 0;
+        size_t i = 0;
+
+        while (count <= 6 && i < s.size())
+        {
+            // Skip leading white-space, then take everything up to the next white-space as a field.
+            while (i < s.size() && is_space(s[i]))
+            {
+                ++i;
+            }
+
+            auto start = i;
+
+            while (i < s.size() && !is_space(s[i]))
+            {
+                ++i;
+            }
+
+            if (i > start)
+            {
+                if (count < 6)
+                {
+                    fields[count] = s.substr(start, i - start);
+                }
+
+                ++count;
+            }
+        }
+
+        return count == 6;
+    }
+
+    bool CronData::replace_names(std::string_view s,
+                                 const std::vector<std::string>& names,
+                                 int value_of_first_name,
+                                 std::string& replaced)
+    {
+        auto is_alpha = [](char c)
+                        {
+                            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+                        };
+
+        bool has_names = std::find_if(s.begin(), s.end(), is_alpha) != s.end();
+
+        if (has_names)
+        {
+            replaced.clear();
+
+            for (size_t i = 0; i < s.size();)
+            {
+                bool found = false;
+
+                for (size_t n = 0; !found && n < names.size(); ++n)
+                {
+                    const auto& name = names[n];
+
+                    found = s.size() - i >= name.size()
+                            && std::equal(name.begin(), name.end(), s.begin() + static_cast<std::ptrdiff_t>(i),
+                                          [](char l, char r)
+                                          {
+                                              return l == std::toupper(static_cast<unsigned char>(r));
+                                          });
+
+                    if (found)
+                    {
+                        replaced += std::to_string(value_of_first_name + static_cast<int>(n));
+                        i += name.size();
+                    }
+                }
+
+                if (!found)
+                {
+                    replaced += s[i++];
+                }
+            }
+        }
+
+        return has_names;
+    }
+
+    bool CronData::is_number(std::string_view s)
     {
         // Find any character that isn't a number.
         return !s.empty()
                && std::find_if(s.begin(), s.end(),
                                [](char c)
                                {
-                                   return !std::isdigit(c);
+                                   return c < '0' || c > '9';
                                }) == s.end();
     }
 
+    bool CronData::to_number(std::string_view s, int32_t& value)
+    {
+        bool res = is_number(s);
+        int64_t v = 0;
+
+        for (size_t i = 0; res && i < s.size(); ++i)
+        {
+            v = v * 10 + (s[i] - '0');
+
+            // Numbers that don't fit are rejected rather than silently wrapped.
+            res = v <= std::numeric_limits<int32_t>::max();
+        }
+
+        if (res)
+        {
+            value = static_cast<int32_t>(v);
+        }
+
+        return res;
+    }
+
     bool CronData::is_between(int32_t value, int32_t low_limit, int32_t high_limt)
     {
         return value >= low_limit && value <= high_limt;
@@ -110,7 +245,7 @@ namespace libcron
         bool res = true;
 
         // Verify that the available dates are possible based on the given months
-        if (months.size() == 1 && months.find(static_cast<Months>(2)) != months.end())
+        if (months.size() == 1 && months.contains(Months::February))
         {
             // Only february allowed, make sure that the allowed date(s) includes 29 and below.
             res = has_any_in_range(day_of_month, 1, 29);
@@ -119,13 +254,13 @@ namespace libcron
         if (res)
         {
             // Make sure that if the days contains only 31, at least one month allows that date.
-            if (day_of_month.size() == 1 && day_of_month.find(DayOfMonth::Last) != day_of_month.end())
+            if (day_of_month.size() == 1 && day_of_month.contains(DayOfMonth::Last))
             {
                 res = false;
 
                 for (size_t i = 0; !res && i < NUMBER_OF_LONG_MONTHS; ++i)
                 {
-                    res = months.find(months_with_31[i]) != months.end();
+                    res = months.contains(months_with_31[i]);
                 }
             }
         }
@@ -133,7 +268,7 @@ namespace libcron
         return res;
     }
 
-    bool CronData::check_dom_vs_dow(const std::string& dom, const std::string& dow) const
+    bool CronData::check_dom_vs_dow(std::string_view dom, std::string_view dow) const
     {
         // Day of month and day of week are mutually exclusive so one of them must at always be ignored using
         // the '?'-character unless one field already is something other than '*'.
@@ -142,7 +277,7 @@ namespace libcron
         // as ignored. To make it explicit to the user of the library, we do however require the use of
         // '?' as the ignore flag, although it is functionally equivalent to '*'.
 
-        auto check = [](const std::string& l, std::string r)
+        auto check = [](std::string_view l, std::string_view r)
                      {
                          return l == "*" && (r != "*" || r == "?");
                      };
@@ -0,0 +1,200 @@
+#include "libcron/CronDataCache.h"
+#include <iterator>
+
+namespace libcron
+{
+    CronDataCache::CronDataCache(size_t capacity)
+    {
+        set_capacity(capacity);
+    }
+
+    CronDataCache& CronDataCache::global()
+    {
+        static CronDataCache cache{};
+        return cache;
+    }
+
+    std::shared_ptr<const CronData> CronDataCache::get(const std::string& cron_expression)
+    {
+        auto& shard = shard_of(cron_expression);
+        std::shared_ptr<const CronData> res;
+        bool parsed_here = false;
+
+        {
+            std::lock_guard<std::mutex> guard{ shard.lock };
+            auto found = shard.index.find(cron_expression);
+
+            if (found != shard.index.end())
+            {
+                shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+                res = found->second->second;
+            }
+        }
+
+        if (res)
+        {
+            hits.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            misses.fetch_add(1, std::memory_order_relaxed);
+
+            // Parse without holding the lock; if another thread parsed the same expression
+            // meanwhile, its result is used instead so that there is only one shared instance.
+            auto parsed = std::make_shared<const CronData>(cron_expression);
+
+            std::lock_guard<std::mutex> guard{ shard.lock };
+            auto found = shard.index.find(cron_expression);
+
+            if (found != shard.index.end())
+            {
+                res = found->second->second;
+            }
+            else
+            {
+                res = parsed;
+                parsed_here = true;
+
+                if (shard.capacity > 0)
+                {
+                    shard.entries.emplace_front(cron_expression, std::move(parsed));
+                    shard.index.emplace(shard.entries.front().first, shard.entries.begin());
+                    shard.evict();
+                }
+            }
+        }
+
+        if (parsed_here)
+        {
+            remember(res);
+        }
+
+        return res;
+    }
+
+    std::shared_ptr<const CronData> CronDataCache::intern(const CronData& data)
+    {
+        std::shared_ptr<const CronData> res{};
+
+        if (remembering.load(std::memory_order_relaxed))
+        {
+            std::lock_guard<std::mutex> guard{ values_lock };
+            auto found = values.find(data);
+
+            if (found != values.end())
+            {
+                res = found->second.lock();
+            }
+        }
+
+        if (!res)
+        {
+            res = std::make_shared<const CronData>(data);
+            remember(res);
+        }
+
+        return res;
+    }
+
+    void CronDataCache::remember(const std::shared_ptr<const CronData>& data)
+    {
+        if (data->is_valid() && remembering.load(std::memory_order_relaxed))
+        {
+            std::lock_guard<std::mutex> guard{ values_lock };
+            auto& known = values[*data];
+
+            if (known.expired())
+            {
+                known = data;
+            }
+
+            if (values.size() > 2 * values_swept + 64)
+            {
+                for (auto it = values.begin(); it != values.end();)
+                {
+                    it = it->second.expired() ? values.erase(it) : std::next(it);
+                }
+
+                values_swept = values.size();
+            }
+        }
+    }
+
+    CronDataCache::Statistics CronDataCache::get_statistics() const
+    {
+        size_t size = 0;
+
+        for (auto& shard : shards)
+        {
+            std::lock_guard<std::mutex> guard{ shard.lock };
+            size += shard.entries.size();
+        }
+
+        return Statistics{ hits.load(std::memory_order_relaxed), misses.load(std::memory_order_relaxed), size };
+    }
+
+    void CronDataCache::set_capacity(size_t capacity)
+    {
+        auto per_shard = (capacity + number_of_shards - 1) / number_of_shards;
+
+        for (auto& shard : shards)
+        {
+            std::lock_guard<std::mutex> guard{ shard.lock };
+            shard.capacity = per_shard;
+            shard.evict();
+        }
+
+        std::lock_guard<std::mutex> guard{ values_lock };
+        remembering = capacity > 0;
+
+        if (!remembering)
+        {
+            values.clear();
+            values_swept = 0;
+        }
+    }
+
+    void CronDataCache::clear()
+    {
+        for (auto& shard : shards)
+        {
+            std::lock_guard<std::mutex> guard{ shard.lock };
+            shard.index.clear();
+            shard.entries.clear();
+        }
+
+        {
+            std::lock_guard<std::mutex> guard{ values_lock };
+            values.clear();
+            values_swept = 0;
+        }
+
+        hits = 0;
+        misses = 0;
+    }
+
+    void CronDataCache::Shard::evict()
+    {
+        while (entries.size() > capacity)
+        {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+    }
+
+    size_t CronDataCache::ValueHash::operator()(const CronData& data) const
+    {
+        size_t res = std::hash<uint64_t>{}(data.get_seconds().get_bits());
+        res = res * 31 + std::hash<uint64_t>{}(data.get_minutes().get_bits());
+        res = res * 31 + std::hash<uint32_t>{}(data.get_hours().get_bits());
+        res = res * 31 + std::hash<uint32_t>{}(data.get_day_of_month().get_bits());
+        res = res * 31 + std::hash<uint16_t>{}(data.get_months().get_bits());
+        res = res * 31 + std::hash<uint8_t>{}(data.get_day_of_week().get_bits());
+        return res;
+    }
+
+    CronDataCache::Shard& CronDataCache::shard_of(const std::string& cron_expression)
+    {
+        return shards[std::hash<std::string>{}(cron_expression) % number_of_shards];
+    }
+}
@@ -0,0 +1,98 @@
+#include "libcron/CronObserver.h"
+#include "libcron/CronDataCache.h"
+
+using namespace std::chrono;
+
+namespace libcron
+{
+    namespace
+    {
+        // Counters are only written by the ticking thread and read on their own, so no ordering is needed.
+        constexpr auto relaxed = std::memory_order_relaxed;
+
+        template<typename Duration>
+        int64_t to_nanoseconds(Duration d)
+        {
+            return duration_cast<nanoseconds>(d).count();
+        }
+    }
+
+    void CronMetrics::on_tick(steady_clock::duration wait, steady_clock::duration duration, size_t tasks, size_t expired_tasks)
+    {
+        auto d = to_nanoseconds(duration);
+        ticks.fetch_add(1, relaxed);
+        tick_time.fetch_add(d, relaxed);
+        lock_wait.fetch_add(to_nanoseconds(wait), relaxed);
+        tasks_scanned.fetch_add(tasks, relaxed);
+        expired.fetch_add(expired_tasks, relaxed);
+
+        auto longest = longest_tick.load(relaxed);
+        while (d > longest && !longest_tick.compare_exchange_weak(longest, d, relaxed))
+        {
+        }
+    }
+
+    void CronMetrics::on_fire(std::string_view, system_clock::duration delay)
+    {
+        size_t bucket = 0;
+
+        while (bucket < std::size(delay_bounds) && delay > delay_bounds[bucket])
+        {
+            ++bucket;
+        }
+
+        fired.fetch_add(1, relaxed);
+        delays[bucket].fetch_add(1, relaxed);
+    }
+
+    void CronMetrics::on_run(std::string_view, steady_clock::duration duration)
+    {
+        runs.fetch_add(1, relaxed);
+        run_time.fetch_add(to_nanoseconds(duration), relaxed);
+    }
+
+    CronMetrics::Values CronMetrics::get() const
+    {
+        Values res{};
+        res.ticks = ticks.load(relaxed);
+        res.tick_time = nanoseconds{ tick_time.load(relaxed) };
+        res.longest_tick = nanoseconds{ longest_tick.load(relaxed) };
+        res.lock_wait = nanoseconds{ lock_wait.load(relaxed) };
+        res.tasks_scanned = tasks_scanned.load(relaxed);
+        res.expired = expired.load(relaxed);
+        res.fired = fired.load(relaxed);
+
+        for (size_t i = 0; i < delay_buckets; ++i)
+        {
+            res.delays[i] = delays[i].load(relaxed);
+        }
+
+        res.runs = runs.load(relaxed);
+        res.run_time = nanoseconds{ run_time.load(relaxed) };
+
+        auto cache = CronDataCache::global().get_statistics();
+        res.cache_hits = cache.hits;
+        res.cache_misses = cache.misses;
+
+        return res;
+    }
+
+    void CronMetrics::reset()
+    {
+        ticks.store(0, relaxed);
+        tick_time.store(0, relaxed);
+        longest_tick.store(0, relaxed);
+        lock_wait.store(0, relaxed);
+        tasks_scanned.store(0, relaxed);
+        expired.store(0, relaxed);
+        fired.store(0, relaxed);
+
+        for (auto& d : delays)
+        {
+            d.store(0, relaxed);
+        }
+
+        runs.store(0, relaxed);
+        run_time.store(0, relaxed);
+    }
+}
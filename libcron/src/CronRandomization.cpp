@@ -1,8 +1,5 @@
 #include <libcron/CronRandomization.h>
 
-#include <regex>
-#include <map>
-#include <array>
 #include <algorithm>
 #include <iterator>
 #include <libcron/TimeTypes.h>
@@ -10,105 +7,279 @@
 
 namespace libcron
 {
+    namespace
+    {
+        bool is_space(char c)
+        {
+            return c == ' ' || (c >= '\t' && c <= '\r');
+        }
+
+        // Six sections separated by white-space, the last one being the rest of the expression.
+        bool split(std::string_view s, std::string_view (&sections)[6])
+        {
+            size_t i = 0;
+            bool res = true;
+
+            for (size_t n = 0; res && n < 6; ++n)
+            {
+                while (i < s.size() && is_space(s[i]))
+                {
+                    ++i;
+                }
+
+                auto start = i;
+
+                if (n < 5)
+                {
+                    while (i < s.size() && !is_space(s[i]))
+                    {
+                        ++i;
+                    }
+                }
+                else
+                {
+                    i = s.size();
+
+                    while (i > start && is_space(s[i - 1]))
+                    {
+                        --i;
+                    }
+                }
+
+                sections[n] = s.substr(start, i - start);
+                res = i > start;
+            }
+
+            return res;
+        }
+
+        bool to_number(std::string_view s, int& value)
+        {
+            bool res = !s.empty() && s.size() <= 9;
+            value = 0;
+
+            for (size_t i = 0; res && i < s.size(); ++i)
+            {
+                res = s[i] >= '0' && s[i] <= '9';
+                value = value * 10 + (s[i] - '0');
+            }
+
+            return res;
+        }
+
+        // R(<left>-<right>)
+        bool get_random_range(std::string_view s, int& left, int& right)
+        {
+            bool res = s.size() >= 6 && (s[0] == 'R' || s[0] == 'r') && s[1] == '(' && s.back() == ')';
+
+            if (res)
+            {
+                auto range = s.substr(2, s.size() - 3);
+                auto dash = range.find('-');
+                res = dash != std::string_view::npos
+                      && to_number(range.substr(0, dash), left)
+                      && to_number(range.substr(dash + 1), right);
+            }
+
+            return res;
+        }
+
+        // splitmix64, which is fully defined unlike the distributions of <random>.
+        uint64_t mix(uint64_t z)
+        {
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            return z ^ (z >> 31);
+        }
+    }
+
     CronRandomization::CronRandomization()
-            : twister(rd())
+            : twister(std::random_device{}())
     {
     }
 
-    std::tuple<bool, std::string> CronRandomization::parse(const std::string& cron_schedule)
+    CronRandomization::CronRandomization(uint32_t seed)
+            : twister(seed)
     {
-        // Split on space to get each separate part, six parts expected
-        const std::regex split{ R"#(^\s*(.*?)\s+(.*?)\s+(.*?)\s+(.*?)\s+(.*?)\s+(.*?)\s*$)#",
-                                std::regex_constants::ECMAScript };
+    }
 
-        std::smatch all_sections;
-        auto res = std::regex_match(cron_schedule.cbegin(), cron_schedule.cend(), all_sections, split);
+    std::tuple<bool, std::string> CronRandomization::parse(const std::string& cron_schedule)
+    {
+        Sections sections;
+        std::string final_cron_schedule{};
 
-        // Replace text with numbers
-        std::string working_copy{};
+        auto res = randomize(cron_schedule, [this](int count)
+        {
+            std::uniform_int_distribution<> dis(0, count - 1);
+            return dis(twister);
+        }, sections);
 
         if (res)
         {
-            // Merge seconds, minutes, hours and day of month back together
-            working_copy += all_sections[1].str();
-            working_copy += " ";
-            working_copy += all_sections[2].str();
-            working_copy += " ";
-            working_copy += all_sections[3].str();
-            working_copy += " ";
-            working_copy += all_sections[4].str();
-            working_copy += " ";
-
-            // Replace month names
-            auto month = all_sections[5].str();
-            CronData::replace_string_name_with_numeric<libcron::Months>(month);
-
-            working_copy += " ";
-            working_copy += month;
-
-            // Replace day names
-            auto dow = all_sections[6].str();
-            CronData::replace_string_name_with_numeric<libcron::DayOfWeek>(dow);
-
-            working_copy += " ";
-            working_copy += dow;
+            for (const auto& s : sections)
+            {
+                if (!final_cron_schedule.empty())
+                {
+                    final_cron_schedule += " ";
+                }
+
+                final_cron_schedule += s.text;
+            }
         }
 
-        std::string final_cron_schedule{};
+        return { res, final_cron_schedule };
+    }
 
-        // Split again on space
-        res = res && std::regex_match(working_copy.cbegin(), working_copy.cend(), all_sections, split);
+    CronData CronRandomization::create(const std::string& cron_schedule)
+    {
+        Sections sections;
+
+        auto res = randomize(cron_schedule, [this](int count)
+        {
+            std::uniform_int_distribution<> dis(0, count - 1);
+            return dis(twister);
+        }, sections);
+
+        return res ? to_data(sections) : CronData{};
+    }
+
+    CronData CronRandomization::create(const std::string& cron_schedule, uint64_t seed, std::string_view key)
+    {
+        // FNV-1a of the key, so that the schedules don't depend on the platform's std::hash.
+        uint64_t state = 0xcbf29ce484222325ull;
+
+        for (auto c : key)
+        {
+            state = (state ^ static_cast<uint8_t>(c)) * 0x100000001b3ull;
+        }
+
+        state = mix(state ^ mix(seed));
+        Sections sections;
+
+        auto res = randomize(cron_schedule, [&state](int count)
+        {
+            state += 0x9e3779b97f4a7c15ull;
+            return static_cast<int>(mix(state) % static_cast<uint64_t>(count));
+        }, sections);
+
+        return res ? to_data(sections) : CronData{};
+    }
+
+    template<typename Pick>
+    bool CronRandomization::randomize(const std::string& cron_schedule, Pick&& pick, Sections& sections)
+    {
+        std::string_view parts[6];
+        auto res = split(cron_schedule, parts);
 
         if (res)
         {
-            int selected_value = -1;
-            auto second = get_random_in_range<Seconds>(all_sections[1].str(), selected_value);
-            res = second.first;
-            final_cron_schedule = second.second;
+            for (size_t i = 0; i < 6; ++i)
+            {
+                sections[i].text = parts[i];
+            }
 
-            auto minute = get_random_in_range<Minutes>(all_sections[2].str(), selected_value);
-            res &= minute.first;
-            final_cron_schedule += " " + minute.second;
+            // Replace text with numbers
+            CronData::replace_string_name_with_numeric<libcron::Months>(sections[4].text);
+            CronData::replace_string_name_with_numeric<libcron::DayOfWeek>(sections[5].text);
 
-            auto hour = get_random_in_range<Hours>(all_sections[3].str(), selected_value);
-            res &= hour.first;
-            final_cron_schedule += " " + hour.second;
+            res = get_random_in_range<Seconds>(sections[0], pick);
+            res &= get_random_in_range<Minutes>(sections[1], pick);
+            res &= get_random_in_range<Hours>(sections[2], pick);
 
             // Do Month before DayOfMonth to allow capping the allowed range.
-            auto month = get_random_in_range<Months>(all_sections[5].str(), selected_value);
-            res &= month.first;
+            res &= get_random_in_range<Months>(sections[4], pick);
 
-            std::set<Months> month_range{};
+            CronField<Months> month_range{};
 
-            if (selected_value == -1)
+            if (sections[4].random)
             {
-                // Month is not specific, get the range.
-                CronData cr;
-                res &= cr.convert_from_string_range_to_number_range<Months>(all_sections[5].str(), month_range);
+                month_range.emplace(static_cast<Months>(sections[4].value));
             }
             else
             {
-                month_range.emplace(static_cast<Months>(selected_value));
+                // Month is not specific, get the range.
+                CronData cr;
+                res &= cr.convert_from_string_range_to_number_range<Months>(sections[4].text, month_range);
             }
 
             auto limits = day_limiter(month_range);
 
-            auto day_of_month = get_random_in_range<DayOfMonth>(all_sections[4].str(),
-                    selected_value,
-                    limits);
+            res &= get_random_in_range<DayOfMonth>(sections[3], pick, limits);
+            res &= get_random_in_range<DayOfWeek>(sections[5], pick);
+        }
 
-            res &= day_of_month.first;
-            final_cron_schedule += " " + day_of_month.second + " " + month.second;
+        return res;
+    }
 
-            auto day_of_week = get_random_in_range<DayOfWeek>(all_sections[6].str(), selected_value);
-            res &= day_of_week.first;
-            final_cron_schedule += " " + day_of_week.second;
+    template<typename T, typename Pick>
+    bool CronRandomization::get_random_in_range(Section& section, Pick&& pick, std::pair<int, int> limit)
+    {
+        bool res = true;
+        int left;
+        int right;
+
+        // Not random, the section stays as it is.
+        if (get_random_range(section.text, left, right))
+        {
+            if (limit.first != -1 && limit.second != -1)
+            {
+                left = cap(left, limit.first, limit.second);
+                right = cap(right, limit.first, limit.second);
+            }
+
+            libcron::CronData cd;
+            CronField<T> numbers;
+            res = cd.convert_from_string_range_to_number_range<T>(
+                    std::to_string(left) + "-" + std::to_string(right), numbers);
+
+            // Remove items outside limits.
+            if (limit.first != -1 && limit.second != -1)
+            {
+                for (auto it = numbers.begin(); it != numbers.end(); )
+                {
+                    if (CronData::value_of(*it) < limit.first || CronData::value_of(*it) > limit.second)
+                    {
+                        it = numbers.erase(it);
+                    }
+                    else
+                    {
+                        ++it;
+                    }
+                }
+            }
+
+            res = res && !numbers.empty();
+
+            if (res)
+            {
+                // Select the random number to use as the schedule
+                auto it = numbers.begin();
+                std::advance(it, pick(static_cast<int>(numbers.size())));
+                section.random = true;
+                section.value = CronData::value_of(*it);
+                section.text = std::to_string(section.value);
+            }
         }
 
-        return { res, final_cron_schedule };
+        return res;
+    }
+
+    CronData CronRandomization::to_data(const Sections& sections)
+    {
+        std::string_view fields[6];
+
+        for (size_t i = 0; i < 6; ++i)
+        {
+            fields[i] = sections[i].text;
+        }
+
+        CronData res;
+        res.parse_fields(fields);
+
+        return res;
     }
 
-    std::pair<int, int> CronRandomization::day_limiter(const std::set<Months>& months)
+    std::pair<int, int> CronRandomization::day_limiter(const CronField<Months>& months)
     {
         int max = CronData::value_of(DayOfMonth::Last);
 
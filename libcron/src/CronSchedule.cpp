@@ -1,8 +1,9 @@
 #include "libcron/CronSchedule.h"
+#include <algorithm>
 #include <tuple>
 
 using namespace std::chrono;
-#ifdef __cplusplus > 201703L
+#if __cplusplus > 201703L
 #else
 using namespace date;
 #endif
@@ -14,95 +15,417 @@ namespace libcron
     std::tuple<bool, std::chrono::system_clock::time_point>
     CronSchedule::calculate_from(const std::chrono::system_clock::time_point& from) const
     {
-        auto curr = from;
+        // Discard fraction seconds in the calculated schedule time
+        //  that may leftover from the argument `from`, which in turn comes from `now()`.
+        // Fraction seconds will potentially make the task be triggered more than 1 second late
+        //  if the `tick()` within the same second is earlier than schedule time,
+        //  in that the task will not trigger until the next `tick()` next second.
+        // By discarding fraction seconds in the scheduled time,
+        //  the `tick()` within the same second will never be earlier than schedule time,
+        //  and the task will trigger in that `tick()`.
+        auto curr = from - from.time_since_epoch() % seconds{1};
 
-        bool done = false;
-        auto max_iterations = std::numeric_limits<uint16_t>::max();
+        auto position = to_calendar_time(curr);
+        bool found = find_from(position);
 
-        while (!done && --max_iterations > 0)
+        if (found)
         {
-            bool date_changed = false;
-#ifdef __cplusplus > 201703L
-            year_month_day ymd = std::chrono::floor<days>(curr);
-#else
-            year_month_day ymd = days::floor<days>(curr);
-#endif
+            curr = to_time_point(position);
+        }
+
+        return std::make_tuple(found, curr);
+    }
+
+    std::tuple<bool, std::chrono::system_clock::time_point>
+    CronSchedule::calculate_from(const std::chrono::system_clock::time_point& from, const TimeZone& zone) const
+    {
+        auto utc = from - from.time_since_epoch() % seconds{1};
+        auto period = zone.get_period(utc);
+        auto local = utc + period.offset;
+
+        if (period.begin != system_clock::time_point::min())
+        {
+            // When clocks have just been turned back, continue after the local times that occur
+            // for the second time so as not to find the same schedules again.
+            auto repeated_until = period.begin + zone.get_period(period.begin - seconds{1}).offset;
+            local = std::max(local, repeated_until);
+        }
+
+        auto res = calculate_from(local);
+
+        if (std::get<0>(res))
+        {
+            std::get<1>(res) = zone.to_utc(std::get<1>(res));
+        }
+
+        return res;
+    }
 
-            // Add months until one of the allowed days are found, or stay at the current one.
-            if (data.get_months().find(static_cast<Months>(unsigned(ymd.month()))) == data.get_months().end())
+    std::tuple<bool, std::chrono::system_clock::time_point>
+    CronSchedule::calculate_previous(const std::chrono::system_clock::time_point& from) const
+    {
+        // The last whole second before from; a schedule at from itself doesn't count.
+        auto curr = from - system_clock::duration{ 1 };
+        curr -= curr.time_since_epoch() % seconds{1};
+
+        auto position = to_calendar_time(curr);
+        bool found = find_previous_from(position);
+
+        if (found)
+        {
+            curr = to_time_point(position);
+        }
+
+        return std::make_tuple(found, curr);
+    }
+
+    size_t CronSchedule::next_n(std::chrono::system_clock::time_point from,
+                                std::chrono::system_clock::time_point* out,
+                                size_t count) const
+    {
+        size_t res = 0;
+        auto position = to_calendar_time(from - from.time_since_epoch() % seconds{1});
+
+        while (res < count && find_from(position))
+        {
+            out[res++] = to_time_point(position);
+
+            // Continue from the next second, find_from() takes care of the carry.
+            ++position.sec;
+        }
+
+        return res;
+    }
+
+    CronSchedule::occurrence_iterator::occurrence_iterator(const CronSchedule& schedule,
+                                                           std::chrono::system_clock::time_point from,
+                                                           std::chrono::system_clock::time_point to)
+            : schedule(&schedule),
+              position(CronSchedule::to_calendar_time(from - from.time_since_epoch() % seconds{1})),
+              to(to)
+    {
+        find_next();
+    }
+
+    CronSchedule::occurrence_iterator& CronSchedule::occurrence_iterator::operator++()
+    {
+        ++position.sec;
+        find_next();
+        return *this;
+    }
+
+    void CronSchedule::occurrence_iterator::find_next()
+    {
+        bool found = schedule->find_from(position);
+
+        if (found)
+        {
+            current = CronSchedule::to_time_point(position);
+        }
+
+        if (!found || current >= to)
+        {
+            // Becomes the end iterator
+            schedule = nullptr;
+        }
+    }
+
+    bool CronSchedule::find_from(DateTime& position) const
+    {
+        auto curr_year = position.year;
+        auto curr_month = static_cast<uint8_t>(position.month);
+        auto curr_day = static_cast<uint8_t>(position.day);
+        auto curr_hour = position.hour;
+        auto curr_minute = position.min;
+        auto curr_second = position.sec;
+
+        // The Gregorian calendar repeats itself every 400 years, so if nothing is found
+        // within that time, the schedule will never expire.
+        const auto last_year = curr_year + 400;
+
+        bool done = data->get_seconds().empty()
+                    || data->get_minutes().empty()
+                    || data->get_hours().empty()
+                    || data->get_day_of_month().empty()
+                    || data->get_months().empty()
+                    || data->get_day_of_week().empty();
+
+        bool found = false;
+
+        // Jump straight to the next allowed value of each field, from month down to second.
+        // When a field runs out of allowed values, carry into the next larger field and
+        // restart from the smallest value of all the fields below it.
+        while (!done && curr_year <= last_year)
+        {
+            uint8_t next = 0;
+
+            if (!data->get_months().contains(static_cast<Months>(curr_month)))
             {
-                auto next_month = ymd + months{1};
-                sys_days s = next_month.year() / next_month.month() / 1;
-                curr = s;
-                date_changed = true;
+                if (!data->get_months().find_next(static_cast<uint8_t>(curr_month + 1), next))
+                {
+                    ++curr_year;
+                    data->get_months().find_next(CronData::value_of(Months::First), next);
+                }
+
+                curr_month = next;
+                curr_day = CronData::value_of(DayOfMonth::First);
+                curr_hour = 0;
+                curr_minute = 0;
+                curr_second = 0;
             }
-            // If all days are allowed (or the field is ignored via '?'), then the 'day of week' takes precedence.
-            else if (data.get_day_of_month().size() != CronData::value_of(DayOfMonth::Last))
+
+            if (!find_day(curr_year, curr_month, curr_day, next))
             {
-                // Add days until one of the allowed days are found, or stay at the current one.
-                if (data.get_day_of_month().find(static_cast<DayOfMonth>(unsigned(ymd.day()))) ==
-                    data.get_day_of_month().end())
+                // No allowed curr_day left in this curr_month
+                if (++curr_month > CronData::value_of(Months::Last))
                 {
-                    sys_days s = ymd;
-                    curr = s;
-                    curr += days{1};
-                    date_changed = true;
+                    ++curr_year;
+                    curr_month = CronData::value_of(Months::First);
                 }
+
+                curr_day = CronData::value_of(DayOfMonth::First);
+                curr_hour = 0;
+                curr_minute = 0;
+                curr_second = 0;
+            }
+            else if (next != curr_day)
+            {
+                curr_day = next;
+                curr_hour = 0;
+                curr_minute = 0;
+                curr_second = 0;
+            }
+            else if (!data->get_hours().find_next(curr_hour, next))
+            {
+                // No allowed curr_hour left today, find_day() takes care of moving into the next curr_month.
+                ++curr_day;
+                curr_hour = 0;
+                curr_minute = 0;
+                curr_second = 0;
+            }
+            else if (next != curr_hour)
+            {
+                curr_hour = next;
+                curr_minute = 0;
+                curr_second = 0;
+            }
+            else if (!data->get_minutes().find_next(curr_minute, next))
+            {
+                // Hours are checked again, possibly carrying into the next curr_day.
+                ++curr_hour;
+                curr_minute = 0;
+                curr_second = 0;
+            }
+            else if (next != curr_minute)
+            {
+                curr_minute = next;
+                curr_second = 0;
+            }
+            else if (!data->get_seconds().find_next(curr_second, next))
+            {
+                ++curr_minute;
+                curr_second = 0;
             }
             else
             {
-                //Add days until the current weekday is one of the allowed weekdays
-#ifdef __cplusplus > 201703L
-                year_month_weekday ymw = std::chrono::floor<days>(curr);
-#else
-                year_month_weekday ymw = date::floor<days>(curr);
-#endif
+                curr_second = next;
+                found = true;
+                done = true;
+            }
+        }
+
+        if (found)
+        {
+            position = DateTime{ curr_year, curr_month, curr_day, curr_hour, curr_minute, curr_second };
+        }
+
+        return found;
+    }
+
+    bool CronSchedule::find_previous_from(DateTime& position) const
+    {
+        // Signed, so that a field can drop below its smallest value before borrowing from the next larger one.
+        int curr_year = position.year;
+        int curr_month = static_cast<int>(position.month);
+        int curr_day = static_cast<int>(position.day);
+        int curr_hour = position.hour;
+        int curr_minute = position.min;
+        int curr_second = position.sec;
 
-                if (data.get_day_of_week().find(static_cast<DayOfWeek>(ymw.weekday().c_encoding())) ==
-                    data.get_day_of_week().end())
+        const auto first_year = curr_year - 400;
+
+        bool done = data->get_seconds().empty()
+                    || data->get_minutes().empty()
+                    || data->get_hours().empty()
+                    || data->get_day_of_month().empty()
+                    || data->get_months().empty()
+                    || data->get_day_of_week().empty();
+
+        bool found = false;
+
+        // The mirror image of find_from(): jump to the previous allowed value of each field and when
+        // a field runs out, borrow from the next larger one and restart from the largest value of all
+        // the fields below it. Days restart at 31, find_previous_day() limits that to the month.
+        while (!done && curr_year >= first_year)
+        {
+            uint8_t previous = 0;
+
+            if (!data->get_months().contains(static_cast<Months>(curr_month)))
+            {
+                if (curr_month <= CronData::value_of(Months::First)
+                    || !data->get_months().find_previous(static_cast<uint8_t>(curr_month - 1), previous))
                 {
-                    sys_days s = ymd;
-                    curr = s;
-                    curr += days{1};
-                    date_changed = true;
+                    --curr_year;
+                    data->get_months().find_previous(CronData::value_of(Months::Last), previous);
                 }
+
+                curr_month = previous;
+                curr_day = CronData::value_of(DayOfMonth::Last);
+                curr_hour = CronData::value_of(Hours::Last);
+                curr_minute = CronData::value_of(Minutes::Last);
+                curr_second = CronData::value_of(Seconds::Last);
             }
 
-            if (!date_changed)
+            if (!find_previous_day(curr_year, static_cast<uint8_t>(curr_month), static_cast<uint8_t>(curr_day), previous))
             {
-                auto date_time = to_calendar_time(curr);
-                if (data.get_hours().find(static_cast<Hours>(date_time.hour)) == data.get_hours().end())
-                {
-                    curr += hours{1};
-                    curr -= minutes{date_time.min};
-                    curr -= seconds{date_time.sec};
-                }
-                else if (data.get_minutes().find(static_cast<Minutes >(date_time.min)) == data.get_minutes().end())
-                {
-                    curr += minutes{1};
-                    curr -= seconds{date_time.sec};
-                }
-                else if (data.get_seconds().find(static_cast<Seconds>(date_time.sec)) == data.get_seconds().end())
-                {
-                    curr += seconds{1};
-                }
-                else
+                // No allowed day left in this month
+                if (--curr_month < CronData::value_of(Months::First))
                 {
-                    done = true;
+                    --curr_year;
+                    curr_month = CronData::value_of(Months::Last);
                 }
+
+                curr_day = CronData::value_of(DayOfMonth::Last);
+                curr_hour = CronData::value_of(Hours::Last);
+                curr_minute = CronData::value_of(Minutes::Last);
+                curr_second = CronData::value_of(Seconds::Last);
+            }
+            else if (previous != curr_day)
+            {
+                curr_day = previous;
+                curr_hour = CronData::value_of(Hours::Last);
+                curr_minute = CronData::value_of(Minutes::Last);
+                curr_second = CronData::value_of(Seconds::Last);
+            }
+            else if (curr_hour < 0 || !data->get_hours().find_previous(static_cast<uint8_t>(curr_hour), previous))
+            {
+                // No allowed hour left today, find_previous_day() takes care of moving into the previous month.
+                --curr_day;
+                curr_hour = CronData::value_of(Hours::Last);
+                curr_minute = CronData::value_of(Minutes::Last);
+                curr_second = CronData::value_of(Seconds::Last);
+            }
+            else if (previous != curr_hour)
+            {
+                curr_hour = previous;
+                curr_minute = CronData::value_of(Minutes::Last);
+                curr_second = CronData::value_of(Seconds::Last);
+            }
+            else if (curr_minute < 0 || !data->get_minutes().find_previous(static_cast<uint8_t>(curr_minute), previous))
+            {
+                // Hours are checked again, possibly borrowing from the previous day.
+                --curr_hour;
+                curr_minute = CronData::value_of(Minutes::Last);
+                curr_second = CronData::value_of(Seconds::Last);
+            }
+            else if (previous != curr_minute)
+            {
+                curr_minute = previous;
+                curr_second = CronData::value_of(Seconds::Last);
+            }
+            else if (curr_second < 0 || !data->get_seconds().find_previous(static_cast<uint8_t>(curr_second), previous))
+            {
+                --curr_minute;
+                curr_second = CronData::value_of(Seconds::Last);
+            }
+            else
+            {
+                curr_second = previous;
+                found = true;
+                done = true;
             }
         }
 
-        // Discard fraction seconds in the calculated schedule time
-        //  that may leftover from the argument `from`, which in turn comes from `now()`.
-        // Fraction seconds will potentially make the task be triggered more than 1 second late
-        //  if the `tick()` within the same second is earlier than schedule time,
-        //  in that the task will not trigger until the next `tick()` next second.
-        // By discarding fraction seconds in the scheduled time,
-        //  the `tick()` within the same second will never be earlier than schedule time,
-        //  and the task will trigger in that `tick()`.
-        curr -= curr.time_since_epoch() % seconds{1};
+        if (found)
+        {
+            position = DateTime{ curr_year,
+                                 static_cast<unsigned>(curr_month),
+                                 static_cast<unsigned>(curr_day),
+                                 static_cast<uint8_t>(curr_hour),
+                                 static_cast<uint8_t>(curr_minute),
+                                 static_cast<uint8_t>(curr_second) };
+        }
+
+        return found;
+    }
+
+    std::chrono::system_clock::time_point CronSchedule::to_time_point(const DateTime& position)
+    {
+        sys_days scheduled_day = year{ position.year } / month{ position.month } / day{ position.day };
+        return system_clock::time_point{ scheduled_day } + hours{ position.hour } + minutes{ position.min } + seconds{ position.sec };
+    }
+
+    bool CronSchedule::find_day(int in_year, uint8_t in_month, uint8_t from_day, uint8_t& allowed_day) const
+    {
+        bool res = false;
+
+        auto ym = year{ in_year } / month{ in_month };
+        auto last_day = static_cast<uint8_t>(unsigned((ym / last).day()));
+
+        if (from_day <= last_day)
+        {
+            // If all days are allowed (or the field is ignored via '?'), then the 'day of week' takes precedence.
+            if (data->get_day_of_month().size() != CronData::value_of(DayOfMonth::Last))
+            {
+                res = data->get_day_of_month().find_next(from_day, allowed_day) && allowed_day <= last_day;
+            }
+            else
+            {
+                // Rotate the allowed weekdays so that bit 0 is the weekday of 'from_day', then the
+                // lowest set bit is the number of days until the next allowed weekday.
+                sys_days from = ym / day{ from_day };
+                auto from_weekday = weekday{ from }.c_encoding();
+                unsigned allowed = data->get_day_of_week().get_bits();
+                unsigned rotated = ((allowed >> from_weekday) | (allowed << (7 - from_weekday))) & 0x7Fu;
+
+                auto candidate = from_day + bits::lowest(rotated);
+                res = candidate <= last_day;
+                allowed_day = static_cast<uint8_t>(candidate);
+            }
+        }
+
+        return res;
+    }
+
+    bool CronSchedule::find_previous_day(int in_year, uint8_t in_month, uint8_t from_day, uint8_t& allowed_day) const
+    {
+        bool res = false;
+
+        auto ym = year{ in_year } / month{ in_month };
+        auto last_day = static_cast<uint8_t>(unsigned((ym / last).day()));
+        from_day = std::min(from_day, last_day);
+
+        if (from_day >= CronData::value_of(DayOfMonth::First))
+        {
+            if (data->get_day_of_month().size() != CronData::value_of(DayOfMonth::Last))
+            {
+                res = data->get_day_of_month().find_previous(from_day, allowed_day);
+            }
+            else
+            {
+                // Rotate the allowed weekdays so that bit 6 is the weekday of 'from_day', then six minus
+                // the highest set bit is the number of days since the last allowed weekday.
+                sys_days from = ym / day{ from_day };
+                auto from_weekday = weekday{ from }.c_encoding();
+                unsigned allowed = data->get_day_of_week().get_bits();
+                unsigned rotated = ((allowed << (6 - from_weekday)) | (allowed >> (from_weekday + 1))) & 0x7Fu;
+
+                auto candidate = from_day - (6 - bits::highest(rotated));
+                res = candidate >= CronData::value_of(DayOfMonth::First);
+                allowed_day = static_cast<uint8_t>(candidate);
+            }
+        }
 
-        return std::make_tuple(max_iterations > 0, curr);
+        return res;
     }
-}
\ No newline at end of file
+}
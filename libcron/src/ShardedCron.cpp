@@ -0,0 +1,27 @@
+#include "libcron/ShardedCron.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace libcron
+{
+    bool pin_to_core(std::thread& thread, size_t core)
+    {
+        bool res = false;
+
+#ifdef __linux__
+        auto cores = std::max(1u, std::thread::hardware_concurrency());
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(core % cores, &cpus);
+        res = pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus) == 0;
+#else
+        (void)thread;
+        (void)core;
+#endif
+
+        return res;
+    }
+}
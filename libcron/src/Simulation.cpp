@@ -0,0 +1,213 @@
+#include "libcron/Simulation.h"
+
+using namespace std::chrono;
+
+namespace libcron
+{
+    namespace
+    {
+        // What the work sees when run by a simulation.
+        class SimulatedRun : public TaskInformation
+        {
+            public:
+                explicit SimulatedRun(std::string_view name)
+                        : name(name)
+                {
+                }
+
+                system_clock::duration get_delay() const override
+                {
+                    return system_clock::duration{ 0 };
+                }
+
+                std::string_view get_name() const override
+                {
+                    return name;
+                }
+
+            private:
+                std::string_view name;
+        };
+
+        template<typename T>
+        size_t hash_field(size_t seed, const CronField<T>& field)
+        {
+            for (auto v : field)
+            {
+                seed = (seed ^ CronData::value_of(v)) * 0x100000001b3ull;
+            }
+
+            // Separates the fields
+            return (seed ^ 0xff) * 0x100000001b3ull;
+        }
+    }
+
+    void FireEvents::clear()
+    {
+        times.clear();
+        ends.clear();
+        schedules.clear();
+    }
+
+    std::vector<uint64_t> FireEvents::counts(system_clock::time_point from, system_clock::time_point to,
+                                             seconds interval) const
+    {
+        auto first = duration_cast<seconds>(from.time_since_epoch()).count();
+        auto last = duration_cast<seconds>(to.time_since_epoch()).count();
+        auto length = std::max<int64_t>(interval.count(), 1);
+
+        std::vector<uint64_t> res(last > first ? static_cast<size_t>((last - first + length - 1) / length) : 0);
+        auto it = std::lower_bound(times.begin(), times.end(), first);
+
+        for (; it != times.end() && *it < last; ++it)
+        {
+            auto i = static_cast<size_t>(it - times.begin());
+            res[static_cast<size_t>((*it - first) / length)] += ends[i] - (i > 0 ? ends[i - 1] : 0);
+        }
+
+        return res;
+    }
+
+    uint64_t FireEvents::peak() const
+    {
+        uint64_t res = 0;
+
+        for (size_t i = 0; i < ends.size(); ++i)
+        {
+            res = std::max(res, ends[i] - (i > 0 ? ends[i - 1] : 0));
+        }
+
+        return res;
+    }
+
+    uint32_t Simulation::add(std::string name, CronSchedule schedule, std::shared_ptr<const TimeZone> zone,
+                             seconds offset)
+    {
+        auto index = static_cast<uint32_t>(names.size());
+        auto it = group_of.find(Key{ schedule.get_data().get(), zone.get(), offset });
+
+        if (it == group_of.end())
+        {
+            // The key refers to the data and zone kept by the group.
+            Key key{ schedule.get_data().get(), zone.get(), offset };
+            groups.push_back(Group{ std::move(schedule), std::move(zone), offset, {} });
+            it = group_of.emplace(key, static_cast<uint32_t>(groups.size() - 1)).first;
+        }
+
+        groups[it->second].members.push_back(index);
+        names.push_back(std::move(name));
+        works.emplace_back();
+
+        return index;
+    }
+
+    void Simulation::set_work(uint32_t index, Task::TaskFunction work)
+    {
+        works[index] = std::move(work);
+    }
+
+    void Simulation::run(system_clock::time_point from, system_clock::time_point to, FireEvents& out,
+                         bool run_work) const
+    {
+        for_each_fire(from, to, [this, &out, run_work](system_clock::time_point time,
+                                                       const uint32_t* first, const uint32_t* last)
+        {
+            auto t = duration_cast<seconds>(time.time_since_epoch()).count();
+
+            if (out.times.empty() || out.times.back() != t)
+            {
+                out.times.push_back(t);
+                out.ends.push_back(out.schedules.size());
+            }
+
+            out.schedules.insert(out.schedules.end(), first, last);
+            out.ends.back() = out.schedules.size();
+
+            if (run_work)
+            {
+                for (auto i = first; i != last; ++i)
+                {
+                    if (works[*i])
+                    {
+                        works[*i](SimulatedRun{ names[*i] });
+                    }
+                }
+            }
+        });
+    }
+
+    size_t Simulation::KeyHash::operator()(const Key& key) const
+    {
+        const auto& data = *key.data;
+        size_t res = 0xcbf29ce484222325ull;
+        res = hash_field(res, data.get_seconds());
+        res = hash_field(res, data.get_minutes());
+        res = hash_field(res, data.get_hours());
+        res = hash_field(res, data.get_day_of_month());
+        res = hash_field(res, data.get_months());
+        res = hash_field(res, data.get_day_of_week());
+
+        return res ^ std::hash<const void*>{}(key.zone) ^ std::hash<int64_t>{}(key.offset.count());
+    }
+
+    bool Simulation::start(const Group& group, Cursor& cursor, system_clock::time_point from,
+                           system_clock::time_point to) const
+    {
+        bool res;
+
+        if (!group.schedule.get_data()->is_valid())
+        {
+            res = false;
+        }
+        else if (group.zone)
+        {
+            // Each schedule is calculated from the one before, see CronSchedule::calculate_from().
+            auto next = group.schedule.calculate_from(from - group.offset, *group.zone);
+            cursor.next = std::get<1>(next) + group.offset;
+            res = std::get<0>(next) && cursor.next < to;
+        }
+        else
+        {
+            cursor.occurrence = CronSchedule::occurrence_iterator{ group.schedule, from - group.offset, to - group.offset };
+
+            // The iterator starts at the whole second of from.
+            while (cursor.occurrence != CronSchedule::occurrence_iterator{} && *cursor.occurrence + group.offset < from)
+            {
+                ++cursor.occurrence;
+            }
+
+            res = cursor.occurrence != CronSchedule::occurrence_iterator{};
+
+            if (res)
+            {
+                cursor.next = *cursor.occurrence + group.offset;
+            }
+        }
+
+        return res;
+    }
+
+    bool Simulation::advance(const Group& group, Cursor& cursor, system_clock::time_point to) const
+    {
+        bool res;
+
+        if (group.zone)
+        {
+            auto next = group.schedule.calculate_from(cursor.next - group.offset + seconds{ 1 }, *group.zone);
+            cursor.next = std::get<1>(next) + group.offset;
+            res = std::get<0>(next) && cursor.next < to;
+        }
+        else
+        {
+            ++cursor.occurrence;
+            res = cursor.occurrence != CronSchedule::occurrence_iterator{};
+
+            if (res)
+            {
+                cursor.next = *cursor.occurrence + group.offset;
+            }
+        }
+
+        return res;
+    }
+}
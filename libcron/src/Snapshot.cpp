@@ -0,0 +1,311 @@
+#include "libcron/Snapshot.h"
+#include "libcron/CronDataCache.h"
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+
+using namespace std::chrono;
+
+namespace libcron
+{
+    namespace
+    {
+        constexpr uint8_t magic[4]{ 'L', 'C', 'S', 'S' };
+
+        constexpr uint8_t valid_flag = 1;
+        constexpr uint8_t paused_flag = 2;
+
+        // The time points that can be represented, as system_clock may count in nanoseconds.
+        const int64_t earliest_microsecond = duration_cast<microseconds>(system_clock::time_point::min().time_since_epoch()).count() + 1;
+        const int64_t latest_microsecond = duration_cast<microseconds>(system_clock::time_point::max().time_since_epoch()).count() - 1;
+
+        template<typename T>
+        void put(uint8_t* at, T value)
+        {
+            for (size_t i = 0; i < sizeof(T); ++i)
+            {
+                at[i] = static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i));
+            }
+        }
+
+        template<typename T>
+        T get(const uint8_t* at)
+        {
+            uint64_t value = 0;
+
+            for (size_t i = 0; i < sizeof(T); ++i)
+            {
+                value |= static_cast<uint64_t>(at[i]) << (8 * i);
+            }
+
+            return static_cast<T>(value);
+        }
+
+        size_t aligned(size_t size)
+        {
+            return (size + 7) & ~static_cast<size_t>(7);
+        }
+
+        int64_t to_microseconds(system_clock::duration d)
+        {
+            return duration_cast<microseconds>(d).count();
+        }
+
+        system_clock::duration to_duration(int64_t value)
+        {
+            value = value < earliest_microsecond ? earliest_microsecond : value > latest_microsecond ? latest_microsecond : value;
+            return duration_cast<system_clock::duration>(microseconds{ value });
+        }
+
+        system_clock::time_point to_time_point(int64_t value)
+        {
+            return system_clock::time_point{ to_duration(value) };
+        }
+
+        // True if offset and length are within the strings.
+        bool is_within(uint64_t offset, uint64_t length, uint64_t strings_size)
+        {
+            return offset <= strings_size && length <= strings_size - offset;
+        }
+    }
+
+    void Snapshot::write(const Task* tasks, size_t count, std::vector<uint8_t>& out)
+    {
+        std::unordered_map<const CronData*, uint32_t> expression_index;
+        std::vector<const CronData*> expression_list;
+        std::unordered_map<const TimeZone*, uint32_t> zone_index;
+        std::vector<const TimeZone*> zone_list;
+        size_t strings_size = 0;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const auto& t = tasks[i];
+            auto data = t.get_schedule().get_data().get();
+
+            if (expression_index.emplace(data, static_cast<uint32_t>(expression_list.size())).second)
+            {
+                expression_list.push_back(data);
+            }
+
+            auto zone = t.get_time_zone().get();
+
+            if (zone != nullptr && zone_index.emplace(zone, static_cast<uint32_t>(zone_list.size())).second)
+            {
+                zone_list.push_back(zone);
+                strings_size += zone->get_name().size();
+            }
+
+            strings_size += t.get_name().size();
+        }
+
+        auto base = out.size();
+        auto expressions_at = base + header_size;
+        auto zones_at = expressions_at + expression_list.size() * expression_size;
+        auto tasks_at = zones_at + zone_list.size() * zone_size;
+        auto strings_at = tasks_at + count * task_size;
+        out.resize(strings_at + aligned(strings_size), 0);
+
+        auto p = out.data();
+        std::copy(std::begin(magic), std::end(magic), p + base);
+        put<uint32_t>(p + base + 4, version);
+        put<uint32_t>(p + base + 8, static_cast<uint32_t>(expression_list.size()));
+        put<uint32_t>(p + base + 12, static_cast<uint32_t>(zone_list.size()));
+        put<uint64_t>(p + base + 16, count);
+        put<uint64_t>(p + base + 24, strings_size);
+
+        for (size_t i = 0; i < expression_list.size(); ++i)
+        {
+            auto at = p + expressions_at + i * expression_size;
+            const auto& data = *expression_list[i];
+            put(at, data.get_seconds().get_bits());
+            put(at + 8, data.get_minutes().get_bits());
+            put(at + 16, data.get_hours().get_bits());
+            put(at + 20, data.get_day_of_month().get_bits());
+            put(at + 24, data.get_months().get_bits());
+            put(at + 26, data.get_day_of_week().get_bits());
+        }
+
+        size_t string_offset = 0;
+
+        auto put_string = [p, strings_at, &string_offset](uint8_t* at, const std::string_view& s)
+        {
+            put<uint64_t>(at, string_offset);
+            put<uint32_t>(at + 8, static_cast<uint32_t>(s.size()));
+            std::copy(s.begin(), s.end(), p + strings_at + string_offset);
+            string_offset += s.size();
+        };
+
+        for (size_t i = 0; i < zone_list.size(); ++i)
+        {
+            put_string(p + zones_at + i * zone_size, zone_list[i]->get_name());
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto at = p + tasks_at + i * task_size;
+            const auto& t = tasks[i];
+            auto state = t.get_state();
+            auto zone = t.get_time_zone().get();
+
+            put_string(at, t.get_name());
+            put<uint32_t>(at + 12, expression_index[t.get_schedule().get_data().get()]);
+            put<uint32_t>(at + 16, zone == nullptr ? no_zone : zone_index[zone]);
+            put<uint8_t>(at + 20, static_cast<uint8_t>((state.valid ? valid_flag : 0) | (state.paused ? paused_flag : 0)));
+            put<uint8_t>(at + 21, static_cast<uint8_t>(state.overlap_policy));
+            put<int64_t>(at + 24, to_microseconds(state.next_schedule.time_since_epoch()));
+            put<int64_t>(at + 32, to_microseconds(state.last_run.time_since_epoch()));
+            put<int64_t>(at + 40, to_microseconds(state.delay));
+            put<int64_t>(at + 48, to_microseconds(state.missed_schedule.time_since_epoch()));
+            put<uint64_t>(at + 56, state.catch_up_runs);
+            put<int64_t>(at + 64, to_microseconds(t.get_offset()));
+        }
+    }
+
+    bool Snapshot::open(const void* data, size_t size)
+    {
+        auto p = static_cast<const uint8_t*>(data);
+        task_records = nullptr;
+        strings = nullptr;
+        task_count = 0;
+        expressions.clear();
+        zones.clear();
+
+        bool res = size >= header_size
+                   && std::equal(std::begin(magic), std::end(magic), p)
+                   && get<uint32_t>(p + 4) == version;
+
+        uint64_t expression_count = 0;
+        uint64_t zone_count = 0;
+        uint64_t count = 0;
+        uint64_t strings_size = 0;
+
+        if (res)
+        {
+            expression_count = get<uint32_t>(p + 8);
+            zone_count = get<uint32_t>(p + 12);
+            count = get<uint64_t>(p + 16);
+            strings_size = get<uint64_t>(p + 24);
+
+            // Checked one by one, so that a corrupt count can't overflow the expected size.
+            auto remaining = size - header_size;
+            res = expression_count <= remaining / expression_size;
+            remaining -= res ? expression_count * expression_size : 0;
+            res = res && zone_count <= remaining / zone_size;
+            remaining -= res ? zone_count * zone_size : 0;
+            res = res && count <= remaining / task_size;
+            remaining -= res ? count * task_size : 0;
+            res = res && strings_size <= remaining && aligned(strings_size) == remaining;
+        }
+
+        if (!res)
+        {
+            expression_count = 0;
+            zone_count = 0;
+            count = 0;
+        }
+
+        auto expressions_at = p + header_size;
+        auto zones_at = expressions_at + expression_count * expression_size;
+        auto tasks_at = zones_at + zone_count * zone_size;
+        auto strings_at = reinterpret_cast<const char*>(tasks_at + count * task_size);
+
+        for (size_t i = 0; res && i < expression_count; ++i)
+        {
+            auto at = expressions_at + i * expression_size;
+            CronData expression{ CronField<Seconds>{ get<uint64_t>(at) },
+                                 CronField<Minutes>{ get<uint64_t>(at + 8) },
+                                 CronField<Hours>{ get<uint32_t>(at + 16) },
+                                 CronField<DayOfMonth>{ get<uint32_t>(at + 20) },
+                                 CronField<Months>{ get<uint16_t>(at + 24) },
+                                 CronField<DayOfWeek>{ get<uint8_t>(at + 26) } };
+            res = expression.is_valid();
+
+            if (res)
+            {
+                // The same instance as the tasks parsing or restoring the expression, so that they are
+                // grouped and calculated together.
+                expressions.push_back(CronDataCache::global().intern(expression));
+            }
+        }
+
+        for (size_t i = 0; res && i < zone_count; ++i)
+        {
+            auto at = zones_at + i * zone_size;
+            auto offset = get<uint64_t>(at);
+            auto length = get<uint32_t>(at + 8);
+            res = is_within(offset, length, strings_size);
+
+            if (res)
+            {
+                zones.push_back(TimeZone::locate(std::string{ strings_at + offset, length }));
+            }
+        }
+
+        for (size_t i = 0; res && i < count; ++i)
+        {
+            auto at = tasks_at + i * task_size;
+            auto zone = get<uint32_t>(at + 16);
+            res = is_within(get<uint64_t>(at), get<uint32_t>(at + 8), strings_size)
+                  && get<uint32_t>(at + 12) < expression_count
+                  && (zone == no_zone || zone < zone_count)
+                  && get<uint8_t>(at + 21) <= static_cast<uint8_t>(OverlapPolicy::Queue);
+        }
+
+        if (res)
+        {
+            task_records = tasks_at;
+            strings = strings_at;
+            task_count = static_cast<size_t>(count);
+        }
+        else
+        {
+            expressions.clear();
+            zones.clear();
+        }
+
+        return res;
+    }
+
+    std::string_view Snapshot::get_name(size_t index) const
+    {
+        auto at = task_at(index);
+        return std::string_view{ strings + get<uint64_t>(at), get<uint32_t>(at + 8) };
+    }
+
+    bool Snapshot::restore(size_t index, Task::TaskFunction work, std::vector<Task>& tasks,
+                           std::pmr::memory_resource* resource) const
+    {
+        auto at = task_at(index);
+        auto zone = get<uint32_t>(at + 16);
+        bool res = zone == no_zone || zones[zone] != nullptr;
+
+        if (res)
+        {
+            Task t{ get_name(index), CronSchedule{ expressions[get<uint32_t>(at + 12)] }, std::move(work), resource };
+
+            if (zone != no_zone)
+            {
+                t.set_time_zone(zones[zone]);
+            }
+
+            t.set_offset(duration_cast<seconds>(to_duration(get<int64_t>(at + 64))));
+
+            auto flags = get<uint8_t>(at + 20);
+            Task::State state{};
+            state.valid = (flags & valid_flag) != 0;
+            state.paused = (flags & paused_flag) != 0;
+            state.overlap_policy = static_cast<OverlapPolicy>(get<uint8_t>(at + 21));
+            state.next_schedule = to_time_point(get<int64_t>(at + 24));
+            state.last_run = to_time_point(get<int64_t>(at + 32));
+            state.delay = to_duration(get<int64_t>(at + 40));
+            state.missed_schedule = to_time_point(get<int64_t>(at + 48));
+            state.catch_up_runs = static_cast<size_t>(get<uint64_t>(at + 56));
+            t.set_state(state);
+
+            tasks.push_back(std::move(t));
+        }
+
+        return res;
+    }
+}
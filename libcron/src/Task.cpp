@@ -1,19 +1,245 @@
 #include "libcron/Task.h"
+#include <atomic>
 
 using namespace std::chrono;
 
 namespace libcron
 {
+    struct RunCompletion::Run
+    {
+        Run(std::string_view name, Task::TaskFunction work, std::shared_ptr<Task::RunState> state)
+                : name(name), work(std::move(work)), state(std::move(state))
+        {
+        }
+
+        ~Run()
+        {
+            end();
+        }
+
+        void end()
+        {
+            if (!ended.exchange(true))
+            {
+                Task::end_run(name, work, state);
+            }
+        }
+
+        const std::string name;
+        const Task::TaskFunction work;
+        const std::shared_ptr<Task::RunState> state;
+        std::atomic<bool> ended{ false };
+    };
+
+    void RunCompletion::operator()() const
+    {
+        if (run)
+        {
+            run->end();
+        }
+    }
+
+    class Task::RunInformation : public TaskInformation
+    {
+        public:
+            RunInformation(std::string_view name, system_clock::duration delay, const TaskFunction& work,
+                           const std::shared_ptr<RunState>& state)
+                    : name(name), delay(delay), work(work), state(state)
+            {
+            }
+
+            system_clock::duration get_delay() const override
+            {
+                return delay;
+            }
+
+            std::string_view get_name() const override
+            {
+                return name;
+            }
+
+            RunCompletion defer_completion() const override
+            {
+                // The name and work are copied, as the run may end after the task has changed or been removed.
+                if (state && !completion)
+                {
+                    completion = RunCompletion{ std::make_shared<RunCompletion::Run>(name, work, state) };
+                }
+
+                return completion;
+            }
+
+            bool is_deferred() const
+            {
+                return static_cast<bool>(completion);
+            }
+
+        private:
+            std::string_view name;
+            system_clock::duration delay;
+            const TaskFunction& work;
+            const std::shared_ptr<RunState>& state;
+            mutable RunCompletion completion{};
+    };
+
+    bool Task::execute(std::chrono::system_clock::time_point now)
+    {
+        // Next Schedule is still the current schedule, calculate delay (actual execution - planned execution)
+        delay = now - get_scheduled_time();
+        last_run = now;
+
+        bool res = true;
+
+        if (overlap_policy == OverlapPolicy::Allow)
+        {
+            task(*this);
+        }
+        else
+        {
+            if (!run_state)
+            {
+                run_state = std::make_shared<RunState>();
+            }
+
+            res = begin_run(run_state, steady_clock::now());
+
+            if (res && run_work(name, task, run_state, delay))
+            {
+                end_run(name, task, run_state);
+            }
+        }
+
+        return res;
+    }
+
+    bool Task::dispatch(std::chrono::system_clock::time_point now, std::function<void()>& job)
+    {
+        delay = now - get_scheduled_time();
+        last_run = now;
+
+        auto dispatched = steady_clock::now();
+        bool res = true;
+
+        // Runs are only tracked when they may not overlap.
+        std::shared_ptr<RunState> state{};
+
+        if (overlap_policy != OverlapPolicy::Allow)
+        {
+            if (!run_state)
+            {
+                run_state = std::make_shared<RunState>();
+            }
+
+            state = run_state;
+            res = begin_run(state, dispatched);
+        }
+
+        if (res)
+        {
+            job = [name = std::string{ name }, work = task, state = std::move(state), run_delay = delay, dispatched]()
+            {
+                auto waited = duration_cast<system_clock::duration>(steady_clock::now() - dispatched);
+
+                if (run_work(name, work, state, run_delay + waited) && state)
+                {
+                    end_run(name, work, state);
+                }
+            };
+        }
+
+        return res;
+    }
+
+    bool Task::begin_run(const std::shared_ptr<RunState>& state, std::chrono::steady_clock::time_point dispatched)
+    {
+        bool res = true;
+        std::lock_guard<std::mutex> guard{ state->lock };
+
+        if (state->running)
+        {
+            res = false;
+
+            if (overlap_policy == OverlapPolicy::Queue)
+            {
+                state->queued.emplace_back(delay, dispatched);
+            }
+        }
+        else
+        {
+            state->running = true;
+        }
+
+        return res;
+    }
+
+    bool Task::run_work(std::string_view name, const TaskFunction& work, const std::shared_ptr<RunState>& state,
+                        std::chrono::system_clock::duration delay)
+    {
+        RunInformation info{ name, delay, work, state };
+        work(info);
+
+        return !info.is_deferred();
+    }
+
+    void Task::end_run(std::string_view name, const TaskFunction& work, const std::shared_ptr<RunState>& state)
+    {
+        // Work through the runs queued meanwhile, then let the next run start.
+        bool done = false;
+
+        while (!done)
+        {
+            std::unique_lock<std::mutex> guard{ state->lock };
+
+            if (state->queued.empty())
+            {
+                state->running = false;
+                done = true;
+            }
+            else
+            {
+                auto next = state->queued.front();
+                state->queued.pop_front();
+                guard.unlock();
+
+                auto waited = duration_cast<system_clock::duration>(steady_clock::now() - next.second);
+                done = !run_work(name, work, state, next.first + waited);
+            }
+        }
+    }
 
     bool Task::calculate_next(std::chrono::system_clock::time_point from)
     {
-        auto result = schedule.calculate_from(from);
+        // The schedule next to run is the first one not earlier than the offset before from.
+        from -= offset;
+        return apply_next(time_zone ? schedule.calculate_from(from, *time_zone) : schedule.calculate_from(from));
+    }
+
+    bool Task::calculate_next(std::chrono::system_clock::time_point from, NextScheduleMemo& memo)
+    {
+        auto data = schedule.get_data().get();
+        auto zone = time_zone.get();
+        from -= offset;
+
+        if (memo.data != data || memo.zone != zone || memo.from != from)
+        {
+            memo.data = data;
+            memo.zone = zone;
+            memo.from = from;
+            memo.result = zone ? schedule.calculate_from(from, *zone) : schedule.calculate_from(from);
+        }
+
+        return apply_next(memo.result);
+    }
+
+    bool Task::apply_next(const std::tuple<bool, std::chrono::system_clock::time_point>& result)
+    {
+        catch_up_runs = 0;
 
         // In case the calculation fails, the task will no longer expire.
         valid = std::get<0>(result);
         if (valid)
         {
-            next_schedule = std::get<1>(result);
+            next_schedule = std::get<1>(result) + offset;
 
             // Make sure that the task is allowed to run.
             last_run = next_schedule - 1s;
@@ -22,9 +248,31 @@ namespace libcron
         return valid;
     }
 
+    size_t Task::count_missed(std::chrono::system_clock::time_point now, size_t limit) const
+    {
+        size_t res = 0;
+
+        if (valid)
+        {
+            // Counted in terms of the schedules, without the offset.
+            auto first = next_schedule - offset;
+            auto last = now - offset;
+            auto missed = time_zone
+                          ? schedule.occurrences(time_zone->to_local(first), time_zone->to_local(last) + 1s)
+                          : schedule.occurrences(first, last + 1s);
+
+            for (auto it = missed.begin(); res < limit && it != missed.end(); ++it)
+            {
+                ++res;
+            }
+        }
+
+        return res;
+    }
+
     bool Task::is_expired(std::chrono::system_clock::time_point now) const
     {
-        return valid && now >= last_run && time_until_expiry(now) == 0s;
+        return valid && !paused && now >= last_run && time_until_expiry(now) == 0s;
     }
 
     std::chrono::system_clock::duration Task::time_until_expiry(std::chrono::system_clock::time_point now) const
@@ -0,0 +1,80 @@
+#include "libcron/ThreadPool.h"
+
+namespace libcron
+{
+    ThreadPool::ThreadPool(size_t number_of_threads)
+    {
+        // hardware_concurrency() may not be known
+        if (number_of_threads == 0)
+        {
+            number_of_threads = 1;
+        }
+
+        threads.reserve(number_of_threads);
+
+        for (size_t i = 0; i < number_of_threads; ++i)
+        {
+            threads.emplace_back([this]()
+                                 {
+                                     work();
+                                 });
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> guard{ lock };
+            stopping = true;
+        }
+
+        available.notify_all();
+
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+    }
+
+    void ThreadPool::post(std::function<void()> job)
+    {
+        {
+            std::lock_guard<std::mutex> guard{ lock };
+            jobs.push_back(std::move(job));
+        }
+
+        available.notify_one();
+    }
+
+    void ThreadPool::work()
+    {
+        bool done = false;
+
+        while (!done)
+        {
+            std::function<void()> job;
+
+            {
+                std::unique_lock<std::mutex> guard{ lock };
+                available.wait(guard, [this]()
+                {
+                    return stopping || !jobs.empty();
+                });
+
+                // Remaining jobs are run before stopping.
+                done = jobs.empty();
+
+                if (!done)
+                {
+                    job = std::move(jobs.front());
+                    jobs.pop_front();
+                }
+            }
+
+            if (job)
+            {
+                job();
+            }
+        }
+    }
+}
@@ -0,0 +1,549 @@
+#include "libcron/TimeZone.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable:4244)
+#endif
+
+#if __cplusplus > 201703L
+#else
+#include <date/date.h>
+#endif
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+using namespace std::chrono;
+#if __cplusplus > 201703L
+#else
+using namespace date;
+#endif
+
+namespace libcron
+{
+    namespace
+    {
+        // Periods following from the rule are stored up to this year, later ones are calculated when needed.
+        constexpr int last_stored_year = 2100;
+
+        // The time points that can be represented, as system_clock may count in nanoseconds.
+        const int64_t earliest_second = duration_cast<seconds>(system_clock::time_point::min().time_since_epoch()).count() + 1;
+        const int64_t latest_second = duration_cast<seconds>(system_clock::time_point::max().time_since_epoch()).count() - 1;
+
+        struct Registry
+        {
+            std::mutex lock{};
+            std::unordered_map<std::string, std::shared_ptr<const TimeZone>> zones{};
+            std::string directory{};
+        };
+
+        Registry& registry()
+        {
+            static Registry r{};
+            return r;
+        }
+
+        uint32_t read_32(const std::string& data, size_t pos)
+        {
+            return static_cast<uint32_t>(static_cast<unsigned char>(data[pos])) << 24
+                   | static_cast<uint32_t>(static_cast<unsigned char>(data[pos + 1])) << 16
+                   | static_cast<uint32_t>(static_cast<unsigned char>(data[pos + 2])) << 8
+                   | static_cast<uint32_t>(static_cast<unsigned char>(data[pos + 3]));
+        }
+
+        int64_t read_time(const std::string& data, size_t pos, size_t size)
+        {
+            int64_t res;
+
+            if (size == 8)
+            {
+                res = static_cast<int64_t>(static_cast<uint64_t>(read_32(data, pos)) << 32 | read_32(data, pos + 4));
+            }
+            else
+            {
+                res = static_cast<int32_t>(read_32(data, pos));
+            }
+
+            return res;
+        }
+
+        bool parse_number(const std::string& text, size_t& pos, int& value)
+        {
+            bool res = pos < text.size() && text[pos] >= '0' && text[pos] <= '9';
+            value = 0;
+
+            while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9' && value < 10000)
+            {
+                value = value * 10 + (text[pos++] - '0');
+            }
+
+            return res;
+        }
+
+        // [+-]hh[:mm[:ss]]
+        bool parse_time(const std::string& text, size_t& pos, seconds& time)
+        {
+            int sign = 1;
+
+            if (pos < text.size() && (text[pos] == '+' || text[pos] == '-'))
+            {
+                sign = text[pos++] == '-' ? -1 : 1;
+            }
+
+            int h = 0;
+            int m = 0;
+            int s = 0;
+            bool res = parse_number(text, pos, h) && h <= 167;
+
+            if (res && pos < text.size() && text[pos] == ':')
+            {
+                ++pos;
+                res = parse_number(text, pos, m) && m < 60;
+
+                if (res && pos < text.size() && text[pos] == ':')
+                {
+                    ++pos;
+                    res = parse_number(text, pos, s) && s < 60;
+                }
+            }
+
+            time = seconds{ sign * (h * 3600 + m * 60 + s) };
+
+            return res;
+        }
+
+        bool parse_zone_name(const std::string& text, size_t& pos)
+        {
+            auto start = pos;
+            bool res;
+
+            if (pos < text.size() && text[pos] == '<')
+            {
+                pos = text.find('>', pos);
+                res = pos != std::string::npos;
+                pos = res ? pos + 1 : text.size();
+            }
+            else
+            {
+                while (pos < text.size() && ((text[pos] >= 'A' && text[pos] <= 'Z') || (text[pos] >= 'a' && text[pos] <= 'z')))
+                {
+                    ++pos;
+                }
+
+                res = pos - start >= 3;
+            }
+
+            return res;
+        }
+    }
+
+    std::shared_ptr<const TimeZone> TimeZone::locate(const std::string& name)
+    {
+        auto& r = registry();
+        std::lock_guard<std::mutex> guard{ r.lock };
+        std::shared_ptr<const TimeZone> res{};
+
+        auto it = r.zones.find(name);
+
+        if (it != r.zones.end())
+        {
+            res = it->second;
+        }
+        else if (!name.empty() && name[0] != '/' && name.find("..") == std::string::npos)
+        {
+            if (r.directory.empty())
+            {
+                auto tzdir = std::getenv("TZDIR");
+                r.directory = tzdir != nullptr && *tzdir != '\0' ? tzdir : "/usr/share/zoneinfo";
+            }
+
+            res = load(name, r.directory + "/" + name);
+
+            if (!res && (name == "UTC" || name == "Etc/UTC"))
+            {
+                res = utc();
+            }
+
+            if (res)
+            {
+                r.zones.emplace(name, res);
+            }
+        }
+
+        return res;
+    }
+
+    std::shared_ptr<const TimeZone> TimeZone::from_posix(const std::string& name, const std::string& rule)
+    {
+        std::shared_ptr<TimeZone> res{};
+        Rule parsed{};
+
+        if (parse_rule(rule, parsed))
+        {
+            res.reset(new TimeZone(name, parsed));
+            res->periods.push_back(Period{ system_clock::time_point::min(), system_clock::time_point::max(), parsed.std_offset });
+            res->extend_periods();
+        }
+
+        return res;
+    }
+
+    std::shared_ptr<const TimeZone> TimeZone::utc()
+    {
+        static const std::shared_ptr<const TimeZone> zone = from_posix("UTC", "UTC0");
+        return zone;
+    }
+
+    void TimeZone::set_zoneinfo_directory(std::string directory)
+    {
+        auto& r = registry();
+        std::lock_guard<std::mutex> guard{ r.lock };
+        r.directory = std::move(directory);
+    }
+
+    std::shared_ptr<const TimeZone> TimeZone::load(const std::string& name, const std::string& path)
+    {
+        std::shared_ptr<TimeZone> res{};
+        std::ifstream file{ path, std::ios::binary };
+        std::string data{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+
+        // See RFC 8536 for the format.
+        constexpr size_t header_size = 44;
+        bool valid = data.size() >= header_size && data.compare(0, 4, "TZif") == 0;
+
+        size_t pos = 0;
+        size_t time_size = 4;
+        uint32_t counts[6]{};   // isutcnt, isstdcnt, leapcnt, timecnt, typecnt, charcnt
+
+        auto read_header = [&data, &counts](size_t at)
+        {
+            for (size_t i = 0; i < 6; ++i)
+            {
+                counts[i] = read_32(data, at + 20 + i * 4);
+            }
+        };
+
+        auto block_size = [&counts](size_t time_bytes)
+        {
+            return counts[3] * time_bytes + counts[3] + counts[4] * 6 + counts[5] + counts[2] * (time_bytes + 4) + counts[1] + counts[0];
+        };
+
+        if (valid)
+        {
+            read_header(0);
+
+            // Version 2 and later repeat the data with 64 bit times, followed by a POSIX TZ rule.
+            if (data[4] >= '2')
+            {
+                pos = header_size + block_size(4);
+                valid = data.size() >= pos + header_size && data.compare(pos, 4, "TZif") == 0;
+
+                if (valid)
+                {
+                    read_header(pos);
+                    time_size = 8;
+                }
+            }
+        }
+
+        valid = valid && counts[4] > 0 && data.size() >= pos + header_size + block_size(time_size);
+
+        if (valid)
+        {
+            auto times = pos + header_size;
+            auto indices = times + counts[3] * time_size;
+            auto types = indices + counts[3];
+
+            auto offset_of = [&data, types, &counts](size_t type)
+            {
+                return seconds{ static_cast<int32_t>(read_32(data, types + std::min<size_t>(type, counts[4] - 1) * 6)) };
+            };
+
+            Rule rule{};
+            auto footer = pos + header_size + block_size(time_size);
+
+            if (time_size == 8 && footer < data.size() && data[footer] == '\n')
+            {
+                auto end = data.find('\n', footer + 1);
+
+                if (end != std::string::npos && end > footer + 1 && !parse_rule(data.substr(footer + 1, end - footer - 1), rule))
+                {
+                    rule = Rule{};
+                }
+            }
+
+            res.reset(new TimeZone(name, rule));
+            res->periods.push_back(Period{ system_clock::time_point::min(), system_clock::time_point::max(), offset_of(0) });
+
+            for (size_t i = 0; i < counts[3]; ++i)
+            {
+                auto t = read_time(data, times + i * time_size, time_size);
+                auto offset = offset_of(static_cast<unsigned char>(data[indices + i]));
+
+                if (t <= earliest_second)
+                {
+                    res->periods.back().offset = offset;
+                }
+                else if (t < latest_second && system_clock::time_point{ seconds{ t } } > res->periods.back().begin)
+                {
+                    auto begin = system_clock::time_point{ seconds{ t } };
+                    res->periods.back().end = begin;
+                    res->periods.push_back(Period{ begin, system_clock::time_point::max(), offset });
+                }
+            }
+
+            res->extend_periods();
+        }
+
+        return res;
+    }
+
+    bool TimeZone::parse_rule(const std::string& text, Rule& rule)
+    {
+        size_t pos = 0;
+        seconds offset{};
+        bool res = parse_zone_name(text, pos) && parse_time(text, pos, offset);
+
+        // POSIX offsets are positive west of Greenwich.
+        rule.std_offset = -offset;
+        rule.has_dst = res && pos < text.size();
+
+        if (rule.has_dst)
+        {
+            res = parse_zone_name(text, pos);
+            rule.dst_offset = rule.std_offset + hours{ 1 };
+
+            if (res && pos < text.size() && text[pos] != ',')
+            {
+                res = parse_time(text, pos, offset);
+                rule.dst_offset = -offset;
+            }
+
+            auto parse_date = [&text, &pos](Rule::Date& date)
+            {
+                bool valid = pos < text.size() && text[pos] == ',';
+                ++pos;
+
+                if (valid && text[pos] == 'M')
+                {
+                    ++pos;
+                    date.kind = 'M';
+                    valid = parse_number(text, pos, date.month) && date.month >= 1 && date.month <= 12
+                            && pos < text.size() && text[pos++] == '.'
+                            && parse_number(text, pos, date.week) && date.week >= 1 && date.week <= 5
+                            && pos < text.size() && text[pos++] == '.'
+                            && parse_number(text, pos, date.day) && date.day <= 6;
+                }
+                else if (valid && text[pos] == 'J')
+                {
+                    ++pos;
+                    date.kind = 'J';
+                    valid = parse_number(text, pos, date.day) && date.day >= 1 && date.day <= 365;
+                }
+                else if (valid)
+                {
+                    date.kind = 'N';
+                    valid = parse_number(text, pos, date.day) && date.day <= 365;
+                }
+
+                if (valid && pos < text.size() && text[pos] == '/')
+                {
+                    ++pos;
+                    valid = parse_time(text, pos, date.time);
+                }
+
+                return valid;
+            };
+
+            if (res && pos == text.size())
+            {
+                // The POSIX default
+                rule.start = Rule::Date{ 'M', 3, 2, 0 };
+                rule.end = Rule::Date{ 'M', 11, 1, 0 };
+            }
+            else
+            {
+                res = res && parse_date(rule.start) && parse_date(rule.end);
+            }
+        }
+
+        return res && pos == text.size();
+    }
+
+    void TimeZone::extend_periods()
+    {
+        if (rule.has_dst)
+        {
+            auto first_year = static_cast<int>(year_month_day{ floor<days>(std::max(periods.back().begin, system_clock::time_point{})) }.year());
+
+            for (int y = first_year; y <= last_stored_year + 1; ++y)
+            {
+                std::pair<system_clock::time_point, seconds> transitions[2];
+                rule_transitions(y, transitions);
+
+                for (auto& t : transitions)
+                {
+                    if (t.first > periods.back().begin)
+                    {
+                        periods.back().end = t.first;
+
+                        if (y <= last_stored_year)
+                        {
+                            periods.push_back(Period{ t.first, system_clock::time_point::max(), t.second });
+                        }
+                    }
+                }
+
+                if (y > last_stored_year && periods.back().end != system_clock::time_point::max())
+                {
+                    break;
+                }
+            }
+        }
+        else
+        {
+            periods.back().end = system_clock::time_point::max();
+        }
+    }
+
+    void TimeZone::rule_transitions(int in_year, std::pair<system_clock::time_point, seconds>* transitions) const
+    {
+        auto local_day = [in_year](const Rule::Date& date)
+        {
+            sys_days res;
+
+            if (date.kind == 'M')
+            {
+                auto wd = weekday{ static_cast<unsigned>(date.day) };
+                auto ym = year{ in_year } / month{ static_cast<unsigned>(date.month) };
+                sys_days first = ym / day{ 1 };
+                sys_days first_allowed = first + (wd - weekday{ first });
+                res = first_allowed + days{ 7 * (date.week - 1) };
+
+                // Week 5 means the last one in the month.
+                while (res > sys_days{ ym / last })
+                {
+                    res -= days{ 7 };
+                }
+            }
+            else
+            {
+                sys_days jan_1 = year{ in_year } / 1 / 1;
+                // Jn never counts February 29th, n does.
+                auto skip_leap_day = date.kind == 'J' && year{ in_year }.is_leap() && date.day >= 60;
+                res = jan_1 + days{ date.kind == 'J' ? date.day - 1 + (skip_leap_day ? 1 : 0) : date.day };
+            }
+
+            return res;
+        };
+
+        // The time of a transition is in the local time that applies until then.
+        transitions[0] = { system_clock::time_point{ local_day(rule.start) } + rule.start.time - rule.std_offset, rule.dst_offset };
+        transitions[1] = { system_clock::time_point{ local_day(rule.end) } + rule.end.time - rule.dst_offset, rule.std_offset };
+
+        if (transitions[1].first < transitions[0].first)
+        {
+            std::swap(transitions[0], transitions[1]);
+        }
+    }
+
+    size_t TimeZone::find_period(system_clock::time_point utc) const
+    {
+        auto it = std::upper_bound(periods.begin(), periods.end(), utc, [](system_clock::time_point t, const Period& p)
+        {
+            return t < p.begin;
+        });
+
+        // The first period begins at time_point::min(), so there is always one before.
+        auto index = static_cast<size_t>(std::distance(periods.begin(), it)) - 1;
+
+        return utc < periods[index].end ? index : no_period;
+    }
+
+    TimeZone::Period TimeZone::get_period(system_clock::time_point utc) const
+    {
+        auto index = find_period(utc);
+        Period res{};
+
+        if (index != no_period)
+        {
+            res = periods[index];
+        }
+        else
+        {
+            // Beyond the stored periods, which only happens when there is a rule with daylight saving time.
+            auto y = std::min(static_cast<int>(year_month_day{ floor<days>(utc) }.year()), 2260);
+            std::pair<system_clock::time_point, seconds> transitions[6];
+
+            for (int i = 0; i < 3; ++i)
+            {
+                rule_transitions(y - 1 + i, &transitions[i * 2]);
+            }
+
+            res = Period{ periods.back().end, system_clock::time_point::max(), rule.std_offset };
+
+            for (auto& t : transitions)
+            {
+                if (t.first <= utc)
+                {
+                    res.begin = t.first;
+                    res.offset = t.second;
+                }
+                else if (t.first < res.end)
+                {
+                    res.end = t.first;
+                }
+            }
+        }
+
+        return res;
+    }
+
+    system_clock::time_point TimeZone::to_utc(system_clock::time_point local) const
+    {
+        // UTC offsets are less than a day, so the candidates are the periods around the same time in UTC.
+        constexpr auto margin = hours{ 26 };
+        auto p = get_period(local > system_clock::time_point::min() + margin ? local - margin : local);
+        auto res = local - p.offset;
+        bool done = false;
+
+        while (!done)
+        {
+            auto candidate = local - p.offset;
+
+            if (candidate >= p.begin && candidate < p.end)
+            {
+                // Periods are visited in order, so this is the first occurrence.
+                res = candidate;
+                done = true;
+            }
+            else if (p.end == system_clock::time_point::max() || p.begin > local + margin)
+            {
+                done = true;
+            }
+            else
+            {
+                auto next = get_period(p.end);
+
+                if (candidate >= p.end && local - next.offset < next.begin)
+                {
+                    // Skipped by the transition at the end of this period.
+                    res = p.end;
+                    done = true;
+                }
+
+                p = next;
+            }
+        }
+
+        return res;
+    }
+}
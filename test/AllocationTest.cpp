@@ -0,0 +1,210 @@
+#include <catch.hpp>
+#include <libcron/include/libcron/Cron.h>
+#include <libcron/externals/date/include/date/date.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace libcron;
+using namespace std::chrono;
+using namespace date;
+
+namespace
+{
+    std::atomic<bool> counting{ false };
+    std::atomic<size_t> allocations{ 0 };
+
+    class CountingClock
+            : public ICronClock
+    {
+        public:
+            system_clock::time_point now() const override
+            {
+                return current_time;
+            }
+
+            seconds utc_offset(system_clock::time_point) const override
+            {
+                return 0s;
+            }
+
+            void add(system_clock::duration time)
+            {
+                current_time += time;
+            }
+
+        private:
+            system_clock::time_point current_time = sys_days{ 2020_y / 1 / 1 };
+    };
+
+    template<typename CronType>
+    size_t allocations_while_ticking()
+    {
+        CronType c{};
+        size_t runs = 0;
+        size_t name_length = 0;
+
+        auto work = [&runs, &name_length](auto& i)
+        {
+            runs++;
+            name_length += i.get_name().size();
+        };
+
+        const char* schedules[]{ "* * * * * ?", "*/5 * * * * ?", "0 * * * * ?", "0 0 * * * ?", "0 0 0 29 2 ?" };
+
+        for (int i = 0; i < 500; ++i)
+        {
+            // Long names, which don't fit in the small string buffer
+            REQUIRE(c.add_schedule("A task with a long name " + std::to_string(i), schedules[i % 5],
+                                   FunctionRef<void(const TaskInformation&)>{ work }));
+        }
+
+        // Warm up
+        c.tick();
+
+        counting = true;
+
+        for (int i = 0; i < 3 * 3600; ++i)
+        {
+            c.get_clock().add(1s);
+            c.tick();
+        }
+
+        // Jump ahead, starting over with the schedules
+        c.get_clock().add(5h);
+        c.tick();
+        counting = false;
+
+        REQUIRE(runs > 0);
+        REQUIRE(name_length > 0);
+
+        return allocations.exchange(0);
+    }
+}
+
+void* operator new(std::size_t size)
+{
+    if (counting)
+    {
+        allocations++;
+    }
+
+    auto p = std::malloc(size == 0 ? 1 : size);
+
+    if (p == nullptr)
+    {
+        throw std::bad_alloc{};
+    }
+
+    return p;
+}
+
+// GCC takes the pointers to come from the built-in operator new once these are inlined into a delete-expression,
+// not seeing that the replacement above allocates them with std::malloc.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+SCENARIO("Ticking does not allocate")
+{
+    GIVEN("A vector based task queue")
+    {
+        REQUIRE(allocations_while_ticking<Cron<CountingClock>>() == 0);
+    }
+    AND_GIVEN("A heap based task queue")
+    {
+        REQUIRE(allocations_while_ticking<Cron<CountingClock, NullLock, HeapTaskQueue>>() == 0);
+    }
+    AND_GIVEN("A group based task queue")
+    {
+        REQUIRE(allocations_while_ticking<Cron<CountingClock, NullLock, GroupedTaskQueue>>() == 0);
+    }
+    AND_GIVEN("An instance keeping metrics")
+    {
+        REQUIRE(allocations_while_ticking<Cron<CountingClock, NullLock, HeapTaskQueue, CronMetrics>>() == 0);
+    }
+}
+
+namespace
+{
+    template<typename CronType>
+    size_t allocations_while_adding_to_an_arena()
+    {
+        // Enough for the tasks and the growth of the queue, with nothing to fall back on.
+        std::vector<std::byte> buffer(size_t{ 1 } << 22);
+        std::pmr::monotonic_buffer_resource arena{ buffer.data(), buffer.size(), std::pmr::null_memory_resource() };
+
+        CronType c{ &arena };
+        size_t runs = 0;
+        auto work = [&runs](auto&)
+        {
+            runs++;
+        };
+
+        std::vector<std::shared_ptr<const CronData>> schedules{ CronData::create_shared("* * * * * ?"),
+                                                                CronData::create_shared("*/5 * * * * ?"),
+                                                                CronData::create_shared("0 0 * * * ?") };
+        std::vector<std::string> names;
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            names.push_back("A task with a long name " + std::to_string(i));
+        }
+
+        std::string to_remove = names[3];
+
+        counting = true;
+
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            REQUIRE(c.add_schedule(std::move(names[i]), schedules[i % schedules.size()],
+                                   FunctionRef<void(const TaskInformation&)>{ work }));
+        }
+
+        c.tick();
+        c.get_clock().add(5s);
+        c.tick();
+        c.remove_schedule(to_remove);
+        counting = false;
+
+        REQUIRE(c.count() == 999);
+        REQUIRE(runs > 0);
+
+        return allocations.exchange(0);
+    }
+}
+
+SCENARIO("Tasks are allocated from the memory resource")
+{
+    GIVEN("A vector based task queue")
+    {
+        REQUIRE(allocations_while_adding_to_an_arena<Cron<CountingClock>>() == 0);
+    }
+    AND_GIVEN("A heap based task queue")
+    {
+        REQUIRE(allocations_while_adding_to_an_arena<Cron<CountingClock, NullLock, HeapTaskQueue>>() == 0);
+    }
+    AND_GIVEN("A group based task queue")
+    {
+        REQUIRE(allocations_while_adding_to_an_arena<Cron<CountingClock, NullLock, GroupedTaskQueue>>() == 0);
+    }
+}
@@ -4,13 +4,15 @@
 #include <date/date.h>
 #include <libcron/include/libcron/Cron.h>
 #include <libcron/include/libcron/CronData.h>
+#include <libcron/include/libcron/CronDataCache.h>
+#include <thread>
 
 using namespace libcron;
 using namespace date;
 using namespace std::chrono;
 
 template<typename T>
-bool has_value_range(const std::set<T>& set, uint8_t low, uint8_t high)
+bool has_value_range(const CronField<T>& set, uint8_t low, uint8_t high)
 {
     bool found = true;
     for (auto i = low; found && i <= high; ++i)
@@ -237,4 +239,242 @@ SCENARIO("Replacing text with numbers")
         std::string s = "JAN-DEC";
         REQUIRE(CronData::replace_string_name_with_numeric<libcron::Months>(s) == "1-12");
     }
-}
\ No newline at end of file
+}
+
+SCENARIO("Separators and white-space")
+{
+    GIVEN("Expressions with varying white-space")
+    {
+        THEN("Fields are separated by any white-space")
+        {
+            REQUIRE(CronData::create("  0 0 12 * * MON-FRI  ").is_valid());
+            REQUIRE(CronData::create("0\t0\t12 *\n* MON-FRI").is_valid());
+            REQUIRE(CronData::create("0   0 12 * * ? ").is_valid());
+        }
+        AND_THEN("Exactly six fields are required")
+        {
+            REQUIRE_FALSE(CronData::create("0 0 12 * *").is_valid());
+            REQUIRE_FALSE(CronData::create("0 0 12 * * ? *").is_valid());
+            REQUIRE_FALSE(CronData::create("@hourly").is_valid());
+        }
+    }
+    GIVEN("Expressions with odd separators")
+    {
+        THEN("A trailing comma is ignored")
+        {
+            auto c = CronData::create("0,30, * * * * ?");
+            REQUIRE(c.is_valid());
+            REQUIRE(c.get_seconds().size() == 2);
+        }
+        AND_THEN("Empty parts are invalid")
+        {
+            REQUIRE_FALSE(CronData::create("0,,30 * * * * ?").is_valid());
+            REQUIRE_FALSE(CronData::create(",30 * * * * ?").is_valid());
+            REQUIRE_FALSE(CronData::create("0-30-40 * * * * ?").is_valid());
+            REQUIRE_FALSE(CronData::create("*/5/2 * * * * ?").is_valid());
+        }
+        AND_THEN("Too large numbers and steps are invalid")
+        {
+            REQUIRE_FALSE(CronData::create("99999999999 * * * * ?").is_valid());
+            REQUIRE_FALSE(CronData::create("0-99999999999 * * * * ?").is_valid());
+            REQUIRE_FALSE(CronData::create("*/0 * * * * ?").is_valid());
+            REQUIRE_FALSE(CronData::create("*/256 * * * * ?").is_valid());
+        }
+    }
+}
+
+SCENARIO("Names are case insensitive")
+{
+    auto c = CronData::create("0 0 0 ? jan,Mar sUn-tuE");
+    REQUIRE(c.is_valid());
+    REQUIRE(has_value_range(c.get_months(), 1, 1));
+    REQUIRE(has_value_range(c.get_months(), 3, 3));
+    REQUIRE(c.get_months().size() == 2);
+    REQUIRE(has_value_range(c.get_day_of_week(), 0, 2));
+    REQUIRE(c.get_day_of_week().size() == 3);
+}
+
+SCENARIO("Field values are stored as bitmasks")
+{
+    GIVEN("A parsed expression")
+    {
+        auto c = CronData::create("0,5,59 * 3-5 ? * 1,6");
+        REQUIRE(c.is_valid());
+
+        THEN("Values are iterated in order")
+        {
+            std::vector<int> seconds;
+            for (auto s : c.get_seconds())
+            {
+                seconds.push_back(CronData::value_of(s));
+            }
+
+            REQUIRE(seconds == std::vector<int>{ 0, 5, 59 });
+            REQUIRE(c.get_seconds().get_bits() == ((uint64_t{ 1 } << 59) | (1 << 5) | 1));
+            REQUIRE(c.get_day_of_week().get_bits() == ((1 << 6) | (1 << 1)));
+        }
+        AND_THEN("Next allowed value is found from any position")
+        {
+            uint8_t next = 0;
+            REQUIRE(c.get_seconds().find_next(0, next));
+            REQUIRE(next == 0);
+            REQUIRE(c.get_seconds().find_next(1, next));
+            REQUIRE(next == 5);
+            REQUIRE(c.get_seconds().find_next(6, next));
+            REQUIRE(next == 59);
+            REQUIRE_FALSE(c.get_hours().find_next(6, next));
+            REQUIRE_FALSE(c.get_hours().find_next(200, next));
+        }
+        AND_THEN("Values can be erased while iterating")
+        {
+            auto hours = c.get_hours();
+            for (auto it = hours.begin(); it != hours.end();)
+            {
+                it = CronData::value_of(*it) == 4 ? hours.erase(it) : ++it;
+            }
+
+            REQUIRE(hours.size() == 2);
+            REQUIRE(hours.contains(Hours{ 3 }));
+            REQUIRE_FALSE(hours.contains(Hours{ 4 }));
+            REQUIRE(hours.contains(Hours{ 5 }));
+        }
+        AND_THEN("A parsed expression is small")
+        {
+            REQUIRE(sizeof(CronData) <= 32);
+        }
+    }
+}
+
+SCENARIO("Parsed expressions are cached and shared")
+{
+    GIVEN("An empty cache")
+    {
+        CronDataCache cache{ 32 };
+
+        WHEN("Getting the same expression twice")
+        {
+            auto first = cache.get("0 */5 * * * ?");
+            auto second = cache.get("0 */5 * * * ?");
+
+            THEN("Both share the same parsed instance")
+            {
+                REQUIRE(first->is_valid());
+                REQUIRE(first == second);
+
+                auto stats = cache.get_statistics();
+                REQUIRE(stats.hits == 1);
+                REQUIRE(stats.misses == 1);
+                REQUIRE(stats.size == 1);
+            }
+        }
+        AND_WHEN("Interning expressions assembled from their fields")
+        {
+            auto parsed = cache.get("0 */5 * * * ?");
+            auto fields_of = [](const CronData& d)
+            {
+                return CronData{ d.get_seconds(), d.get_minutes(), d.get_hours(), d.get_day_of_month(), d.get_months(), d.get_day_of_week() };
+            };
+
+            THEN("They are shared with the parsed ones still in use")
+            {
+                REQUIRE(cache.intern(fields_of(*parsed)) == parsed);
+
+                auto other = fields_of(CronData{ "0 0 12 * * ?" });
+                auto interned = cache.intern(other);
+                REQUIRE(*interned == other);
+                REQUIRE(cache.intern(other) == interned);
+                REQUIRE(cache.get_statistics().size == 1);
+            }
+            AND_THEN("Nothing is shared without capacity")
+            {
+                cache.set_capacity(0);
+                REQUIRE(cache.intern(*parsed) != parsed);
+                REQUIRE(cache.intern(*parsed) != cache.intern(*parsed));
+            }
+        }
+        AND_WHEN("Getting an invalid expression")
+        {
+            REQUIRE_FALSE(cache.get("not a schedule")->is_valid());
+            REQUIRE_FALSE(cache.get("not a schedule")->is_valid());
+            REQUIRE(cache.get_statistics().hits == 1);
+        }
+        AND_WHEN("Getting more expressions than fit in the cache")
+        {
+            auto first = cache.get("0 0 12 * * ?");
+
+            for (int i = 0; i < 60; ++i)
+            {
+                for (int j = 0; j < 10; ++j)
+                {
+                    cache.get(std::to_string(i) + " " + std::to_string(j) + " * * * ?");
+                }
+            }
+
+            THEN("The least recently used ones are evicted")
+            {
+                auto stats = cache.get_statistics();
+                REQUIRE(stats.size <= 32);
+                REQUIRE(stats.misses == 601);
+
+                // Evicted instances remain valid for their users
+                REQUIRE(first->is_valid());
+                REQUIRE(cache.get("0 0 12 * * ?") != first);
+            }
+        }
+        AND_WHEN("Clearing the cache")
+        {
+            cache.get("0 0 * * * ?");
+            cache.clear();
+
+            auto stats = cache.get_statistics();
+            REQUIRE(stats.hits == 0);
+            REQUIRE(stats.misses == 0);
+            REQUIRE(stats.size == 0);
+        }
+        AND_WHEN("The cache has no capacity")
+        {
+            cache.set_capacity(0);
+
+            THEN("Nothing is cached")
+            {
+                REQUIRE(cache.get("0 0 * * * ?")->is_valid());
+                REQUIRE(cache.get_statistics().size == 0);
+            }
+        }
+    }
+    AND_GIVEN("Multiple threads using the same cache")
+    {
+        CronDataCache cache{ 64 };
+        std::vector<std::thread> threads;
+
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&cache]()
+                                 {
+                                     for (int i = 0; i < 5000; ++i)
+                                     {
+                                         cache.get("0 " + std::to_string(i % 100) + " * * * ?");
+                                     }
+                                 });
+        }
+
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+
+        THEN("All lookups are accounted for")
+        {
+            auto stats = cache.get_statistics();
+            REQUIRE(stats.hits + stats.misses == 20000);
+            REQUIRE(stats.size <= 64);
+        }
+    }
+    AND_GIVEN("The global cache")
+    {
+        THEN("Shared instances are handed out by CronData")
+        {
+            REQUIRE(CronData::create_shared("0 */5 * * * ?") == CronData::create_shared("0 */5 * * * ?"));
+        }
+    }
+}
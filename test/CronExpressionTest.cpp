@@ -0,0 +1,220 @@
+#include <catch.hpp>
+#include <date/date.h>
+#include <libcron/include/libcron/Cron.h>
+#include <libcron/include/libcron/CronDataCache.h>
+#include <libcron/include/libcron/CronExpression.h>
+#include <random>
+
+using namespace libcron;
+using namespace date;
+using namespace std::chrono;
+
+namespace
+{
+    class FixedUTCClock
+            : public ICronClock
+    {
+        public:
+            system_clock::time_point now() const override
+            {
+                return current_time;
+            }
+
+            seconds utc_offset(system_clock::time_point) const override
+            {
+                return 0s;
+            }
+
+            void set(system_clock::time_point new_time)
+            {
+                current_time = new_time;
+            }
+
+        private:
+            system_clock::time_point current_time{};
+    };
+
+    bool same_as_cron_data(const std::string& expression)
+    {
+        CronExpression parsed{ expression };
+        CronData data{ expression };
+        bool res = parsed.is_valid() == data.is_valid();
+
+        if (res && data.is_valid())
+        {
+            res = parsed.get_seconds() == data.get_seconds()
+                  && parsed.get_minutes() == data.get_minutes()
+                  && parsed.get_hours() == data.get_hours()
+                  && parsed.get_day_of_month() == data.get_day_of_month()
+                  && parsed.get_months() == data.get_months()
+                  && parsed.get_day_of_week() == data.get_day_of_week();
+        }
+
+        if (!res)
+        {
+            UNSCOPED_INFO("Differs: '" << expression << "'");
+        }
+
+        return res;
+    }
+
+    // Parts of a field with values up to 'last', including invalid ones.
+    std::string random_part(std::mt19937& rng, unsigned last)
+    {
+        static const char* const words[]{ "*", "?", "MON", "fri", "Jan", "dec", "SUN", "xyz", "@daily", "" };
+        auto number = [&rng, last]() { return std::to_string(rng() % (last + 3)); };
+        std::string res;
+
+        switch (rng() % 8)
+        {
+            case 0:
+                res = words[rng() % 10];
+                break;
+            case 1:
+            case 2:
+            case 3:
+                res = number();
+                break;
+            case 4:
+                res = number() + "-" + number();
+                break;
+            case 5:
+                res = "*/" + std::to_string(rng() % 300);
+                break;
+            case 6:
+                res = number() + "/" + std::to_string(rng() % 40);
+                break;
+            default:
+                res = std::string{ words[2 + rng() % 5] } + "-" + words[2 + rng() % 5];
+                break;
+        }
+
+        return res;
+    }
+
+    std::string random_expression(std::mt19937& rng)
+    {
+        const unsigned last[]{ 59, 59, 23, 31, 12, 6, 6 };
+        std::string res;
+
+        // Mostly six fields
+        size_t fields = rng() % 10 == 0 ? 5 + rng() % 3 : 6;
+
+        for (size_t f = 0; f < fields; ++f)
+        {
+            auto parts = 1 + rng() % 3;
+
+            if (f == 5 && rng() % 2 == 0)
+            {
+                res += "?";
+            }
+            else
+            {
+                for (size_t p = 0; p < parts; ++p)
+                {
+                    res += random_part(rng, last[f]);
+                    res += p + 1 < parts || rng() % 10 == 0 ? "," : "";
+                }
+            }
+
+            res += rng() % 10 == 0 ? "\t" : " ";
+        }
+
+        return res;
+    }
+}
+
+// Parsed by the compiler
+static_assert(CronExpression{ "0 */5 * * * ?" }.is_valid(), "");
+static_assert(CronExpression{ "0 */5 * * * ?" }.get_minutes().get_bits() == 0x0084210842108421, "");
+static_assert(CronExpression{ "0 0 12 ? JAN-MAR mon-fri" }.get_day_of_week().get_bits() == 0x3E, "");
+static_assert(!CronExpression{ "@daily" }.is_valid(), "");
+static_assert(!CronExpression{ "60 * * * * ?" }.is_valid(), "");
+static_assert(!CronExpression{ "0 0 0 30 2 ?" }.is_valid(), "");
+
+SCENARIO("Expressions parsed at compile time")
+{
+    GIVEN("Expressions from the tests of CronData")
+    {
+        const char* expressions[]{
+                "* * * * * ?", "0 0 12 * * MON-FRI", "  0 0 12 * * MON-FRI  ", "0\t0\t12 *\n* MON-FRI",
+                "0   0 12 * * ? ", "0 0 12 * *", "0 0 12 * * ? *", "@hourly", "0 @hourly", "0 @yearly ?",
+                "0,30, * * * * ?", "0,,30 * * * * ?", ",30 * * * * ?", "0-30-40 * * * * ?", "*/5/2 * * * * ?",
+                "99999999999 * * * * ?", "0-99999999999 * * * * ?", "*/0 * * * * ?", "*/256 * * * * ?",
+                "0 0 0 ? jan,Mar sUn-tuE", "0,5,59 * 3-5 ? * 1,6", "0 0 22-1 * * ?", "0 0 0 31 2,4,6 ?",
+                "0 0 0 31 1,2 ?", "0 0 0 29 2 ?", "0 0 0 30 2 ?", "0 0 0 * * *", "0 0 0 ? * ?",
+                "44,300 * * * * ?", "59/250 * * * * ?", "1/255 * * 1/255 * ?", "0 0 0 ? * SUNDAY",
+                "0 0 0 ? DECEMBER *", "-1 * * * * ?", "1- * * * * ?", "-/5 * * * * ?", "", " ", "@"
+        };
+
+        THEN("They are the same as parsed at runtime")
+        {
+            for (auto expression : expressions)
+            {
+                REQUIRE(same_as_cron_data(expression));
+            }
+        }
+    }
+
+    GIVEN("Random expressions")
+    {
+        std::mt19937 rng{ 20230101 };
+
+        THEN("They are the same as parsed at runtime")
+        {
+            size_t valid = 0;
+
+            for (int i = 0; i < 20000; ++i)
+            {
+                auto expression = random_expression(rng);
+                REQUIRE(same_as_cron_data(expression));
+                valid += CronData{ expression }.is_valid() ? 1 : 0;
+            }
+
+            // Both valid and invalid ones
+            REQUIRE(valid > 100);
+            REQUIRE(valid < 19900);
+        }
+    }
+
+    GIVEN("An expression longer than the limit")
+    {
+        std::string expression = "0 0 0 * * " + std::string(CronExpression::max_length, '?');
+        REQUIRE_FALSE(CronExpression{ expression }.is_valid());
+    }
+
+    GIVEN("A Cron instance")
+    {
+        Cron<FixedUTCClock> c{};
+        c.get_clock().set(sys_days{ 2022_y / 3 / 1 } + 30s);
+        int runs = 0;
+
+        constexpr CronExpression every_minute{ "0 * * * * ?" };
+        auto data = std::make_shared<const CronData>(every_minute.to_data());
+        auto cached = CronDataCache::global().get_statistics().size;
+
+        REQUIRE(c.add_schedule("Task", data, [&runs](auto&) { runs++; }));
+        REQUIRE_FALSE(c.add_schedule("Invalid", std::make_shared<const CronData>(CronExpression{ "0 * * * *" }.to_data()),
+                                     [](auto&) {}));
+
+        THEN("Tasks use the parsed expression as is")
+        {
+            REQUIRE(c.count() == 1);
+            REQUIRE(c.time_until_next() == 30s);
+            REQUIRE(CronDataCache::global().get_statistics().size == cached);
+            c.for_each_task([&data](const Task& t) { REQUIRE(t.get_schedule().get_data() == data); });
+        }
+    }
+
+#if defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+    GIVEN("Expressions as template arguments")
+    {
+        THEN("Each is shared by all of its users")
+        {
+            REQUIRE(cron_expr<"0 */5 * * * ?">::data() == cron_expr<"0 */5 * * * ?">::data());
+            REQUIRE(cron_expr<"0 */5 * * * ?">::data()->get_minutes() == CronData::create("0 */5 * * * ?").get_minutes());
+            REQUIRE(cron_expr<"0 */5 * * * ?">::data() != cron_expr<"0 */10 * * * ?">::data());
+        }
+    }
+#endif
+}
@@ -0,0 +1,171 @@
+#include <catch.hpp>
+#include <date/date.h>
+#include <libcron/include/libcron/Cron.h>
+#include <libcron/include/libcron/CronObserver.h>
+#include <string>
+#include <vector>
+
+using namespace libcron;
+using namespace date;
+using namespace std::chrono;
+
+namespace
+{
+    class FixedUTCClock
+            : public ICronClock
+    {
+        public:
+            system_clock::time_point now() const override
+            {
+                return current_time;
+            }
+
+            seconds utc_offset(system_clock::time_point) const override
+            {
+                return 0s;
+            }
+
+            void set(system_clock::time_point new_time)
+            {
+                current_time = new_time;
+            }
+
+            void add(system_clock::duration time)
+            {
+                current_time += time;
+            }
+
+        private:
+            system_clock::time_point current_time{};
+    };
+
+    // Records the calls, to check when they are made.
+    class RecordingObserver
+    {
+        public:
+            static constexpr bool enabled = true;
+
+            void on_tick(steady_clock::duration lock_wait, steady_clock::duration duration, size_t tasks, size_t expired)
+            {
+                REQUIRE(lock_wait <= duration);
+                ticks.emplace_back(tasks, expired);
+            }
+
+            void on_fire(std::string_view name, system_clock::duration delay)
+            {
+                fired.emplace_back(name);
+                delays.push_back(delay);
+            }
+
+            void on_run(std::string_view name, steady_clock::duration)
+            {
+                ran.emplace_back(name);
+            }
+
+            std::vector<std::pair<size_t, size_t>> ticks{};
+            std::vector<std::string> fired{};
+            std::vector<system_clock::duration> delays{};
+            std::vector<std::string> ran{};
+    };
+}
+
+static_assert(!NullObserver::enabled, "");
+static_assert(CronMetrics::enabled, "");
+
+SCENARIO("Observing ticks")
+{
+    GIVEN("A Cron instance with an observer")
+    {
+        Cron<FixedUTCClock, NullLock, TaskQueue, RecordingObserver> c{};
+        c.get_clock().set(sys_days{ 2022_y / 3 / 1 });
+
+        REQUIRE(c.add_schedule("Every second", "* * * * * ?", [](auto&) {}));
+        REQUIRE(c.add_schedule("Every minute", "0 * * * * ?", [](auto&) {}));
+
+        WHEN("Ticking")
+        {
+            c.tick();
+            c.get_clock().add(2s);
+            c.tick();
+
+            THEN("Each tick and run is observed")
+            {
+                auto& o = c.get_observer();
+                REQUIRE(o.ticks == std::vector<std::pair<size_t, size_t>>{ { 2, 2 }, { 2, 1 } });
+                REQUIRE(o.fired.size() == 3);
+                REQUIRE(o.ran == o.fired);
+                REQUIRE(o.fired[2] == "Every second");
+
+                // Due one second before the second tick
+                REQUIRE(o.delays[2] == 1s);
+            }
+        }
+    }
+
+    GIVEN("A Cron instance with an observer and an executor")
+    {
+        std::vector<std::function<void()>> jobs;
+        Cron<FixedUTCClock, NullLock, TaskQueue, RecordingObserver> c{ [&jobs](std::function<void()> job)
+                                                                       {
+                                                                           jobs.push_back(std::move(job));
+                                                                       } };
+        c.get_clock().set(sys_days{ 2022_y / 3 / 1 });
+
+        REQUIRE(c.add_schedule("Overlapping", "* * * * * ?", [](auto&) {}));
+        REQUIRE(c.set_overlap_policy("Overlapping", OverlapPolicy::Skip));
+
+        c.tick();
+        c.get_clock().add(1s);
+        c.tick();
+
+        THEN("Dispatched tasks are observed as fired, but skipped runs are not")
+        {
+            auto& o = c.get_observer();
+            REQUIRE(o.ticks.size() == 2);
+            REQUIRE(o.fired.size() == 1);
+            REQUIRE(o.ran.empty());
+        }
+    }
+
+    GIVEN("A Cron instance keeping metrics")
+    {
+        Cron<FixedUTCClock, NullLock, HeapTaskQueue, CronMetrics> c{};
+        c.get_clock().set(sys_days{ 2022_y / 3 / 1 });
+
+        REQUIRE(c.add_schedule("Every second", "* * * * * ?", [](auto&) {}));
+        REQUIRE(c.add_schedule("Every five seconds", "*/5 * * * * ?", [](auto&) {}));
+
+        for (int i = 0; i < 10; ++i)
+        {
+            c.tick();
+            c.get_clock().add(1s);
+        }
+
+        // Half a minute late
+        c.get_clock().add(30s);
+        c.tick();
+
+        THEN("The totals are kept")
+        {
+            auto m = c.get_observer().get();
+            REQUIRE(m.ticks == 11);
+            REQUIRE(m.tasks_scanned == 22);
+            REQUIRE(m.expired == 10 + 2 + 2);
+            REQUIRE(m.fired == m.expired);
+            REQUIRE(m.runs == m.fired);
+            REQUIRE(m.delays[0] == 12);
+            // Both half a minute late
+            REQUIRE(m.delays[5] == 2);
+            REQUIRE(m.tick_time >= m.lock_wait);
+            REQUIRE(m.longest_tick <= m.tick_time);
+        }
+        AND_THEN("They can be reset")
+        {
+            c.get_observer().reset();
+            auto m = c.get_observer().get();
+            REQUIRE(m.ticks == 0);
+            REQUIRE(m.fired == 0);
+            REQUIRE(m.delays[5] == 0);
+        }
+    }
+}
@@ -178,3 +178,96 @@ SCENARIO("Randomization using text versions of days and months")
 
     }
 }
+
+SCENARIO("Creating randomized schedules directly")
+{
+    GIVEN("The same seed")
+    {
+        libcron::CronRandomization a{ 42 };
+        libcron::CronRandomization b{ 42 };
+        const std::string random_schedule = "R(0-59) R(0-59) R(0-23) R(1-31) R(1-12) ?";
+
+        THEN("The same schedules are created, equal to those from parse()")
+        {
+            for (int i = 0; i < 1000; ++i)
+            {
+                auto data = a.create(random_schedule);
+                auto res = b.parse(random_schedule);
+                REQUIRE(data.is_valid());
+                REQUIRE(std::get<0>(res));
+                REQUIRE(data == CronData::create(std::get<1>(res)));
+            }
+        }
+    }
+
+    GIVEN("Invalid schedules")
+    {
+        libcron::CronRandomization cr;
+
+        THEN("Invalid data is created")
+        {
+            REQUIRE_FALSE(cr.create("0 0 0 1 R(JAN-DEC) R(MON-SUN)").is_valid());
+            REQUIRE_FALSE(cr.create("0 0 0 ? R(JAN) *").is_valid());
+            REQUIRE_FALSE(cr.create("0 0 0 ? * R(JAN-JUN)").is_valid());
+            REQUIRE_FALSE(cr.create("0 0 0 ? *").is_valid());
+            REQUIRE_FALSE(libcron::CronRandomization::create("0 0 0 ? R(MON-TUE) *", 1, "a").is_valid());
+        }
+    }
+}
+
+SCENARIO("Randomized schedules keyed by name")
+{
+    const std::string random_schedule = "0 R(0-59) R(0-23) ? * *";
+
+    GIVEN("A seed and a key")
+    {
+        THEN("The same schedule is always created")
+        {
+            auto data = libcron::CronRandomization::create(random_schedule, 7, "Task 1");
+            REQUIRE(data.is_valid());
+            REQUIRE(data.get_minutes().size() == 1);
+            REQUIRE(data.get_hours().size() == 1);
+
+            for (int i = 0; i < 100; ++i)
+            {
+                REQUIRE(libcron::CronRandomization::create(random_schedule, 7, "Task 1") == data);
+            }
+        }
+    }
+
+    GIVEN("Different keys")
+    {
+        THEN("The schedules are spread over the ranges")
+        {
+            std::unordered_map<int, int> hours{};
+
+            for (int i = 0; i < 2400; ++i)
+            {
+                auto data = libcron::CronRandomization::create(random_schedule, 7, "Task " + std::to_string(i));
+                REQUIRE(data.is_valid());
+                ++hours[static_cast<int>(CronData::value_of(*data.get_hours().begin()))];
+            }
+
+            REQUIRE(hours.size() == 24);
+
+            for (const auto& h : hours)
+            {
+                REQUIRE(h.second > 50);
+                REQUIRE(h.second < 150);
+            }
+        }
+        AND_THEN("Another seed gives other schedules")
+        {
+            int same = 0;
+
+            for (int i = 0; i < 100; ++i)
+            {
+                auto name = "Task " + std::to_string(i);
+                same += libcron::CronRandomization::create(random_schedule, 7, name)
+                        == libcron::CronRandomization::create(random_schedule, 8, name);
+            }
+
+            REQUIRE(same < 5);
+        }
+    }
+}
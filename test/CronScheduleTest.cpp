@@ -1,24 +1,20 @@
 #include <catch.hpp>
 #include <chrono>
-#ifdef __cplusplus > 201703L
-#else
 #include <date/date.h>
-#endif
 #include <libcron/include/libcron/Cron.h>
 #include <iostream>
+#include <random>
 
+// The tests are written against the date library also with C++20, so only the durations are taken from std::chrono.
 using namespace libcron;
-#ifdef __cplusplus > 201703L
-#else
 using namespace date;
-#endif
-using namespace std::chrono;
+using std::chrono::system_clock;
+using std::chrono::hours;
+using std::chrono::minutes;
+using std::chrono::seconds;
+using std::chrono::milliseconds;
 
-#ifdef __cplusplus > 201703L
-system_clock::time_point DT(std::chrono::year_month_day ymd, hours h = hours{ 0 }, minutes m = minutes{ 0 }, seconds s = seconds{ 0 })
-#else
 system_clock::time_point DT(year_month_day ymd, hours h = hours{0}, minutes m = minutes{0}, seconds s = seconds{0})
-#endif
 {
     sys_days t = ymd;
     auto sum = t + h + m + s;
@@ -222,4 +218,454 @@ SCENARIO("Examples from README.md")
 SCENARIO("Unable to calculate time point")
 {
     REQUIRE_FALSE(test( "0 0 * 31 FEB *", DT(2021_y / 1 / 1), DT(2022_y / 1 / 1)));
-}
\ No newline at end of file
+}
+// The previous implementation of CronSchedule::calculate_from(), which moves forward one second,
+// minute or hour at a time. Kept as the reference for the differential test below.
+std::tuple<bool, system_clock::time_point> reference_calculate_from(const CronData& data, system_clock::time_point from)
+{
+    auto curr = from;
+
+    bool done = false;
+    auto max_iterations = std::numeric_limits<uint16_t>::max();
+
+    while (!done && --max_iterations > 0)
+    {
+        bool date_changed = false;
+        year_month_day ymd = floor<days>(curr);
+
+        if (!data.get_months().contains(static_cast<Months>(unsigned(ymd.month()))))
+        {
+            auto next_month = ymd + months{1};
+            sys_days s = next_month.year() / next_month.month() / 1;
+            curr = s;
+            date_changed = true;
+        }
+        else if (data.get_day_of_month().size() != CronData::value_of(DayOfMonth::Last))
+        {
+            if (!data.get_day_of_month().contains(static_cast<DayOfMonth>(unsigned(ymd.day()))))
+            {
+                sys_days s = ymd;
+                curr = s;
+                curr += days{1};
+                date_changed = true;
+            }
+        }
+        else
+        {
+            year_month_weekday ymw = floor<days>(curr);
+
+            if (!data.get_day_of_week().contains(static_cast<DayOfWeek>(ymw.weekday().c_encoding())))
+            {
+                sys_days s = ymd;
+                curr = s;
+                curr += days{1};
+                date_changed = true;
+            }
+        }
+
+        if (!date_changed)
+        {
+            auto date_time = CronSchedule::to_calendar_time(curr);
+            if (!data.get_hours().contains(static_cast<Hours>(date_time.hour)))
+            {
+                curr += hours{1};
+                curr -= minutes{date_time.min};
+                curr -= seconds{date_time.sec};
+            }
+            else if (!data.get_minutes().contains(static_cast<Minutes>(date_time.min)))
+            {
+                curr += minutes{1};
+                curr -= seconds{date_time.sec};
+            }
+            else if (!data.get_seconds().contains(static_cast<Seconds>(date_time.sec)))
+            {
+                curr += seconds{1};
+            }
+            else
+            {
+                done = true;
+            }
+        }
+    }
+
+    curr -= curr.time_since_epoch() % seconds{1};
+
+    return std::make_tuple(max_iterations > 0, curr);
+}
+
+std::string random_field(std::mt19937& rng, int low, int high, const std::vector<std::string>& names = {})
+{
+    auto value = [&]() { return std::uniform_int_distribution<>(low, high)(rng); };
+    auto part = [&]()
+                {
+                    std::string res;
+
+                    switch (std::uniform_int_distribution<>(0, 5)(rng))
+                    {
+                        case 0:
+                            res = std::to_string(value()) + "-" + std::to_string(value());
+                            break;
+                        case 1:
+                            res = "*/" + std::to_string(std::uniform_int_distribution<>(1, high)(rng));
+                            break;
+                        case 2:
+                            res = std::to_string(value()) + "/" + std::to_string(std::uniform_int_distribution<>(1, high)(rng));
+                            break;
+                        case 3:
+                            res = names.empty() ? std::to_string(value()) : names[static_cast<size_t>(value() - low)];
+                            break;
+                        default:
+                            res = std::to_string(value());
+                            break;
+                    }
+
+                    return res;
+                };
+
+    std::string res;
+    auto kind = std::uniform_int_distribution<>(0, 9)(rng);
+
+    if (kind < 3)
+    {
+        res = "*";
+    }
+    else
+    {
+        res = part();
+
+        for (auto extra = std::uniform_int_distribution<>(0, 2)(rng); extra > 0; --extra)
+        {
+            res += ',';
+            res += part();
+        }
+    }
+
+    return res;
+}
+
+SCENARIO("Calculation matches the previous implementation")
+{
+    std::mt19937 rng{ 20211215 };
+    const std::vector<std::string> month_names{ "JAN", "FEB", "MAR", "APR", "MAY", "JUN",
+                                                "JUL", "AUG", "SEP", "OCT", "NOV", "DEC" };
+    const std::vector<std::string> day_names{ "SUN", "MON", "TUE", "WED", "THU", "FRI", "SAT" };
+
+    // Start times between 1990 and 2060
+    std::uniform_int_distribution<int64_t> start_time(631152000, 2871763200);
+    int compared = 0;
+
+    for (int i = 0; compared < 2000; ++i)
+    {
+        std::string dom = "?";
+        std::string dow = "?";
+
+        if (std::uniform_int_distribution<>(0, 1)(rng) == 0)
+        {
+            dom = random_field(rng, 1, 31);
+        }
+        else
+        {
+            dow = random_field(rng, 0, 6, day_names);
+        }
+
+        auto schedule = random_field(rng, 0, 59) + " "
+                        + random_field(rng, 0, 59) + " "
+                        + random_field(rng, 0, 23) + " "
+                        + dom + " "
+                        + random_field(rng, 1, 12, month_names) + " "
+                        + dow;
+
+        auto data = CronData::create(schedule);
+
+        if (data.is_valid())
+        {
+            CronSchedule sched(data);
+            auto from = system_clock::time_point{ seconds{ start_time(rng) } + milliseconds{ i % 1000 } };
+
+            // Follow the schedule for a few expiries, like a task would.
+            for (int run = 0; run < 5; ++run)
+            {
+                auto expected = reference_calculate_from(data, from);
+                auto calculated = sched.calculate_from(from);
+
+                INFO("Schedule: " << schedule << ", from: " << from.time_since_epoch().count());
+
+                if (std::get<0>(expected))
+                {
+                    REQUIRE(std::get<0>(calculated));
+                    REQUIRE(std::get<1>(calculated) == std::get<1>(expected));
+                }
+                else if (std::get<0>(calculated))
+                {
+                    // The previous implementation gives up after a fixed number of iterations, so
+                    // only verify that the found time is one the schedule allows.
+                    auto check = reference_calculate_from(data, std::get<1>(calculated));
+                    REQUIRE(std::get<0>(check));
+                    REQUIRE(std::get<1>(check) == std::get<1>(calculated));
+                }
+
+                from = std::get<1>(calculated) + seconds{ 1 };
+            }
+
+            ++compared;
+        }
+    }
+}
+
+SCENARIO("Sparse schedules")
+{
+    REQUIRE(test("0 0 0 29 2 ?", DT(2096_y / 3 / 1), DT(2104_y / 2 / 29)));
+    REQUIRE(test("59 59 23 31 DEC ?", DT(2018_y / 1 / 1), DT(2018_y / 12 / 31, hours{23}, minutes{59}, seconds{59})));
+    REQUIRE(test("0 0 0 ? FEB SUN", DT(2021_y / 3 / 1), DT(2022_y / 2 / 6)));
+}
+
+SCENARIO("Enumerating schedules")
+{
+    GIVEN("Random schedules")
+    {
+        std::mt19937 rng{ 20220301 };
+        std::uniform_int_distribution<int64_t> start_time(631152000, 2871763200);
+        int compared = 0;
+
+        for (int i = 0; compared < 500; ++i)
+        {
+            auto schedule = random_field(rng, 0, 59) + " "
+                            + random_field(rng, 0, 59) + " "
+                            + random_field(rng, 0, 23) + " "
+                            + random_field(rng, 1, 31) + " "
+                            + random_field(rng, 1, 12) + " ?";
+
+            auto data = CronData::create(schedule);
+
+            if (data.is_valid())
+            {
+                CronSchedule sched(data);
+                auto from = system_clock::time_point{ seconds{ start_time(rng) } + milliseconds{ i % 1000 } };
+
+                // Chaining calculate_from() is how a task follows its schedule.
+                std::vector<system_clock::time_point> expected;
+                auto next = from;
+
+                for (int run = 0; run < 20; ++run)
+                {
+                    auto calculated = sched.calculate_from(next);
+
+                    if (std::get<0>(calculated))
+                    {
+                        expected.push_back(std::get<1>(calculated));
+                        next = std::get<1>(calculated) + seconds{ 1 };
+                    }
+                }
+
+                INFO("Schedule: " << schedule << ", from: " << from.time_since_epoch().count());
+
+                std::vector<system_clock::time_point> batch(20);
+                batch.resize(sched.next_n(from, batch.data(), batch.size()));
+                REQUIRE(batch == expected);
+
+                std::vector<system_clock::time_point> iterated;
+
+                if (!expected.empty())
+                {
+                    for (auto t : sched.occurrences(from, expected.back() + seconds{ 1 }))
+                    {
+                        iterated.push_back(t);
+                    }
+                }
+
+                REQUIRE(iterated == expected);
+
+                ++compared;
+            }
+        }
+    }
+
+    GIVEN("A schedule every 15 minutes")
+    {
+        CronSchedule sched(CronData::create("0 */15 * * * ?"));
+        auto from = DT(2022_y / 3 / 1, hours{ 10 }, minutes{ 7 });
+
+        THEN("The range excludes its end")
+        {
+            std::vector<system_clock::time_point> res;
+
+            for (auto t : sched.occurrences(from, DT(2022_y / 3 / 1, hours{ 11 })))
+            {
+                res.push_back(t);
+            }
+
+            REQUIRE(res == std::vector<system_clock::time_point>{ DT(2022_y / 3 / 1, hours{ 10 }, minutes{ 15 }),
+                                                                  DT(2022_y / 3 / 1, hours{ 10 }, minutes{ 30 }),
+                                                                  DT(2022_y / 3 / 1, hours{ 10 }, minutes{ 45 }) });
+        }
+
+        THEN("An empty range has no schedules")
+        {
+            auto range = sched.occurrences(from, from);
+            REQUIRE(range.begin() == range.end());
+
+            auto backwards = sched.occurrences(from, from - hours{ 1 });
+            REQUIRE(backwards.begin() == backwards.end());
+        }
+
+        THEN("Asking for no schedules writes nothing")
+        {
+            system_clock::time_point out{};
+            REQUIRE(sched.next_n(from, &out, 0) == 0);
+            REQUIRE(out == system_clock::time_point{});
+        }
+
+        THEN("Crossing days, months and years")
+        {
+            std::vector<system_clock::time_point> res(3);
+            REQUIRE(sched.next_n(DT(2021_y / 12 / 31, hours{ 23 }, minutes{ 31 }), res.data(), res.size()) == 3);
+            REQUIRE(res[0] == DT(2021_y / 12 / 31, hours{ 23 }, minutes{ 45 }));
+            REQUIRE(res[1] == DT(2022_y / 1 / 1));
+            REQUIRE(res[2] == DT(2022_y / 1 / 1, hours{ 0 }, minutes{ 15 }));
+        }
+    }
+
+    GIVEN("A sparse schedule")
+    {
+        CronSchedule sched(CronData::create("0 0 0 29 2 ?"));
+        std::vector<system_clock::time_point> res(3);
+
+        REQUIRE(sched.next_n(DT(2096_y / 3 / 1), res.data(), res.size()) == 3);
+        REQUIRE(res[0] == DT(2104_y / 2 / 29));
+        REQUIRE(res[1] == DT(2108_y / 2 / 29));
+        REQUIRE(res[2] == DT(2112_y / 2 / 29));
+    }
+
+    GIVEN("A schedule that never happens")
+    {
+        CronSchedule sched(CronData::create("0 0 0 31 2 ?"));
+        std::vector<system_clock::time_point> res(3);
+
+        REQUIRE(sched.next_n(DT(2022_y / 1 / 1), res.data(), res.size()) == 0);
+
+        auto range = sched.occurrences(DT(2022_y / 1 / 1), DT(2030_y / 1 / 1));
+        REQUIRE(range.begin() == range.end());
+    }
+}
+
+SCENARIO("Calculating the previous runtime")
+{
+    GIVEN("Random schedules")
+    {
+        std::mt19937 rng{ 20220414 };
+        const std::vector<std::string> day_names{ "SUN", "MON", "TUE", "WED", "THU", "FRI", "SAT" };
+        std::uniform_int_distribution<int64_t> start_time(631152000, 2871763200);
+        int compared = 0;
+
+        for (int i = 0; compared < 2000; ++i)
+        {
+            std::string dom = "?";
+            std::string dow = "?";
+
+            if (std::uniform_int_distribution<>(0, 1)(rng) == 0)
+            {
+                dom = random_field(rng, 1, 31);
+            }
+            else
+            {
+                dow = random_field(rng, 0, 6, day_names);
+            }
+
+            auto schedule = random_field(rng, 0, 59) + " "
+                            + random_field(rng, 0, 59) + " "
+                            + random_field(rng, 0, 23) + " "
+                            + dom + " "
+                            + random_field(rng, 1, 12) + " "
+                            + dow;
+
+            auto data = CronData::create(schedule);
+
+            if (data.is_valid())
+            {
+                CronSchedule sched(data);
+                auto from = system_clock::time_point{ seconds{ start_time(rng) } + milliseconds{ i % 2 == 0 ? 0 : i % 1000 } };
+                auto previous = sched.calculate_previous(from);
+
+                INFO("Schedule: " << schedule << ", from: " << from.time_since_epoch().count());
+
+                if (std::get<0>(previous))
+                {
+                    auto prev = std::get<1>(previous);
+                    REQUIRE(prev < from);
+
+                    // The schedule allows the found time...
+                    auto at = sched.calculate_from(prev);
+                    REQUIRE(std::get<0>(at));
+                    REQUIRE(std::get<1>(at) == prev);
+
+                    // ...and nothing in between it and from.
+                    auto after = sched.calculate_from(prev + seconds{ 1 });
+                    REQUIRE((!std::get<0>(after) || std::get<1>(after) >= from));
+                }
+                else
+                {
+                    // Nothing allowed within the last 400 years means never, so also not going forward.
+                    REQUIRE_FALSE(std::get<0>(sched.calculate_from(from)));
+                }
+
+                ++compared;
+            }
+        }
+    }
+
+    GIVEN("Fixed schedules")
+    {
+        auto previous = [](const std::string& schedule, system_clock::time_point from)
+        {
+            return CronSchedule{ CronData::create(schedule) }.calculate_previous(from);
+        };
+
+        THEN("A schedule at the given time doesn't count")
+        {
+            auto res = previous("0 0 12 * * ?", DT(2022_y / 4 / 14, hours{ 12 }));
+            REQUIRE(std::get<0>(res));
+            REQUIRE(std::get<1>(res) == DT(2022_y / 4 / 13, hours{ 12 }));
+        }
+
+        THEN("A schedule within the same second as the fraction of the given time counts")
+        {
+            auto res = previous("0 0 12 * * ?", DT(2022_y / 4 / 14, hours{ 12 }) + milliseconds{ 500 });
+            REQUIRE(std::get<0>(res));
+            REQUIRE(std::get<1>(res) == DT(2022_y / 4 / 14, hours{ 12 }));
+        }
+
+        THEN("Borrowing from days, months and years")
+        {
+            auto res = previous("0 45 23 * * ?", DT(2022_y / 1 / 1, hours{ 10 }));
+            REQUIRE(std::get<0>(res));
+            REQUIRE(std::get<1>(res) == DT(2021_y / 12 / 31, hours{ 23 }, minutes{ 45 }));
+        }
+
+        THEN("Leap days")
+        {
+            auto res = previous("0 0 0 29 2 ?", DT(2104_y / 2 / 28));
+            REQUIRE(std::get<0>(res));
+            REQUIRE(std::get<1>(res) == DT(2096_y / 2 / 29));
+        }
+
+        THEN("Last day of a short month")
+        {
+            auto res = previous("0 0 0 31 * ?", DT(2022_y / 5 / 1));
+            REQUIRE(std::get<0>(res));
+            REQUIRE(std::get<1>(res) == DT(2022_y / 3 / 31));
+        }
+
+        THEN("Day of week")
+        {
+            // 2022-04-14 is a Thursday
+            auto res = previous("0 0 8 ? * FRI", DT(2022_y / 4 / 14, hours{ 12 }));
+            REQUIRE(std::get<0>(res));
+            REQUIRE(std::get<1>(res) == DT(2022_y / 4 / 8, hours{ 8 }));
+        }
+
+        THEN("A schedule that never happens")
+        {
+            REQUIRE_FALSE(std::get<0>(previous("0 0 0 31 2 ?", DT(2022_y / 1 / 1))));
+        }
+    }
+}
@@ -1,8 +1,19 @@
 #include <catch.hpp>
 #include <libcron/include/libcron/Cron.h>
+#include <libcron/include/libcron/CronRunner.h>
+#include <libcron/include/libcron/ConcurrentCron.h>
+#include <libcron/include/libcron/ShardedCron.h>
+#include <libcron/include/libcron/Coroutine.h>
 #include <libcron/externals/date/include/date/date.h>
 #include <thread>
 #include <iostream>
+#include <random>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <set>
+#include <sstream>
+#include <tuple>
 
 using namespace libcron;
 using namespace std::chrono;
@@ -344,6 +355,61 @@ SCENARIO("Clock changes")
     }
 }
 
+SCENARIO("Rescheduling tasks with many expressions")
+{
+    GIVEN("A Cron instance with more expressions than memos of next schedules")
+    {
+        Cron<TestClock> c{};
+        auto& clock = c.get_clock();
+        clock.set(sys_days{2018_y / 05 / 05});
+
+        for (size_t i = 0; i < 5000; ++i)
+        {
+            // Tasks sharing expressions are spread out
+            auto e = (i * 7) % 3600;
+            REQUIRE(c.add_schedule("Task-" + std::to_string(i),
+                                   std::to_string(e % 60) + " " + std::to_string(e / 60) + " * * * ?",
+                                   [](auto&) {}));
+        }
+
+        auto require_scheduled_from = [&c](system_clock::time_point from)
+        {
+            c.for_each_task([from](const Task& t)
+                            {
+                                auto expected = t.get_schedule().calculate_from(from);
+                                REQUIRE(std::get<0>(expected));
+
+                                // Those due right away have already run and been scheduled again
+                                if (std::get<1>(expected) > from)
+                                {
+                                    REQUIRE(t.get_state().next_schedule == std::get<1>(expected));
+                                }
+                            });
+        };
+
+        WHEN("The clock is moved forward >= 3h")
+        {
+            clock.add(hours{5});
+            c.tick();
+
+            THEN("Each task is rescheduled by its own expression")
+            {
+                require_scheduled_from(clock.now());
+            }
+        }
+        AND_WHEN("The schedules are recalculated")
+        {
+            clock.add(minutes{90});
+            c.recalculate_schedule();
+
+            THEN("Each task is rescheduled by its own expression")
+            {
+                require_scheduled_from(clock.now());
+            }
+        }
+    }
+}
+
 SCENARIO("Multiple ticks per second")
 {
     Cron<TestClock> c{};
@@ -448,3 +514,1660 @@ SCENARIO("Tasks can be added and removed from the scheduler")
         }
     }
 }
+
+SCENARIO("Heap based task queue")
+{
+    GIVEN("A Cron instance using a heap based task queue")
+    {
+        Cron<TestClock, NullLock, HeapTaskQueue> c{};
+        c.get_clock().set(sys_days{ 2020_y / 1 / 1 } + 1s);
+
+        int a = 0;
+        int b = 0;
+
+        REQUIRE(c.add_schedule("A", "*/2 * * * * ?", [&a](auto&) { a++; }));
+        REQUIRE(c.add_schedule("B", "*/3 * * * * ?", [&b](auto&) { b++; }));
+
+        THEN("Time until next is the earliest schedule")
+        {
+            REQUIRE(c.time_until_next() == 1s);
+        }
+        AND_WHEN("Ticking for a minute")
+        {
+            for (int i = 0; i < 60; ++i)
+            {
+                c.get_clock().add(1s);
+                c.tick();
+            }
+
+            THEN("Each task ran as often as scheduled")
+            {
+                REQUIRE(a == 30);
+                REQUIRE(b == 20);
+            }
+        }
+        AND_WHEN("Removing a task")
+        {
+            c.remove_schedule("A");
+
+            for (int i = 0; i < 60; ++i)
+            {
+                c.get_clock().add(1s);
+                c.tick();
+            }
+
+            THEN("Only the remaining task runs")
+            {
+                REQUIRE(c.count() == 1);
+                REQUIRE(a == 0);
+                REQUIRE(b == 20);
+            }
+        }
+    }
+}
+
+SCENARIO("Task queue backends behave the same")
+{
+    GIVEN("The same set of tasks in a vector, a heap and a group based Cron instance")
+    {
+        Cron<TestClock> vector_cron{};
+        Cron<TestClock, NullLock, HeapTaskQueue> heap_cron{};
+        Cron<TestClock, NullLock, GroupedTaskQueue> grouped_cron{};
+
+        auto start = sys_days{ 2021_y / 3 / 27 } + 22h;
+        vector_cron.get_clock().set(start);
+        heap_cron.get_clock().set(start);
+        grouped_cron.get_clock().set(start);
+
+        const std::vector<std::string> schedules{
+                "* * * * * ?",
+                "*/7 * * * * ?",
+                "0 * * * * ?",
+                "15,45 */2 * * * ?",
+                "0 0 * * * ?",
+                "30 59 23 * * ?",
+                "0 0 0 ? * SUN",
+                "0 0 12 29 2 ?"
+        };
+
+        std::mt19937 rng{ 4711 };
+        std::vector<std::string> vector_executed;
+        std::vector<std::string> heap_executed;
+        std::vector<std::string> grouped_executed;
+
+        for (int i = 0; i < 100; ++i)
+        {
+            auto name = "Task-" + std::to_string(i);
+            auto& schedule = schedules[rng() % schedules.size()];
+
+            REQUIRE(vector_cron.add_schedule(name, schedule, [&vector_executed](auto& i)
+            {
+                vector_executed.emplace_back(i.get_name());
+            }));
+            REQUIRE(heap_cron.add_schedule(name, schedule, [&heap_executed](auto& i)
+            {
+                heap_executed.emplace_back(i.get_name());
+            }));
+            REQUIRE(grouped_cron.add_schedule(name, schedule, [&grouped_executed](auto& i)
+            {
+                grouped_executed.emplace_back(i.get_name());
+            }));
+        }
+
+        WHEN("Ticking, adding, updating and removing tasks and changing the clock")
+        {
+            bool same = true;
+
+            for (int i = 0; i < 20000 && same; ++i)
+            {
+                auto r = rng() % 1000;
+
+                if (r < 30)
+                {
+                    auto name = "Task-" + std::to_string(rng() % 100);
+                    auto& schedule = schedules[rng() % schedules.size()];
+                    same = vector_cron.has_schedule(name) == heap_cron.has_schedule(name)
+                           && vector_cron.has_schedule(name) == grouped_cron.has_schedule(name);
+
+                    if (r == 0)
+                    {
+                        vector_cron.remove_schedule(name);
+                        heap_cron.remove_schedule(name);
+                        grouped_cron.remove_schedule(name);
+                    }
+                    else if (r < 10 && !vector_cron.has_schedule(name))
+                    {
+                        vector_cron.add_schedule(name, schedule, [&vector_executed](auto& i)
+                        {
+                            vector_executed.emplace_back(i.get_name());
+                        });
+                        heap_cron.add_schedule(name, schedule, [&heap_executed](auto& i)
+                        {
+                            heap_executed.emplace_back(i.get_name());
+                        });
+                        grouped_cron.add_schedule(name, schedule, [&grouped_executed](auto& i)
+                        {
+                            grouped_executed.emplace_back(i.get_name());
+                        });
+                    }
+                    else
+                    {
+                        auto updated = vector_cron.update_schedule(name, schedule);
+                        same = same
+                               && updated == heap_cron.update_schedule(name, schedule)
+                               && updated == grouped_cron.update_schedule(name, schedule);
+                    }
+                }
+
+                auto step = r == 1 ? hours{ 5 } : r == 2 ? -hours{ 4 } : seconds{ 1 } * static_cast<int>(1 + r % 3);
+                vector_cron.get_clock().add(step);
+                heap_cron.get_clock().add(step);
+                grouped_cron.get_clock().add(step);
+
+                vector_executed.clear();
+                heap_executed.clear();
+                grouped_executed.clear();
+
+                auto ticked = vector_cron.tick();
+                same = same
+                       && ticked == heap_cron.tick()
+                       && ticked == grouped_cron.tick()
+                       && vector_cron.count() == heap_cron.count()
+                       && vector_cron.count() == grouped_cron.count()
+                       && vector_cron.time_until_next() == heap_cron.time_until_next()
+                       && vector_cron.time_until_next() == grouped_cron.time_until_next();
+
+                // Tasks that expire at the same time, may run in any order.
+                std::sort(vector_executed.begin(), vector_executed.end());
+                std::sort(heap_executed.begin(), heap_executed.end());
+                std::sort(grouped_executed.begin(), grouped_executed.end());
+                same = same && vector_executed == heap_executed && vector_executed == grouped_executed;
+            }
+
+            THEN("All run the same tasks")
+            {
+                REQUIRE(same);
+            }
+        }
+    }
+}
+
+template<typename CronType>
+void require_tasks_by_name()
+{
+    CronType c{};
+    c.get_clock().set(sys_days{ 2020_y / 1 / 1 } + 1s);
+
+    int runs = 0;
+
+    for (int i = 0; i < 10; ++i)
+    {
+        REQUIRE(c.add_schedule("Task-" + std::to_string(i), "0 0 * * * ?", [&runs](auto&) { runs++; }));
+    }
+
+    REQUIRE(c.has_schedule("Task-3"));
+    REQUIRE_FALSE(c.has_schedule("Task-10"));
+
+    REQUIRE(c.update_schedule("Task-3", "*/2 * * * * ?"));
+    REQUIRE_FALSE(c.update_schedule("Task-10", "* * * * * ?"));
+    REQUIRE_FALSE(c.update_schedule("Task-4", "not a schedule"));
+    REQUIRE(c.count() == 10);
+    REQUIRE(c.time_until_next() == 1s);
+
+    c.get_clock().add(1s);
+    REQUIRE(c.tick() == 1);
+    REQUIRE(runs == 1);
+
+    c.remove_schedule("Task-3");
+    REQUIRE_FALSE(c.has_schedule("Task-3"));
+    REQUIRE(c.has_schedule("Task-9"));
+    REQUIRE(c.count() == 9);
+    REQUIRE(c.time_until_next() == 59min + 58s);
+}
+
+SCENARIO("Tasks can be looked up and updated by name")
+{
+    GIVEN("A vector based task queue")
+    {
+        require_tasks_by_name<Cron<TestClock>>();
+    }
+    AND_GIVEN("A heap based task queue")
+    {
+        require_tasks_by_name<Cron<TestClock, NullLock, HeapTaskQueue>>();
+    }
+    AND_GIVEN("A group based task queue")
+    {
+        require_tasks_by_name<Cron<TestClock, NullLock, GroupedTaskQueue>>();
+    }
+}
+
+template<typename CronType>
+void require_unique_names()
+{
+    CronType c{};
+    c.get_clock().set(sys_days{ 2020_y / 1 / 1 } + 1s);
+
+    int first = 0;
+    int second = 0;
+    TaskHandle first_handle;
+    REQUIRE(c.add_schedule("A", "0 0 * * * ?", [&first](auto&) { first++; }, first_handle));
+    REQUIRE(c.add_schedule("B", "0 0 * * * ?", [&first](auto&) { first++; }));
+
+    // The new task replaces the old one
+    REQUIRE(c.add_schedule("A", "* * * * * ?", [&second](auto&) { second++; }));
+    REQUIRE(c.count() == 2);
+    REQUIRE_FALSE(c.has_schedule(first_handle));
+
+    // As do those added at once, the last of those sharing a name being kept
+    std::vector<std::pair<std::string, std::string>> schedules{ { "B", "0 0 * * * ?" }, { "C", "0 0 * * * ?" },
+                                                                { "B", "* * * * * ?" } };
+    REQUIRE(std::get<0>(c.add_schedule(schedules, [&second](auto&) { second++; })));
+    REQUIRE(c.count() == 3);
+
+    c.get_clock().add(1s);
+    REQUIRE(c.tick() == 2);
+    REQUIRE(first == 0);
+    REQUIRE(second == 2);
+}
+
+SCENARIO("Task names are unique")
+{
+    GIVEN("A vector based task queue")
+    {
+        require_unique_names<Cron<TestClock>>();
+    }
+    AND_GIVEN("A heap based task queue")
+    {
+        require_unique_names<Cron<TestClock, NullLock, HeapTaskQueue>>();
+    }
+    AND_GIVEN("A group based task queue")
+    {
+        require_unique_names<Cron<TestClock, NullLock, GroupedTaskQueue>>();
+    }
+}
+
+template<typename CronType>
+void require_changeset()
+{
+    CronType c{};
+    c.get_clock().set(sys_days{ 2020_y / 1 / 1 } + 1s);
+
+    int old_runs = 0;
+    int new_runs = 0;
+    REQUIRE(c.add_schedule("A", "0 0 * * * ?", [&old_runs](auto&) { old_runs++; }));
+    REQUIRE(c.add_schedule("B", "0 0 * * * ?", [&old_runs](auto&) { old_runs++; }));
+
+    Changeset changes;
+    changes.add("C", "* * * * * ?", [](auto&) {});
+    changes.add("A", "* * * * * ?", [](auto&) {});
+    changes.add("D", "not a schedule", [](auto&) {});
+    changes.replace("B", "*/2 * * * * ?", [&new_runs](auto&) { new_runs++; });
+    changes.replace("X", "* * * * * ?");
+    changes.remove("A");
+    changes.remove("A");
+    // About tasks added by the same changeset
+    changes.replace("C", "0 0 * * * ?");
+    changes.add("F", "* * * * * ?", [](auto&) {});
+    changes.remove("F");
+    changes.add("F", "0 0 * * * ?", [](auto&) {});
+    changes.replace("B", "not a schedule");
+
+    std::vector<ChangeStatus> status;
+    REQUIRE(c.apply(changes, status) == 7);
+    REQUIRE(status == std::vector<ChangeStatus>{ ChangeStatus::Applied, ChangeStatus::AlreadyExists,
+                                                 ChangeStatus::InvalidSchedule, ChangeStatus::Applied,
+                                                 ChangeStatus::NotFound, ChangeStatus::Applied,
+                                                 ChangeStatus::NotFound, ChangeStatus::Applied,
+                                                 ChangeStatus::Applied, ChangeStatus::Applied,
+                                                 ChangeStatus::Applied, ChangeStatus::InvalidSchedule });
+
+    REQUIRE(c.count() == 3);
+    REQUIRE_FALSE(c.has_schedule("A"));
+    REQUIRE(c.has_schedule("C"));
+    REQUIRE(c.has_schedule("F"));
+    REQUIRE(c.time_until_next() == 1s);
+
+    c.get_clock().add(1s);
+    REQUIRE(c.tick() == 1);
+    REQUIRE(new_runs == 1);
+    REQUIRE(old_runs == 0);
+
+    AND_THEN("An empty changeset changes nothing")
+    {
+        REQUIRE(c.apply(Changeset{}, status) == 0);
+        REQUIRE(status.empty());
+        REQUIRE(c.count() == 3);
+    }
+}
+
+SCENARIO("Applying changesets")
+{
+    GIVEN("A vector based task queue")
+    {
+        require_changeset<Cron<TestClock>>();
+    }
+    AND_GIVEN("A heap based task queue")
+    {
+        require_changeset<Cron<TestClock, NullLock, HeapTaskQueue>>();
+    }
+    AND_GIVEN("A group based task queue")
+    {
+        require_changeset<Cron<TestClock, NullLock, GroupedTaskQueue>>();
+    }
+
+    GIVEN("Many tasks added and replaced in one changeset")
+    {
+        Cron<TestClock, NullLock, HeapTaskQueue> c{};
+        c.get_clock().set(sys_days{ 2020_y / 1 / 1 } + 30min + 10s);
+        Changeset changes;
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            changes.add("Task-" + std::to_string(i), std::to_string(i % 60) + " * * * * ?", [](auto&) {});
+        }
+
+        std::vector<ChangeStatus> status;
+        REQUIRE(c.apply(changes, status) == 1000);
+        changes.clear();
+
+        for (int i = 0; i < 1000; i += 100)
+        {
+            changes.replace("Task-" + std::to_string(i), "0 0 * * * ?");
+        }
+
+        REQUIRE(c.apply(changes, status) == 10);
+
+        THEN("The queue is in order")
+        {
+            // 17 tasks each are due at 00:30:10 and 00:30:11
+            c.get_clock().add(1s);
+            REQUIRE(c.tick() == 34);
+            // All but those due at 00:30:11 again, except the replaced ones
+            c.get_clock().add(59s);
+            REQUIRE(c.tick() == 1000 - 17 - 10);
+        }
+    }
+}
+
+template<typename CronType>
+void require_reconcile()
+{
+    CronType c{};
+    c.get_clock().set(sys_days{ 2020_y / 1 / 1 } + 1s);
+
+    int runs = 0;
+    REQUIRE(c.add_schedule("A", "0 0 * * * ?", [&runs](auto&) { runs++; }));
+    REQUIRE(c.add_schedule("B", "0 0 * * * ?", [&runs](auto&) { runs++; }));
+    REQUIRE(c.add_schedule("C", "0 0 12 * * ?", [&runs](auto&) { runs++; }));
+    REQUIRE(c.pause_schedule("A"));
+
+    auto state_of = [&c](const std::string& name)
+    {
+        Task::State res{};
+        c.for_each_task([&res, &name](const Task& t)
+                        {
+                            if (t.get_name() == name)
+                            {
+                                res = t.get_state();
+                            }
+                        });
+        return res;
+    };
+
+    auto a = state_of("A");
+    std::vector<std::string> new_tasks;
+    auto work_of = [&new_tasks, &runs](std::string_view name)
+    {
+        new_tasks.emplace_back(name);
+        return name == "F" ? Task::TaskFunction{} : Task::TaskFunction{ [&runs](auto&) { runs++; } };
+    };
+
+    std::map<std::string, std::string> desired{
+            { "A", "0 0 */1 * * ?" },      // The same, written differently
+            { "B", "* * * * * ?" },
+            { "D", "*/2 * * * * ?" },
+            { "E", "not a schedule" },
+            { "F", "* * * * * ?" }
+    };
+
+    REQUIRE(c.reconcile(desired, work_of) == 3);
+
+    THEN("Only the tasks that differ are changed")
+    {
+        REQUIRE(new_tasks == std::vector<std::string>{ "D", "F" });
+        REQUIRE(c.count() == 3);
+        REQUIRE_FALSE(c.has_schedule("C"));
+        REQUIRE(c.has_schedule("D"));
+        REQUIRE_FALSE(c.has_schedule("E"));
+
+        auto after = state_of("A");
+        REQUIRE(after.paused);
+        REQUIRE(after.next_schedule == a.next_schedule);
+        REQUIRE(after.last_run == a.last_run);
+
+        c.get_clock().add(1s);
+        REQUIRE(c.tick() == 2);
+        REQUIRE(runs == 2);
+    }
+    AND_THEN("Reconciling again changes nothing")
+    {
+        REQUIRE(c.reconcile(desired, work_of) == 0);
+        REQUIRE(c.count() == 3);
+    }
+    AND_THEN("Reconciling with nothing desired removes all tasks")
+    {
+        REQUIRE(c.reconcile(std::map<std::string, std::string>{}, work_of) == 3);
+        REQUIRE(c.count() == 0);
+    }
+}
+
+SCENARIO("Reconciling with the desired tasks")
+{
+    GIVEN("A vector based task queue")
+    {
+        require_reconcile<Cron<TestClock>>();
+    }
+    AND_GIVEN("A heap based task queue")
+    {
+        require_reconcile<Cron<TestClock, NullLock, HeapTaskQueue>>();
+    }
+    AND_GIVEN("A group based task queue")
+    {
+        require_reconcile<Cron<TestClock, NullLock, GroupedTaskQueue>>();
+    }
+}
+
+template<typename CronType>
+void require_tasks_by_handle()
+{
+    CronType c{};
+    c.get_clock().set(sys_days{ 2020_y / 1 / 1 } + 1s);
+
+    int runs = 0;
+    TaskHandle a;
+    TaskHandle b;
+
+    REQUIRE(c.add_schedule("A", "* * * * * ?", [&runs](auto&) { runs++; }, a));
+    REQUIRE(c.add_schedule("B", "0 0 * * * ?", [](auto&) {}, b));
+    REQUIRE(a.is_valid());
+    REQUIRE(a != b);
+    REQUIRE(c.has_schedule(a));
+
+    system_clock::duration until{};
+    REQUIRE(c.get_time_until_expiry(b, until));
+    REQUIRE(until == 59min + 59s);
+
+    // Paused tasks don't run, nor are they the next to expire.
+    REQUIRE(c.pause_schedule(a));
+    REQUIRE(c.time_until_next() == 59min + 59s);
+    c.get_clock().add(1s);
+    REQUIRE(c.tick() == 0);
+
+    REQUIRE(c.resume_schedule(a));
+    REQUIRE(c.tick() == 1);
+    REQUIRE(runs == 1);
+
+    REQUIRE(c.update_schedule(a, "0 30 * * * ?"));
+    REQUIRE(c.get_time_until_expiry(a, until));
+    REQUIRE(until == 29min + 58s);
+
+    // A removed task's handle is stale, even once its slot has been reused.
+    c.remove_schedule(a);
+    REQUIRE_FALSE(c.has_schedule(a));
+    REQUIRE_FALSE(c.has_schedule("A"));
+
+    TaskHandle d;
+    REQUIRE(c.add_schedule("D", "* * * * * ?", [](auto&) {}, d));
+    REQUIRE(d.slot == a.slot);
+    REQUIRE_FALSE(c.has_schedule(a));
+    REQUIRE_FALSE(c.pause_schedule(a));
+    REQUIRE_FALSE(c.update_schedule(a, "* * * * * ?"));
+    REQUIRE_FALSE(c.get_time_until_expiry(a, until));
+    c.remove_schedule(a);
+    REQUIRE(c.count() == 2);
+
+    REQUIRE(c.has_schedule(b));
+    REQUIRE(c.has_schedule(d));
+
+    c.clear_schedules();
+    REQUIRE_FALSE(c.has_schedule(b));
+    REQUIRE_FALSE(c.has_schedule(TaskHandle{}));
+}
+
+SCENARIO("Tasks can be controlled through handles")
+{
+    GIVEN("A vector based task queue")
+    {
+        require_tasks_by_handle<Cron<TestClock>>();
+    }
+    AND_GIVEN("A heap based task queue")
+    {
+        require_tasks_by_handle<Cron<TestClock, NullLock, HeapTaskQueue>>();
+    }
+    AND_GIVEN("A group based task queue")
+    {
+        require_tasks_by_handle<Cron<TestClock, NullLock, GroupedTaskQueue>>();
+    }
+}
+
+SCENARIO("Dispatching tasks to an executor")
+{
+    GIVEN("A Cron instance with an executor that holds on to the jobs")
+    {
+        std::vector<std::function<void()>> posted;
+        Cron<TestClock> c{ [&posted](std::function<void()> job) { posted.push_back(std::move(job)); } };
+        c.get_clock().set(sys_days{ 2020_y / 1 / 1 });
+
+        int runs = 0;
+        std::vector<system_clock::duration> delays;
+        REQUIRE(c.add_schedule("Task", "* * * * * ?", [&runs, &delays](auto& i)
+        {
+            runs++;
+            delays.push_back(i.get_delay());
+        }));
+
+        WHEN("Ticking")
+        {
+            c.get_clock().add(2s);
+            REQUIRE(c.tick() == 1);
+
+            THEN("The task is dispatched rather than run")
+            {
+                REQUIRE(runs == 0);
+                REQUIRE(posted.size() == 1);
+
+                posted[0]();
+                REQUIRE(runs == 1);
+                // Scheduled at midnight, dispatched two seconds later
+                REQUIRE(delays[0] >= 2s);
+            }
+        }
+        AND_WHEN("Ticking while the previous run is in progress and overlapping runs are allowed")
+        {
+            c.get_clock().add(1s);
+            c.tick();
+            c.get_clock().add(1s);
+            c.tick();
+
+            THEN("Both runs are dispatched")
+            {
+                REQUIRE(posted.size() == 2);
+            }
+        }
+        AND_WHEN("Ticking while the previous run is in progress and overlapping runs are skipped")
+        {
+            REQUIRE(c.set_overlap_policy("Task", OverlapPolicy::Skip));
+            c.get_clock().add(1s);
+            c.tick();
+            c.get_clock().add(1s);
+            REQUIRE(c.tick() == 1);
+
+            THEN("The second run is skipped")
+            {
+                REQUIRE(posted.size() == 1);
+                posted[0]();
+                REQUIRE(runs == 1);
+
+                AND_THEN("Runs are dispatched again once the previous one has finished")
+                {
+                    c.get_clock().add(1s);
+                    c.tick();
+                    REQUIRE(posted.size() == 2);
+                }
+            }
+        }
+        AND_WHEN("Ticking while the previous run is in progress and overlapping runs are queued")
+        {
+            REQUIRE(c.set_overlap_policy("Task", OverlapPolicy::Queue));
+
+            for (int i = 0; i < 3; ++i)
+            {
+                c.get_clock().add(1s);
+                c.tick();
+            }
+
+            THEN("The queued runs follow the first one")
+            {
+                REQUIRE(posted.size() == 1);
+                posted[0]();
+                REQUIRE(runs == 3);
+            }
+        }
+    }
+    AND_GIVEN("A Cron instance using a thread pool")
+    {
+        std::atomic<int> runs{ 0 };
+
+        {
+            ThreadPool pool{ 2 };
+            Cron<TestClock> c{ pool.get_executor() };
+            c.get_clock().set(sys_days{ 2020_y / 1 / 1 });
+
+            for (int i = 0; i < 10; ++i)
+            {
+                REQUIRE(c.add_schedule("Task-" + std::to_string(i), "* * * * * ?", [&runs](auto&) { runs++; }));
+            }
+
+            for (int i = 0; i < 10; ++i)
+            {
+                c.get_clock().add(1s);
+                c.tick();
+            }
+        }
+
+        THEN("All tasks have run once the pool is done")
+        {
+            REQUIRE(runs == 100);
+        }
+    }
+}
+
+SCENARIO("Work ending its runs later")
+{
+    GIVEN("A Cron instance with a task deferring the end of its runs")
+    {
+        Cron<TestClock> c;
+        c.get_clock().set(sys_days{ 2020_y / 1 / 1 });
+
+        int runs = 0;
+        std::vector<RunCompletion> pending;
+        REQUIRE(c.add_schedule("Task", "* * * * * ?", [&runs, &pending](auto& i)
+        {
+            runs++;
+            pending.push_back(i.defer_completion());
+        }));
+
+        WHEN("Overlapping runs are allowed")
+        {
+            c.get_clock().add(1s);
+            c.tick();
+            c.get_clock().add(1s);
+            c.tick();
+
+            THEN("Both runs are made, without tracking them")
+            {
+                REQUIRE(runs == 2);
+                REQUIRE_FALSE(pending[0]);
+                REQUIRE_FALSE(pending[1]);
+            }
+        }
+        AND_WHEN("Overlapping runs are skipped")
+        {
+            REQUIRE(c.set_overlap_policy("Task", OverlapPolicy::Skip));
+            c.get_clock().add(1s);
+            c.tick();
+            c.get_clock().add(1s);
+            REQUIRE(c.tick() == 1);
+
+            THEN("The second run is skipped until the first has ended")
+            {
+                REQUIRE(runs == 1);
+                REQUIRE(pending[0]);
+                pending[0]();
+                // Ending a run again does nothing.
+                pending[0]();
+
+                c.get_clock().add(1s);
+                c.tick();
+                REQUIRE(runs == 2);
+            }
+            AND_THEN("Dropping the completion ends the run")
+            {
+                pending.clear();
+                c.get_clock().add(1s);
+                c.tick();
+                REQUIRE(runs == 2);
+            }
+        }
+        AND_WHEN("Overlapping runs are queued")
+        {
+            REQUIRE(c.set_overlap_policy("Task", OverlapPolicy::Queue));
+
+            for (int i = 0; i < 3; ++i)
+            {
+                c.get_clock().add(1s);
+                c.tick();
+            }
+
+            THEN("Each queued run is made when the one before it has ended")
+            {
+                REQUIRE(runs == 1);
+                pending[0]();
+                REQUIRE(runs == 2);
+                pending[1]();
+                REQUIRE(runs == 3);
+                pending[2]();
+                REQUIRE(runs == 3);
+            }
+        }
+    }
+    AND_GIVEN("A Cron instance with an executor and a task ending its runs later")
+    {
+        std::vector<std::function<void()>> posted;
+        Cron<TestClock> c{ [&posted](std::function<void()> job) { posted.push_back(std::move(job)); } };
+        c.get_clock().set(sys_days{ 2020_y / 1 / 1 });
+
+        int runs = 0;
+        std::vector<RunCompletion> pending;
+        REQUIRE(c.add_schedule("Task", "* * * * * ?", [&runs, &pending](auto& i)
+        {
+            runs++;
+            pending.push_back(i.defer_completion());
+        }));
+        REQUIRE(c.set_overlap_policy("Task", OverlapPolicy::Skip));
+
+        WHEN("Running the dispatched job")
+        {
+            c.get_clock().add(1s);
+            c.tick();
+            posted[0]();
+            c.get_clock().add(1s);
+            c.tick();
+
+            THEN("The run is in progress until it has ended")
+            {
+                REQUIRE(runs == 1);
+                REQUIRE(posted.size() == 1);
+
+                pending[0]();
+                c.get_clock().add(1s);
+                c.tick();
+                REQUIRE(posted.size() == 2);
+            }
+        }
+    }
+}
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L && __has_include(<coroutine>)
+SCENARIO("Coroutines as work")
+{
+    GIVEN("A Cron instance with a coroutine continuing on an event loop")
+    {
+        Cron<TestClock> c;
+        c.get_clock().set(sys_days{ 2020_y / 1 / 1 });
+
+        std::vector<std::function<void()>> loop;
+        Executor on_loop = [&loop](std::function<void()> job) { loop.push_back(std::move(job)); };
+
+        auto run_next = [&loop]()
+        {
+            auto job = std::move(loop.front());
+            loop.erase(loop.begin());
+            job();
+        };
+
+        int started = 0;
+        std::vector<std::string> finished;
+        REQUIRE(c.add_schedule("Task", "* * * * * ?", async_work([&](AsyncTaskInformation info) -> AsyncWork
+        {
+            started++;
+            co_await resume_on(on_loop);
+            finished.emplace_back(info.get_name());
+        })));
+        REQUIRE(c.set_overlap_policy("Task", OverlapPolicy::Skip));
+
+        WHEN("Ticking")
+        {
+            c.get_clock().add(1s);
+            c.tick();
+
+            THEN("The coroutine is suspended on the loop")
+            {
+                REQUIRE(started == 1);
+                REQUIRE(finished.empty());
+                REQUIRE(loop.size() == 1);
+            }
+            AND_WHEN("Ticking again before the loop has run")
+            {
+                c.get_clock().add(1s);
+                c.tick();
+
+                THEN("The run is skipped")
+                {
+                    REQUIRE(started == 1);
+                }
+            }
+            AND_WHEN("Running the loop, after the task has been removed")
+            {
+                c.remove_schedule("Task");
+                run_next();
+
+                THEN("The coroutine finishes, with what it was given")
+                {
+                    REQUIRE(finished == std::vector<std::string>{ "Task" });
+                }
+            }
+            AND_WHEN("Running the loop and ticking again")
+            {
+                run_next();
+                c.get_clock().add(1s);
+                c.tick();
+
+                THEN("The next run has started")
+                {
+                    REQUIRE(finished.size() == 1);
+                    REQUIRE(started == 2);
+                    REQUIRE(loop.size() == 1);
+                    run_next();
+                    REQUIRE(finished.size() == 2);
+                }
+            }
+        }
+
+        // Let the coroutines still suspended finish.
+        while (!loop.empty())
+        {
+            run_next();
+        }
+    }
+}
+#endif
+
+SCENARIO("Time until next when no task will expire")
+{
+    GIVEN("A Cron instance without tasks")
+    {
+        Cron<TestClock> c{};
+        system_clock::duration until{};
+
+        THEN("There is no next task")
+        {
+            REQUIRE_FALSE(c.time_until_next(until));
+        }
+        AND_WHEN("Adding a task")
+        {
+            c.get_clock().set(sys_days{ 2020_y / 1 / 1 } + 1s);
+            REQUIRE(c.add_schedule("Task", "0 0 * * * ?", [](auto&) {}));
+
+            THEN("It is the next task")
+            {
+                REQUIRE(c.time_until_next(until));
+                REQUIRE(until == 59min + 59s);
+            }
+            AND_WHEN("Pausing it")
+            {
+                c.pause_schedule("Task");
+
+                THEN("There is no next task")
+                {
+                    REQUIRE_FALSE(c.time_until_next(until));
+                }
+            }
+        }
+    }
+}
+
+// The system clock, shifted by an offset that may be changed from any thread.
+class JumpingClock
+        : public ICronClock
+{
+    public:
+        std::chrono::system_clock::time_point now() const override
+        {
+            return system_clock::now() + system_clock::duration{ offset.load() };
+        }
+
+        std::chrono::seconds utc_offset(std::chrono::system_clock::time_point) const override
+        {
+            return 0s;
+        }
+
+        void jump(system_clock::duration time)
+        {
+            offset += time.count();
+        }
+
+    private:
+        std::atomic<system_clock::rep> offset{ 0 };
+};
+
+SCENARIO("Running a Cron instance until stopped")
+{
+    GIVEN("A runner without tasks")
+    {
+        Cron<UTCClock, Locker> c{};
+        CronRunner<Cron<UTCClock, Locker>> runner{ c };
+        std::thread t{ [&runner]() { runner.run(); } };
+
+        WHEN("Adding a task from another thread")
+        {
+            std::atomic<int> runs{ 0 };
+            REQUIRE(c.add_schedule("Task", "* * * * * ?", [&runs](auto&) { runs++; }));
+
+            // Without waking up, the runner would sleep for a minute.
+            std::this_thread::sleep_for(2500ms);
+            runner.stop();
+            t.join();
+
+            THEN("The runner wakes up to run it")
+            {
+                REQUIRE(runs >= 1);
+            }
+        }
+    }
+    AND_GIVEN("A runner with a task that stops it")
+    {
+        Cron<UTCClock, Locker> c{};
+        CronRunner<Cron<UTCClock, Locker>> runner{ c };
+        int runs = 0;
+
+        REQUIRE(c.add_schedule("Task", "* * * * * ?", [&runs, &runner](auto&)
+        {
+            runs++;
+            runner.stop();
+        }));
+
+        WHEN("Running")
+        {
+            runner.run();
+
+            THEN("The task ran once")
+            {
+                REQUIRE(runs == 1);
+            }
+        }
+    }
+    AND_GIVEN("A runner sleeping until a task expires half a minute later")
+    {
+        using CronType = Cron<JumpingClock, Locker>;
+        CronType c{};
+        // Half past the current minute, or the next one.
+        auto since_epoch = c.get_clock().now().time_since_epoch();
+        c.get_clock().jump(seconds{ (90 - duration_cast<seconds>(since_epoch).count() % 60) % 60 } - since_epoch % 1s);
+
+        std::atomic<int> runs{ 0 };
+        REQUIRE(c.add_schedule("Task", "0 * * * * ?", [&runs](auto&) { runs++; }));
+
+        CronRunner<CronType> runner{ c };
+        std::thread t{ [&runner]() { runner.run(); } };
+
+        WHEN("The clock jumps forward past the task")
+        {
+            std::this_thread::sleep_for(500ms);
+            c.get_clock().jump(30s);
+            std::this_thread::sleep_for(2500ms);
+            runner.stop();
+            t.join();
+
+            THEN("The runner notices the jump and runs the task")
+            {
+                REQUIRE(runs == 1);
+            }
+        }
+    }
+    AND_GIVEN("A runner and a thread reading the tasks")
+    {
+        using CronType = Cron<UTCClock, Locker, HeapTaskQueue>;
+        CronType c{};
+        CronRunner<CronType> runner{ c };
+        std::atomic<bool> reading{ true };
+        std::atomic<int> found{ 0 };
+        std::thread t{ [&runner]() { runner.run(); } };
+
+        TaskHandle first;
+        REQUIRE(c.add_schedule("Task 0", "* * * * * ?", [](auto&) {}, first));
+
+        std::thread reader{ [&c, &reading, &found, first]()
+                            {
+                                std::vector<std::tuple<std::string, system_clock::duration>> status;
+                                std::ostringstream stream;
+
+                                while (reading)
+                                {
+                                    system_clock::duration until{};
+                                    found += c.has_schedule("Task 1") + c.has_schedule(first);
+                                    found += c.get_time_until_expiry(first, until) + c.time_until_next(until);
+                                    found += c.count() > 0;
+                                    c.time_until_next();
+                                    c.get_time_until_expiry_for_tasks(status);
+                                    stream << c;
+                                    stream.str("");
+                                }
+                            } };
+
+        WHEN("Adding and removing tasks while it ticks")
+        {
+            for (int i = 0; i < 2000; ++i)
+            {
+                TaskHandle h;
+                REQUIRE(c.add_schedule("Task " + std::to_string(1 + i % 50), "* * * * * ?", [](auto&) {}, h));
+
+                if (i % 3 > 0)
+                {
+                    c.remove_schedule(h);
+                }
+
+                std::this_thread::sleep_for(1ms);
+            }
+
+            reading = false;
+            reader.join();
+            runner.stop();
+            t.join();
+
+            THEN("The readers see the tasks as they are")
+            {
+                REQUIRE(found > 0);
+                REQUIRE(c.has_schedule(first));
+                REQUIRE(c.count() > 1);
+            }
+        }
+    }
+}
+
+SCENARIO("Concurrent Cron")
+{
+    GIVEN("A concurrent Cron instance")
+    {
+        ConcurrentCron<TestClock, HeapTaskQueue> c{};
+        c.get_clock().set(sys_days{ 2020_y / 1 / 1 } + 1s);
+        std::atomic<int> runs{ 0 };
+
+        WHEN("Adding tasks from multiple threads")
+        {
+            std::vector<std::thread> threads;
+
+            for (int t = 0; t < 4; ++t)
+            {
+                threads.emplace_back([&c, &runs, t]()
+                                     {
+                                         for (int i = 0; i < 100; ++i)
+                                         {
+                                             c.add_schedule("Task-" + std::to_string(t) + "-" + std::to_string(i),
+                                                            "*/2 * * * * ?", [&runs](auto&) { runs++; });
+                                         }
+                                     });
+            }
+
+            for (auto& t : threads)
+            {
+                t.join();
+            }
+
+            THEN("They take effect on the next tick")
+            {
+                REQUIRE(c.count() == 0);
+                REQUIRE_FALSE(c.has_schedule("Task-0-0"));
+
+                c.get_clock().add(1s);
+                REQUIRE(c.tick() == 400);
+                REQUIRE(runs == 400);
+                REQUIRE(c.count() == 400);
+                REQUIRE(c.has_schedule("Task-3-99"));
+
+                auto snapshot = c.get_snapshot();
+                REQUIRE(snapshot->find("Task-1-1")->next_schedule == sys_days{ 2020_y / 1 / 1 } + 4s);
+
+                AND_WHEN("Ticking without changes")
+                {
+                    c.get_clock().add(2s);
+                    REQUIRE(c.tick() == 400);
+                    c.get_clock().add(1s);
+
+                    THEN("The snapshot is kept, with the time until expiry calculated from the schedules")
+                    {
+                        REQUIRE(c.get_snapshot() == snapshot);
+
+                        // Relative to the last tick, as readers don't use the clock, or to a given point in time.
+                        std::vector<std::tuple<std::string, system_clock::duration>> status;
+                        c.get_time_until_expiry_for_tasks(status);
+                        REQUIRE(status.size() == 400);
+                        REQUIRE(std::all_of(status.begin(), status.end(), [](auto& t) { return std::get<1>(t) == 2s; }));
+
+                        c.get_time_until_expiry_for_tasks(status, c.get_clock().now());
+                        REQUIRE(std::all_of(status.begin(), status.end(), [](auto& t) { return std::get<1>(t) == 1s; }));
+                    }
+                }
+
+                AND_WHEN("Removing and pausing tasks")
+                {
+                    c.remove_schedule("Task-0-0");
+                    c.pause_schedule("Task-0-1");
+                    c.get_clock().add(2s);
+                    REQUIRE(c.tick() == 398);
+
+                    THEN("A new snapshot is published, leaving the old one as it was")
+                    {
+                        REQUIRE(c.count() == 399);
+                        REQUIRE(c.get_snapshot()->find("Task-0-1")->paused);
+                        REQUIRE(snapshot->tasks.size() == 400);
+                        REQUIRE_FALSE(snapshot->find("Task-0-1")->paused);
+                    }
+                }
+            }
+        }
+        AND_WHEN("Adding an invalid schedule")
+        {
+            THEN("It is rejected right away")
+            {
+                REQUIRE_FALSE(c.add_schedule("Task", "not a schedule", [](auto&) {}));
+                REQUIRE_FALSE(c.update_schedule("Task", "not a schedule"));
+            }
+        }
+    }
+    AND_GIVEN("A runner for a concurrent Cron instance")
+    {
+        ConcurrentCron<UTCClock> c{};
+        CronRunner<ConcurrentCron<UTCClock>> runner{ c };
+        int runs = 0;
+
+        REQUIRE(c.add_schedule("Task", "* * * * * ?", [&runs, &runner](auto&)
+        {
+            runs++;
+            runner.stop();
+        }));
+
+        WHEN("Running")
+        {
+            runner.run();
+
+            THEN("The queued task ran")
+            {
+                REQUIRE(runs == 1);
+            }
+        }
+    }
+}
+
+template<typename CronType>
+void require_misfire_policies()
+{
+    CronType c{};
+    auto& clock = c.get_clock();
+    clock.set(sys_days{ 2022_y / 5 / 1 } + 1s);
+
+    std::vector<system_clock::duration> delays;
+
+    // Every minute
+    REQUIRE(c.add_schedule("Task", "0 * * * * ?", [&delays](auto& i)
+    {
+        delays.push_back(i.get_delay());
+    }));
+
+    c.tick();
+
+    WHEN("Missing schedules with the default policy")
+    {
+        clock.add(10min + 30s); // 00:10:31, schedules 00:01 to 00:10 missed
+        c.tick();
+
+        THEN("The task runs once")
+        {
+            REQUIRE(delays == std::vector<system_clock::duration>{ 9min + 31s });
+
+            auto stats = c.get_misfire_statistics();
+            REQUIRE(stats.misfired == 1);
+            REQUIRE(stats.runs == 1);
+            REQUIRE(stats.coalesced == 9);
+        }
+    }
+    AND_WHEN("Running each missed schedule")
+    {
+        MisfireOptions options{};
+        options.policy = MisfirePolicy::RunAll;
+        options.max_catch_up = 5;
+        c.set_misfire_options(options);
+
+        clock.add(10min + 30s);
+        c.tick();
+
+        THEN("The task runs for each missed schedule up to the limit")
+        {
+            REQUIRE(delays.size() == 5);
+
+            auto stats = c.get_misfire_statistics();
+            REQUIRE(stats.misfired == 1);
+            REQUIRE(stats.runs == 5);
+            REQUIRE(stats.coalesced == 5);
+        }
+    }
+    AND_WHEN("Skipping missed schedules")
+    {
+        MisfireOptions options{};
+        options.policy = MisfirePolicy::Skip;
+        c.set_misfire_options(options);
+
+        clock.add(10min + 30s);
+        c.tick();
+
+        THEN("The task waits for its next schedule")
+        {
+            REQUIRE(delays.empty());
+            REQUIRE(c.get_misfire_statistics().coalesced == 10);
+
+            clock.add(29s); // 00:11:00
+            c.tick();
+            REQUIRE(delays == std::vector<system_clock::duration>{ 0s });
+        }
+    }
+    AND_WHEN("Being late within the threshold")
+    {
+        MisfireOptions options{};
+        options.policy = MisfirePolicy::Skip;
+        c.set_misfire_options(options);
+
+        clock.add(59s + 30s); // 00:01:30
+        c.tick();
+
+        THEN("The task runs as usual")
+        {
+            REQUIRE(delays == std::vector<system_clock::duration>{ 30s });
+            REQUIRE(c.get_misfire_statistics().misfired == 0);
+        }
+    }
+    AND_WHEN("Jumping forward three hours or more")
+    {
+        MisfireOptions options{};
+        options.policy = MisfirePolicy::RunAll;
+        options.max_catch_up = 3;
+
+        THEN("The task is rescheduled by default")
+        {
+            c.set_misfire_options(options);
+            clock.add(5h);
+            c.tick();
+            REQUIRE(c.get_misfire_statistics().misfired == 0);
+        }
+        AND_THEN("Missed schedules can be caught up with")
+        {
+            options.catch_up_large_jumps = true;
+            c.set_misfire_options(options);
+            clock.add(5h);
+            c.tick();
+            REQUIRE(delays.size() == 3);
+            REQUIRE(c.get_misfire_statistics().coalesced == 300 - 3);
+        }
+    }
+}
+
+template<typename CronType>
+void require_bounded_catch_up()
+{
+    CronType c{};
+    auto& clock = c.get_clock();
+    clock.set(sys_days{ 2022_y / 5 / 1 } + 1s);
+
+    std::map<std::string, int> runs;
+    std::map<std::string, system_clock::time_point> last_runs;
+
+    for (int i = 0; i < 100; ++i)
+    {
+        auto name = "Task " + std::to_string(i);
+
+        // Every hour
+        REQUIRE(c.add_schedule(name, "0 0 * * * ?", [&runs, &last_runs, &clock, name](auto&)
+        {
+            ++runs[name];
+            last_runs[name] = clock.now();
+        }));
+    }
+
+    c.tick();
+    clock.add(2h); // 02:00:01, missed 01:00 and 02:00
+
+    // Ticks once a second, returning the most runs in one tick.
+    auto tick_for = [&c, &clock, &runs](seconds duration)
+    {
+        size_t res = 0;
+
+        for (auto end = clock.now() + duration; clock.now() < end; clock.add(1s))
+        {
+            size_t before = 0;
+
+            for (auto& r : runs)
+            {
+                before += static_cast<size_t>(r.second);
+            }
+
+            c.tick();
+            size_t after = 0;
+
+            for (auto& r : runs)
+            {
+                after += static_cast<size_t>(r.second);
+            }
+
+            res = std::max(res, after - before);
+        }
+
+        return res;
+    };
+
+    WHEN("Spreading the runs")
+    {
+        MisfireOptions options{};
+        options.spread = 60s;
+        c.set_misfire_options(options);
+
+        auto most = tick_for(62s);
+
+        THEN("Each task runs once, within the window")
+        {
+            REQUIRE(runs.size() == 100);
+            REQUIRE(std::all_of(runs.begin(), runs.end(), [](auto& r) { return r.second == 1; }));
+            REQUIRE(most < 100);
+            REQUIRE(c.get_misfire_statistics().runs == 100);
+
+            // By a hash of the name, so the same on all platforms.
+            REQUIRE(std::all_of(last_runs.begin(), last_runs.end(), [](auto& r)
+            {
+                return r.second == sys_days{ 2022_y / 5 / 1 } + 2h + 2s + CronType::spread_of(r.first, 60s);
+            }));
+            REQUIRE(c.get_misfire_statistics().coalesced == 100);
+        }
+    }
+    AND_WHEN("Limiting the runs per tick")
+    {
+        MisfireOptions options{};
+        options.max_runs_per_tick = 10;
+        c.set_misfire_options(options);
+
+        auto most = tick_for(12s);
+
+        THEN("Each task runs once, spread over the following ticks")
+        {
+            REQUIRE(runs.size() == 100);
+            REQUIRE(std::all_of(runs.begin(), runs.end(), [](auto& r) { return r.second == 1; }));
+            REQUIRE(most == 10);
+        }
+    }
+}
+
+template<typename CronType>
+void require_spread_independent_of_jitter()
+{
+    CronType c{};
+    auto& clock = c.get_clock();
+    clock.set(sys_days{ 2022_y / 5 / 1 } + 1s);
+    c.set_jitter(60s);
+
+    MisfireOptions options{};
+    options.spread = 60s;
+    c.set_misfire_options(options);
+
+    std::map<std::string, system_clock::time_point> first_runs;
+
+    for (int i = 0; i < 600; ++i)
+    {
+        auto name = "Task " + std::to_string(i);
+
+        // Every hour
+        REQUIRE(c.add_schedule(name, "0 0 * * * ?", [&first_runs, &clock, name](auto&)
+        {
+            first_runs.emplace(name, clock.now());
+        }));
+    }
+
+    // Runs the tasks with a jitter of a second.
+    c.tick();
+    first_runs.clear();
+    clock.add(2h); // 02:00:01, missed 01:00 plus the jitter of each task
+
+    for (auto end = clock.now() + 62s; clock.now() < end; clock.add(1s))
+    {
+        c.tick();
+    }
+
+    // The runs for the missed schedules are spread by a hash of their own, not following the jitter.
+    REQUIRE(first_runs.size() == 600);
+    size_t at_jitter = 0;
+
+    for (const auto& [name, time] : first_runs)
+    {
+        REQUIRE(time == sys_days{ 2022_y / 5 / 1 } + 2h + 2s + CronType::spread_of(name, 60s));
+        at_jitter += CronType::spread_of(name, 60s) == CronType::jitter_of(name, 60s);
+    }
+
+    // About 10 by chance
+    REQUIRE(at_jitter < 30);
+}
+
+SCENARIO("Missed schedules")
+{
+    GIVEN("A vector based task queue")
+    {
+        require_misfire_policies<Cron<TestClock>>();
+        require_bounded_catch_up<Cron<TestClock>>();
+        require_spread_independent_of_jitter<Cron<TestClock>>();
+    }
+    AND_GIVEN("A heap based task queue")
+    {
+        require_misfire_policies<Cron<TestClock, NullLock, HeapTaskQueue>>();
+        require_bounded_catch_up<Cron<TestClock, NullLock, HeapTaskQueue>>();
+        require_spread_independent_of_jitter<Cron<TestClock, NullLock, HeapTaskQueue>>();
+    }
+    AND_GIVEN("A group based task queue")
+    {
+        require_misfire_policies<Cron<TestClock, NullLock, GroupedTaskQueue>>();
+        require_bounded_catch_up<Cron<TestClock, NullLock, GroupedTaskQueue>>();
+        require_spread_independent_of_jitter<Cron<TestClock, NullLock, GroupedTaskQueue>>();
+    }
+}
+
+SCENARIO("Sharded Cron")
+{
+    GIVEN("A Cron instance with four shards")
+    {
+        ShardedCron<TestClock> c{ 4 };
+
+        for (size_t i = 0; i < c.shard_count(); ++i)
+        {
+            c.get_shard(i).get_clock().set(sys_days{ 2020_y / 1 / 1 } + 30s);
+        }
+
+        int runs = 0;
+
+        for (int i = 0; i < 1000; ++i)
+        {
+            REQUIRE(c.add_schedule("Task " + std::to_string(i), "0 * * * * ?", [&runs](auto&) { runs++; }));
+        }
+
+        THEN("The tasks are spread over the shards by name")
+        {
+            REQUIRE(c.shard_count() == 4);
+            REQUIRE(c.count() == 1000);
+
+            for (size_t i = 0; i < c.shard_count(); ++i)
+            {
+                REQUIRE(c.get_shard(i).count() > 150);
+            }
+
+            // The same on all platforms
+            auto shard = c.shard_of("Task 7");
+            REQUIRE(shard == 0);
+            REQUIRE(c.shard_of("Task 0") == 3);
+            REQUIRE(c.get_shard(shard).has_schedule("Task 7"));
+            REQUIRE(c.has_schedule("Task 7"));
+            REQUIRE_FALSE(c.has_schedule("Task 1000"));
+        }
+        AND_THEN("The time until the next task is that of the earliest shard")
+        {
+            c.get_shard(1).get_clock().add(10s);
+            system_clock::duration until{};
+            REQUIRE(c.time_until_next(until));
+            REQUIRE(until == 20s);
+        }
+        AND_WHEN("Removing and pausing tasks")
+        {
+            c.remove_schedule("Task 1");
+            REQUIRE(c.pause_schedule("Task 2"));
+            REQUIRE_FALSE(c.pause_schedule("Task 1"));
+
+            AND_WHEN("Ticking each shard")
+            {
+                c.tick();
+
+                for (size_t i = 0; i < c.shard_count(); ++i)
+                {
+                    c.get_shard(i).get_clock().add(30s);
+                }
+
+                REQUIRE(c.tick() == 998);
+
+                THEN("All other tasks ran")
+                {
+                    REQUIRE(runs == 998);
+                    REQUIRE(c.count() == 999);
+                }
+            }
+        }
+        AND_WHEN("Spreading the tasks over the minute with jitter")
+        {
+            c.set_jitter(60s);
+
+            THEN("The tasks due in each second are spread over the shards")
+            {
+                // The shards of the tasks due in each second of the minute
+                std::map<system_clock::duration, std::set<size_t>> shards_of;
+
+                for (size_t i = 0; i < c.shard_count(); ++i)
+                {
+                    std::vector<std::tuple<std::string, system_clock::duration>> status;
+                    c.get_shard(i).get_time_until_expiry_for_tasks(status);
+
+                    for (const auto& [name, time_until] : status)
+                    {
+                        shards_of[time_until].insert(i);
+                    }
+                }
+
+                REQUIRE(shards_of.size() == 60);
+                REQUIRE(std::all_of(shards_of.begin(), shards_of.end(), [](auto& s) { return s.second.size() > 1; }));
+            }
+        }
+        AND_WHEN("Clearing the tasks")
+        {
+            c.clear_schedules();
+
+            THEN("All shards are empty")
+            {
+                system_clock::duration until{};
+                REQUIRE(c.count() == 0);
+                REQUIRE_FALSE(c.time_until_next(until));
+            }
+        }
+    }
+    AND_GIVEN("A started Cron instance with a thread for each shard")
+    {
+        ShardedCron<UTCClock> c{ 3 };
+        std::atomic<int> runs{ 0 };
+        c.start();
+
+        WHEN("Adding tasks from another thread")
+        {
+            for (int i = 0; i < 30; ++i)
+            {
+                REQUIRE(c.add_schedule("Task " + std::to_string(i), "* * * * * ?", [&runs](auto&) { runs++; }));
+            }
+
+            // Each runner wakes up for the tasks of its shard, while the tasks are read from this thread.
+            size_t found = 0;
+
+            for (auto end = steady_clock::now() + 2500ms; steady_clock::now() < end;)
+            {
+                std::ostringstream stream;
+                stream << c;
+                found = c.count() + c.has_schedule("Task 29");
+                std::this_thread::sleep_for(1ms);
+            }
+
+            c.stop();
+
+            THEN("The tasks of all shards ran")
+            {
+                REQUIRE(runs >= 30);
+                REQUIRE(found == 31);
+            }
+        }
+    }
+}
+
+SCENARIO("Spreading runs over a window with jitter")
+{
+    GIVEN("Many tasks at the top of each minute")
+    {
+        Cron<TestClock> c{};
+        c.get_clock().set(sys_days{ 2020_y / 1 / 1 } + 1s);
+        int runs = 0;
+
+        for (int i = 0; i < 600; ++i)
+        {
+            REQUIRE(c.add_schedule("Task " + std::to_string(i), "0 * * * * ?", [&runs](auto&) { runs++; }));
+        }
+
+        WHEN("Spreading them over a minute")
+        {
+            c.set_jitter(60s);
+            int most_per_tick = 0;
+            c.tick();
+
+            for (int i = 0; i < 59; ++i)
+            {
+                auto before = runs;
+                c.get_clock().add(1s);
+                c.tick();
+                most_per_tick = std::max(most_per_tick, runs - before);
+            }
+
+            THEN("Each task ran once in the minute, with the runs spread over it")
+            {
+                REQUIRE(c.get_jitter() == 60s);
+                REQUIRE(runs == 600);
+                REQUIRE(most_per_tick < 40);
+                // 00:01:00 for the tasks without offset
+                REQUIRE(c.get_clock().now() == sys_days{ 2020_y / 1 / 1 } + 1min);
+            }
+            AND_THEN("The offsets are by name, the same across instances and platforms")
+            {
+                REQUIRE(Cron<TestClock>::jitter_of("Task 0", 60s) == 52s);
+                REQUIRE(Cron<TestClock>::jitter_of("Task 0", 1h) == 1852s);
+
+                Cron<TestClock, NullLock, HeapTaskQueue> other{};
+                other.get_clock().set(c.get_clock().now());
+                other.set_jitter(60s);
+
+                for (int i = 599; i >= 0; --i)
+                {
+                    REQUIRE(other.add_schedule("Task " + std::to_string(i), "0 * * * * ?", [](auto&) {}));
+                }
+
+                std::vector<std::tuple<std::string, system_clock::duration>> status;
+                std::vector<std::tuple<std::string, system_clock::duration>> other_status;
+                c.get_time_until_expiry_for_tasks(status);
+                other.get_time_until_expiry_for_tasks(other_status);
+                std::map<std::string, system_clock::duration> until;
+
+                for (const auto& [name, time_until] : other_status)
+                {
+                    until[name] = time_until;
+                }
+
+                REQUIRE(until.size() == 600);
+
+                for (const auto& [name, time_until] : status)
+                {
+                    auto offset = Cron<TestClock>::jitter_of(name, 60s);
+                    REQUIRE(until[name] == offset);
+
+                    // Other than those due right now, which already ran at c
+                    if (offset > 0s)
+                    {
+                        REQUIRE(time_until == offset);
+                    }
+                }
+            }
+            AND_WHEN("Turning it off")
+            {
+                c.set_jitter(0s);
+                runs = 0;
+                c.get_clock().add(1min);
+                c.tick();
+
+                THEN("All tasks run at the top of the minute again")
+                {
+                    REQUIRE(runs == 600);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,202 @@
+#include <catch.hpp>
+#include <date/date.h>
+#include <libcron/include/libcron/Cron.h>
+#include <libcron/include/libcron/CronRandomization.h>
+#include <libcron/include/libcron/Simulation.h>
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace libcron;
+using namespace date;
+using namespace std::chrono;
+
+namespace
+{
+    class FixedUTCClock
+            : public ICronClock
+    {
+        public:
+            system_clock::time_point now() const override
+            {
+                return current_time;
+            }
+
+            seconds utc_offset(system_clock::time_point) const override
+            {
+                return 0s;
+            }
+
+            void set(system_clock::time_point new_time)
+            {
+                current_time = new_time;
+            }
+
+            void add(system_clock::duration time)
+            {
+                current_time += time;
+            }
+
+        private:
+            system_clock::time_point current_time{};
+    };
+
+    system_clock::time_point at(int64_t t)
+    {
+        return system_clock::time_point{ seconds{ t } };
+    }
+}
+
+SCENARIO("Simulating schedules")
+{
+    GIVEN("A simulation of schedules sharing an expression")
+    {
+        Simulation s;
+        REQUIRE(s.add("Quarter 1", CronSchedule{ CronData::create("0 */15 * * * ?") }) == 0);
+        REQUIRE(s.add("Hourly", CronSchedule{ CronData::create("0 0 * * * ?") }) == 1);
+        // Parsed separately, but calculated together with the first.
+        REQUIRE(s.add("Quarter 2", CronSchedule{ CronData::create_shared("0 */15 * * * ?") }) == 2);
+        REQUIRE(s.add("Invalid", CronSchedule{ CronData::create("0 0 0 1 * MON") }) == 3);
+
+        const system_clock::time_point from = sys_days{ 2024_y / 1 / 1 };
+        const auto to = from + 24h;
+
+        WHEN("Running it for a day")
+        {
+            FireEvents events;
+            s.run(from, to, events);
+
+            THEN("All events are recorded in order of time")
+            {
+                REQUIRE(events.size() == 96 * 2 + 24);
+                REQUIRE(events.times.size() == 96);
+                REQUIRE(events.ends.back() == events.size());
+                REQUIRE(std::is_sorted(events.times.begin(), events.times.end()));
+                REQUIRE(at(events.times.front()) == from);
+                REQUIRE(at(events.times.back()) == to - 15min);
+                REQUIRE(events.peak() == 3);
+
+                auto first = std::vector<uint32_t>(events.schedules.begin(), events.schedules.begin() + 3);
+                std::sort(first.begin(), first.end());
+                REQUIRE(first == std::vector<uint32_t>{ 0, 1, 2 });
+                REQUIRE(events.ends[1] - events.ends[0] == 2);
+            }
+            AND_THEN("They can be counted per interval")
+            {
+                auto per_hour = events.counts(from, to, 1h);
+                REQUIRE(per_hour.size() == 24);
+                REQUIRE(std::all_of(per_hour.begin(), per_hour.end(), [](auto c) { return c == 9; }));
+
+                auto tail = events.counts(to - 90min, to, 1h);
+                REQUIRE(tail == std::vector<uint64_t>{ 4 * 2 + 1, 2 * 2 });
+            }
+        }
+        AND_WHEN("Running it from within a second")
+        {
+            FireEvents events;
+            s.run(from + 500ms, from + 1h, events);
+
+            THEN("Schedules before that point in time are left out")
+            {
+                REQUIRE(at(events.times.front()) == from + 15min);
+            }
+        }
+    }
+    AND_GIVEN("A simulation with a schedule in a time zone")
+    {
+        Simulation s;
+        s.add("Berlin", CronSchedule{ CronData::create("0 30 12 * * ?") },
+              TimeZone::from_posix("Berlin", "CET-1CEST,M3.5.0,M10.5.0/3"), 10s);
+
+        WHEN("Running it over the start of daylight saving time")
+        {
+            FireEvents events;
+            s.run(sys_days{ 2024_y / 3 / 30 }, sys_days{ 2024_y / 4 / 1 }, events);
+
+            THEN("The schedules are in local time, with the offset")
+            {
+                REQUIRE(events.times.size() == 2);
+                REQUIRE(at(events.times[0]) == sys_days{ 2024_y / 3 / 30 } + 11h + 30min + 10s);
+                REQUIRE(at(events.times[1]) == sys_days{ 2024_y / 3 / 31 } + 10h + 30min + 10s);
+            }
+        }
+    }
+}
+
+SCENARIO("Simulating the tasks of a Cron instance")
+{
+    GIVEN("A Cron instance with randomized schedules and jitter")
+    {
+        Cron<FixedUTCClock> c;
+        const system_clock::time_point start = sys_days{ 2024_y / 2 / 28 } + 23h;
+        c.get_clock().set(start);
+
+        std::vector<std::tuple<system_clock::time_point, std::string>> ticked;
+        const std::vector<std::string> expressions{ "R(0-59) R(0-59) * * * ?", "0 R(0-59) R(0-23) * * ?",
+                                                    "0 0/15 * * * ?", "0 0 12 29 2 ?" };
+
+        for (int i = 0; i < 40; ++i)
+        {
+            auto name = "Task " + std::to_string(i);
+            auto data = CronRandomization::create(expressions[i % expressions.size()], 1, name);
+            REQUIRE(c.add_schedule(name, std::make_shared<const CronData>(data),
+                                   [&ticked, &c](auto& info)
+                                   {
+                                       ticked.emplace_back(c.get_clock().now(), info.get_name());
+                                   }));
+        }
+
+        c.set_jitter(10min);
+        REQUIRE(c.pause_schedule("Task 5"));
+
+        WHEN("Simulating the tasks and ticking every second for two days")
+        {
+            Simulation s;
+            s.add_tasks(c);
+            REQUIRE(s.size() == 39);
+
+            FireEvents events;
+            s.run(start + 1s, start + 48h + 1s, events);
+
+            for (int i = 0; i < 48 * 3600; ++i)
+            {
+                c.get_clock().add(1s);
+                c.tick();
+            }
+
+            THEN("The simulation fires the same tasks at the same times")
+            {
+                std::vector<std::tuple<system_clock::time_point, std::string>> simulated;
+
+                for (size_t t = 0; t < events.times.size(); ++t)
+                {
+                    for (auto i = t > 0 ? events.ends[t - 1] : 0; i < events.ends[t]; ++i)
+                    {
+                        simulated.emplace_back(at(events.times[t]), s.get_name(events.schedules[i]));
+                    }
+                }
+
+                std::sort(ticked.begin(), ticked.end());
+                std::sort(simulated.begin(), simulated.end());
+                REQUIRE(ticked.size() > 1000);
+                REQUIRE(simulated == ticked);
+            }
+        }
+        AND_WHEN("Simulating with the work of the tasks")
+        {
+            ticked.clear();
+            Simulation s;
+            s.add_tasks(c, true);
+
+            FireEvents events;
+            s.run(start + 1s, start + 1h, events, true);
+
+            THEN("The work is run for each event")
+            {
+                REQUIRE(ticked.size() == events.size());
+                REQUIRE(events.size() > 0);
+            }
+        }
+    }
+}
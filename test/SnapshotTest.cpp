@@ -0,0 +1,330 @@
+#include <catch.hpp>
+#include <date/date.h>
+#include <libcron/include/libcron/Cron.h>
+#include <libcron/include/libcron/Snapshot.h>
+#include <map>
+
+using namespace libcron;
+using namespace date;
+using namespace std::chrono;
+
+namespace
+{
+    class FixedUTCClock
+            : public ICronClock
+    {
+        public:
+            system_clock::time_point now() const override
+            {
+                return current_time;
+            }
+
+            seconds utc_offset(system_clock::time_point) const override
+            {
+                return 0s;
+            }
+
+            void set(system_clock::time_point new_time)
+            {
+                current_time = new_time;
+            }
+
+            void add(system_clock::duration time)
+            {
+                current_time += time;
+            }
+
+        private:
+            system_clock::time_point current_time{};
+    };
+
+    template<typename CronType>
+    std::vector<std::tuple<std::string, Task::State, std::string>> states_of(const CronType& c)
+    {
+        std::vector<std::tuple<std::string, Task::State, std::string>> res;
+
+        c.for_each_task([&res](const Task& t)
+                        {
+                            res.emplace_back(t.get_name(), t.get_state(), t.get_time_zone() ? t.get_time_zone()->get_name() : "");
+                        });
+
+        std::sort(res.begin(), res.end(), [](const auto& a, const auto& b) { return std::get<0>(a) < std::get<0>(b); });
+        return res;
+    }
+
+    bool same_state(const Task::State& a, const Task::State& b)
+    {
+        return a.next_schedule == b.next_schedule
+               && a.last_run == b.last_run
+               && a.delay == b.delay
+               && a.missed_schedule == b.missed_schedule
+               && a.catch_up_runs == b.catch_up_runs
+               && a.valid == b.valid
+               && a.paused == b.paused
+               && a.overlap_policy == b.overlap_policy;
+    }
+
+    template<typename CronType>
+    void require_round_trip()
+    {
+        CronType c{};
+        c.get_clock().set(sys_days{ 2022_y / 3 / 1 } + 10h + 30s);
+        int runs = 0;
+
+        for (int i = 0; i < 20; ++i)
+        {
+            REQUIRE(c.add_schedule("Task-" + std::to_string(i), i % 2 == 0 ? "* * * * * ?" : "0 */5 * * * ?",
+                                   [&runs](auto&) { runs++; }));
+        }
+
+        REQUIRE(c.add_schedule("Paused", "0 0 12 * * MON", [&runs](auto&) { runs++; }));
+        REQUIRE(c.pause_schedule("Paused"));
+        REQUIRE(c.set_overlap_policy("Task-1", OverlapPolicy::Queue));
+
+        c.get_clock().add(1s);
+        REQUIRE(c.tick() == 10);
+
+        std::vector<uint8_t> snapshot;
+        c.save_snapshot(snapshot);
+
+        CronType restored{};
+        restored.get_clock().set(c.get_clock().now());
+        int restored_runs = 0;
+
+        REQUIRE(restored.restore_snapshot(snapshot.data(), snapshot.size(), [&restored_runs](std::string_view)
+        {
+            return [&restored_runs](auto&) { restored_runs++; };
+        }));
+
+        THEN("The tasks are restored as they were")
+        {
+            auto expected = states_of(c);
+            auto actual = states_of(restored);
+            REQUIRE(actual.size() == 21);
+            REQUIRE(actual.size() == expected.size());
+
+            for (size_t i = 0; i < actual.size(); ++i)
+            {
+                REQUIRE(std::get<0>(actual[i]) == std::get<0>(expected[i]));
+                REQUIRE(same_state(std::get<1>(actual[i]), std::get<1>(expected[i])));
+                REQUIRE(std::get<2>(actual[i]) == std::get<2>(expected[i]));
+            }
+
+            REQUIRE(restored.time_until_next() == c.time_until_next());
+        }
+        AND_THEN("They continue where they were")
+        {
+            c.get_clock().add(1s);
+            restored.get_clock().add(1s);
+            REQUIRE(restored.tick() == c.tick());
+            REQUIRE(restored_runs == 10);
+            REQUIRE_FALSE(restored.resume_schedule("No such task"));
+            REQUIRE(restored.resume_schedule("Paused"));
+        }
+        AND_THEN("Schedules missed meanwhile are handled as per the misfire options")
+        {
+            restored.get_clock().add(10min);
+            REQUIRE(restored.tick() == 20);
+            REQUIRE(restored.get_misfire_statistics().misfired == 20);
+            REQUIRE(restored_runs == 20);
+        }
+    }
+}
+
+SCENARIO("Saving and restoring snapshots")
+{
+    GIVEN("A vector based task queue")
+    {
+        require_round_trip<Cron<FixedUTCClock>>();
+    }
+    AND_GIVEN("A heap based task queue")
+    {
+        require_round_trip<Cron<FixedUTCClock, NullLock, HeapTaskQueue>>();
+    }
+
+    GIVEN("A snapshot of tasks sharing an expression and in a zone")
+    {
+        Cron<FixedUTCClock> c{};
+        c.get_clock().set(sys_days{ 2022_y / 3 / 1 });
+
+        REQUIRE(c.add_schedule("A", "0 0 * * * ?", [](auto&) {}));
+        REQUIRE(c.add_schedule("B", "0 0 * * * ?", [](auto&) {}));
+        REQUIRE(c.add_schedule("C", "0 30 8 * * ?", [](auto&) {}));
+        bool has_zones = c.set_time_zone("C", "Europe/Berlin");
+
+        std::vector<uint8_t> snapshot;
+        c.save_snapshot(snapshot);
+        Snapshot s{};
+        REQUIRE(s.open(snapshot.data(), snapshot.size()));
+        REQUIRE(s.size() == 3);
+
+        THEN("The restored tasks share the expression and zone")
+        {
+            std::vector<Task> tasks;
+
+            for (size_t i = 0; i < s.size(); ++i)
+            {
+                REQUIRE(s.restore(i, [](auto&) {}, tasks));
+            }
+
+            REQUIRE(tasks[0].get_name() == "A");
+            REQUIRE(tasks[0].get_schedule().get_data() == tasks[1].get_schedule().get_data());
+            REQUIRE(tasks[0].get_schedule().get_data() != tasks[2].get_schedule().get_data());
+            REQUIRE(tasks[2].get_schedule().get_data()->get_minutes().get_bits() == uint64_t{ 1 } << 30);
+
+            // Also with the tasks parsing the expression
+            REQUIRE(tasks[0].get_schedule().get_data() == CronData::create_shared("0 0 * * * ?"));
+
+            if (has_zones)
+            {
+                REQUIRE(tasks[2].get_time_zone() == TimeZone::locate("Europe/Berlin"));
+            }
+        }
+        AND_THEN("Tasks without work are left out")
+        {
+            Cron<FixedUTCClock> restored{};
+            REQUIRE(restored.restore_snapshot(snapshot.data(), snapshot.size(), [](std::string_view name)
+            {
+                return name == "B" ? Task::TaskFunction{} : Task::TaskFunction{ [](auto&) {} };
+            }));
+
+            REQUIRE(restored.count() == 2);
+            REQUIRE(restored.has_schedule("A"));
+            REQUIRE_FALSE(restored.has_schedule("B"));
+        }
+        AND_THEN("Corrupt snapshots are rejected")
+        {
+            auto work_of = [](std::string_view) { return [](auto&) {}; };
+            Cron<FixedUTCClock> restored{};
+
+            REQUIRE_FALSE(restored.restore_snapshot(snapshot.data(), snapshot.size() - 8, work_of));
+            REQUIRE_FALSE(restored.restore_snapshot(snapshot.data(), 16, work_of));
+
+            auto wrong_magic = snapshot;
+            wrong_magic[0] = 'X';
+            REQUIRE_FALSE(restored.restore_snapshot(wrong_magic.data(), wrong_magic.size(), work_of));
+
+            // A count of tasks far beyond the data
+            auto wrong_count = snapshot;
+            wrong_count[23] = 0x80;
+            REQUIRE_FALSE(restored.restore_snapshot(wrong_count.data(), wrong_count.size(), work_of));
+
+            // The second of the first expression at 63
+            auto wrong_expression = snapshot;
+            wrong_expression[32 + 7] = 0x80;
+            REQUIRE_FALSE(restored.restore_snapshot(wrong_expression.data(), wrong_expression.size(), work_of));
+
+            REQUIRE(restored.count() == 0);
+            REQUIRE(restored.restore_snapshot(snapshot.data(), snapshot.size(), work_of));
+            REQUIRE(restored.count() == 3);
+        }
+    }
+
+    GIVEN("A snapshot of tasks with equal expressions that aren't shared")
+    {
+        Cron<FixedUTCClock> c{};
+        c.get_clock().set(sys_days{ 2022_y / 3 / 1 });
+
+        REQUIRE(c.add_schedule("A", std::make_shared<const CronData>("0 15 * * * ?"), [](auto&) {}));
+        REQUIRE(c.add_schedule("B", std::make_shared<const CronData>("0 15 * * * ?"), [](auto&) {}));
+
+        std::vector<uint8_t> snapshot;
+        c.save_snapshot(snapshot);
+        Snapshot s{};
+        REQUIRE(s.open(snapshot.data(), snapshot.size()));
+
+        THEN("The restored tasks share one")
+        {
+            std::vector<Task> tasks;
+            REQUIRE(s.restore(0, [](auto&) {}, tasks));
+            REQUIRE(s.restore(1, [](auto&) {}, tasks));
+            REQUIRE(tasks[0].get_schedule().get_data() == tasks[1].get_schedule().get_data());
+        }
+    }
+
+    GIVEN("A snapshot made with jitter")
+    {
+        using CronType = Cron<FixedUTCClock>;
+        CronType c{};
+        c.get_clock().set(sys_days{ 2022_y / 3 / 1 });
+        c.set_jitter(60s);
+
+        for (int i = 0; i < 10; ++i)
+        {
+            REQUIRE(c.add_schedule("Task " + std::to_string(i), "0 0 * * * ?", [](auto&) {}));
+        }
+
+        std::vector<uint8_t> snapshot;
+        c.save_snapshot(snapshot);
+
+        auto next_schedules_of = [](const CronType& cron)
+        {
+            std::map<std::string, system_clock::time_point> res;
+            cron.for_each_task([&res](const Task& t) { res[std::string{ t.get_name() }] = t.get_next_schedule(); });
+            return res;
+        };
+
+        auto restore_with_jitter = [&snapshot](CronType& restored, seconds window)
+        {
+            restored.get_clock().set(sys_days{ 2022_y / 3 / 1 } + 10min);
+            restored.set_jitter(window);
+            REQUIRE(restored.restore_snapshot(snapshot.data(), snapshot.size(), [](std::string_view)
+            {
+                return [](auto&) {};
+            }));
+        };
+
+        WHEN("Restoring with the same jitter")
+        {
+            CronType restored{};
+            restore_with_jitter(restored, 60s);
+
+            THEN("The next schedules are as they were")
+            {
+                REQUIRE(next_schedules_of(restored) == next_schedules_of(c));
+            }
+        }
+        AND_WHEN("Restoring with another or no jitter")
+        {
+            CronType restored{};
+            CronType unjittered{};
+            restore_with_jitter(restored, 20s);
+            restore_with_jitter(unjittered, 0s);
+
+            THEN("The next schedules are moved to the offsets of that jitter")
+            {
+                // The schedule at the time of the snapshot, run after its offset
+                system_clock::time_point first = sys_days{ 2022_y / 3 / 1 };
+
+                for (const auto& [name, next] : next_schedules_of(restored))
+                {
+                    REQUIRE(next == first + CronType::jitter_of(name, 20s));
+                }
+
+                for (const auto& [name, next] : next_schedules_of(unjittered))
+                {
+                    REQUIRE(next == first);
+                }
+
+                REQUIRE(next_schedules_of(restored) != next_schedules_of(c));
+            }
+            AND_THEN("Schedules missed meanwhile stay missed")
+            {
+                unjittered.get_clock().add(3h);
+                REQUIRE(unjittered.tick() == 10);
+                REQUIRE(unjittered.get_misfire_statistics().misfired == 10);
+            }
+        }
+    }
+
+    GIVEN("An empty Cron instance")
+    {
+        Cron<FixedUTCClock> c{};
+        std::vector<uint8_t> snapshot;
+        c.save_snapshot(snapshot);
+
+        REQUIRE(snapshot.size() == 32);
+        REQUIRE(c.restore_snapshot(snapshot.data(), snapshot.size(), [](std::string_view) { return Task::TaskFunction{}; }));
+        REQUIRE(c.count() == 0);
+    }
+}
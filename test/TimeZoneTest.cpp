@@ -0,0 +1,280 @@
+#include <catch.hpp>
+#include <date/date.h>
+#include <libcron/include/libcron/Cron.h>
+#include <libcron/include/libcron/TimeZone.h>
+#include <random>
+
+using namespace libcron;
+using namespace date;
+using namespace std::chrono;
+
+namespace
+{
+    system_clock::time_point at_utc(year_month_day ymd, hours h = hours{ 0 }, minutes m = minutes{ 0 }, seconds s = seconds{ 0 })
+    {
+        return sys_days{ ymd } + h + m + s;
+    }
+
+    class FixedUTCClock
+            : public ICronClock
+    {
+        public:
+            system_clock::time_point now() const override
+            {
+                return current_time;
+            }
+
+            seconds utc_offset(system_clock::time_point) const override
+            {
+                return 0s;
+            }
+
+            void set(system_clock::time_point new_time)
+            {
+                current_time = new_time;
+            }
+
+        private:
+            system_clock::time_point current_time{};
+    };
+}
+
+SCENARIO("Time zones following a POSIX TZ rule")
+{
+    GIVEN("Central European time")
+    {
+        auto zone = TimeZone::from_posix("Berlin", "CET-1CEST,M3.5.0,M10.5.0/3");
+        REQUIRE(zone != nullptr);
+
+        THEN("The offset changes on the last Sundays of March and October")
+        {
+            REQUIRE(zone->utc_offset(at_utc(2022_y / 1 / 15)) == 1h);
+            REQUIRE(zone->utc_offset(at_utc(2022_y / 3 / 27, 0h, 59min, 59s)) == 1h);
+            REQUIRE(zone->utc_offset(at_utc(2022_y / 3 / 27, 1h)) == 2h);
+            REQUIRE(zone->utc_offset(at_utc(2022_y / 10 / 30, 0h, 59min, 59s)) == 2h);
+            REQUIRE(zone->utc_offset(at_utc(2022_y / 10 / 30, 1h)) == 1h);
+
+            auto period = zone->get_period(at_utc(2022_y / 7 / 1));
+            REQUIRE(period.begin == at_utc(2022_y / 3 / 27, 1h));
+            REQUIRE(period.end == at_utc(2022_y / 10 / 30, 1h));
+            REQUIRE(period.offset == 2h);
+        }
+        AND_THEN("Beyond the stored periods, the rule still applies")
+        {
+            REQUIRE(zone->utc_offset(at_utc(2150_y / 1 / 15)) == 1h);
+            REQUIRE(zone->utc_offset(at_utc(2150_y / 7 / 15)) == 2h);
+
+            // The last Sunday of March 2150 is the 29th
+            auto period = zone->get_period(at_utc(2150_y / 7 / 15));
+            REQUIRE(period.begin == at_utc(2150_y / 3 / 29, 1h));
+        }
+        AND_THEN("Skipped local times become the moment of the transition")
+        {
+            REQUIRE(zone->to_utc(at_utc(2022_y / 3 / 27, 2h, 30min)) == at_utc(2022_y / 3 / 27, 1h));
+            REQUIRE(zone->to_utc(at_utc(2022_y / 3 / 27, 3h)) == at_utc(2022_y / 3 / 27, 1h));
+            REQUIRE(zone->to_utc(at_utc(2022_y / 3 / 27, 3h, 0min, 1s)) == at_utc(2022_y / 3 / 27, 1h, 0min, 1s));
+        }
+        AND_THEN("Local times that occur twice become the first occurrence")
+        {
+            REQUIRE(zone->to_utc(at_utc(2022_y / 10 / 30, 2h, 30min)) == at_utc(2022_y / 10 / 30, 0h, 30min));
+            REQUIRE(zone->to_utc(at_utc(2022_y / 10 / 30, 3h)) == at_utc(2022_y / 10 / 30, 2h));
+        }
+        AND_THEN("Converting back and forth outside of transitions gives the same time")
+        {
+            std::mt19937 rng{ 20221030 };
+            std::uniform_int_distribution<int64_t> time(631152000, 4102444800);
+
+            for (int i = 0; i < 1000; ++i)
+            {
+                auto utc = system_clock::time_point{ seconds{ time(rng) } };
+                REQUIRE(zone->to_utc(zone->to_local(utc)) <= utc);
+                REQUIRE(zone->to_local(zone->to_utc(zone->to_local(utc))) == zone->to_local(utc));
+            }
+        }
+    }
+
+    GIVEN("A zone on the southern hemisphere")
+    {
+        auto zone = TimeZone::from_posix("Sydney", "AEST-10AEDT,M10.1.0,M4.1.0/3");
+        REQUIRE(zone != nullptr);
+        REQUIRE(zone->utc_offset(at_utc(2022_y / 1 / 15)) == 11h);
+        REQUIRE(zone->utc_offset(at_utc(2022_y / 7 / 15)) == 10h);
+    }
+
+    GIVEN("Rules with names in angle brackets, Julian days and no daylight saving time")
+    {
+        REQUIRE(TimeZone::from_posix("Fixed", "<+0530>-5:30")->utc_offset(at_utc(2022_y / 1 / 1)) == 5h + 30min);
+        REQUIRE(TimeZone::from_posix("Julian", "STD5DST,J60,J300")->utc_offset(at_utc(2024_y / 3 / 1, 12h)) == -4h);
+        REQUIRE(TimeZone::utc()->utc_offset(at_utc(2022_y / 1 / 1)) == 0s);
+    }
+
+    GIVEN("Invalid rules")
+    {
+        REQUIRE(TimeZone::from_posix("Invalid", "") == nullptr);
+        REQUIRE(TimeZone::from_posix("Invalid", "CET") == nullptr);
+        REQUIRE(TimeZone::from_posix("Invalid", "CET-1CEST,M13.5.0,M10.5.0/3") == nullptr);
+        REQUIRE(TimeZone::from_posix("Invalid", "CET-1CEST,M3.5.0") == nullptr);
+    }
+}
+
+SCENARIO("Time zones from the zone info directory")
+{
+    auto berlin = TimeZone::locate("Europe/Berlin");
+
+    if (berlin == nullptr)
+    {
+        WARN("No zone info available, skipping");
+    }
+    else
+    {
+        THEN("Zones are shared")
+        {
+            REQUIRE(TimeZone::locate("Europe/Berlin") == berlin);
+            REQUIRE(berlin->get_name() == "Europe/Berlin");
+        }
+        AND_THEN("The zone has the same offsets as its current rule")
+        {
+            auto rule = TimeZone::from_posix("Berlin", "CET-1CEST,M3.5.0,M10.5.0/3");
+            std::mt19937 rng{ 20221030 };
+            // 1996, when the current rules took effect, to 2100
+            std::uniform_int_distribution<int64_t> time(820454400, 4102444800);
+
+            for (int i = 0; i < 10000; ++i)
+            {
+                auto utc = system_clock::time_point{ seconds{ time(rng) } };
+                REQUIRE(berlin->utc_offset(utc) == rule->utc_offset(utc));
+            }
+        }
+        AND_THEN("Historical offsets are known")
+        {
+            // No daylight saving time in 1970
+            REQUIRE(berlin->utc_offset(at_utc(1970_y / 7 / 1)) == 1h);
+            // Double summer time in 1947
+            REQUIRE(berlin->utc_offset(at_utc(1947_y / 6 / 1)) == 3h);
+        }
+    }
+
+    REQUIRE(TimeZone::locate("No/Such_Zone") == nullptr);
+    REQUIRE(TimeZone::locate("../etc/passwd") == nullptr);
+
+    // Without a zone info directory, e.g. on Windows, only UTC is found.
+    TimeZone::set_zoneinfo_directory("/nonexistent/zoneinfo");
+    REQUIRE(TimeZone::locate("Pacific/Chatham") == nullptr);
+    REQUIRE(TimeZone::locate("UTC") != nullptr);
+
+    ZonedClock clock{};
+    REQUIRE_FALSE(clock.set_time_zone("Pacific/Chatham"));
+    REQUIRE(clock.get_time_zone() == TimeZone::utc());
+
+    // Back to $TZDIR or the default.
+    TimeZone::set_zoneinfo_directory("");
+}
+
+SCENARIO("Calculating schedules in a time zone")
+{
+    auto zone = TimeZone::from_posix("Berlin", "CET-1CEST,M3.5.0,M10.5.0/3");
+
+    GIVEN("A schedule at 02:30 every day")
+    {
+        CronSchedule schedule{ CronData::create("0 30 2 * * ?") };
+
+        auto next = [&schedule, &zone](system_clock::time_point from)
+        {
+            auto res = schedule.calculate_from(from, *zone);
+            REQUIRE(std::get<0>(res));
+            return std::get<1>(res);
+        };
+
+        THEN("It is in local time")
+        {
+            REQUIRE(next(at_utc(2022_y / 1 / 15)) == at_utc(2022_y / 1 / 15, 1h, 30min));
+            REQUIRE(next(at_utc(2022_y / 7 / 15)) == at_utc(2022_y / 7 / 15, 0h, 30min));
+        }
+        AND_THEN("When the time is skipped, it is at the end of the skipped hour")
+        {
+            auto skipped = next(at_utc(2022_y / 3 / 26, 12h));
+            REQUIRE(skipped == at_utc(2022_y / 3 / 27, 1h));
+            REQUIRE(next(skipped + 1s) == at_utc(2022_y / 3 / 28, 0h, 30min));
+        }
+        AND_THEN("When the time occurs twice, it is only the first time")
+        {
+            auto first = next(at_utc(2022_y / 10 / 29, 12h));
+            REQUIRE(first == at_utc(2022_y / 10 / 30, 0h, 30min));
+            REQUIRE(next(first + 1s) == at_utc(2022_y / 10 / 31, 1h, 30min));
+
+            // From within the second pass through the repeated hour
+            REQUIRE(next(at_utc(2022_y / 10 / 30, 1h, 15min)) == at_utc(2022_y / 10 / 31, 1h, 30min));
+        }
+    }
+
+    GIVEN("A Cron instance with a task in a zone")
+    {
+        Cron<FixedUTCClock> c{};
+        int runs = 0;
+
+        REQUIRE(c.add_schedule("Task", "0 0 9 * * ?", [&runs](auto&) { ++runs; }));
+
+        if (TimeZone::locate("America/New_York") == nullptr)
+        {
+            WARN("No zone info available, skipping");
+        }
+        else
+        {
+            c.get_clock().set(at_utc(2022_y / 7 / 1));
+            REQUIRE(c.set_time_zone("Task", "America/New_York"));
+            REQUIRE_FALSE(c.set_time_zone("Task", "No/Such_Zone"));
+            REQUIRE_FALSE(c.set_time_zone("No such task", "America/New_York"));
+
+            THEN("It runs at the local time of the zone")
+            {
+                c.tick();
+                c.get_clock().set(at_utc(2022_y / 7 / 1, 12h, 59min, 59s));
+                c.tick();
+                REQUIRE(runs == 0);
+
+                // 09:00 EDT
+                c.get_clock().set(at_utc(2022_y / 7 / 1, 13h));
+                c.tick();
+                REQUIRE(runs == 1);
+            }
+        }
+    }
+}
+
+SCENARIO("A clock in a time zone")
+{
+    GIVEN("A clock in a zone with daylight saving time")
+    {
+        ZonedClock clock{ TimeZone::from_posix("Berlin", "CET-1CEST,M3.5.0,M10.5.0/3") };
+
+        THEN("The offset follows the zone, also when going back and forth")
+        {
+            REQUIRE(clock.utc_offset(at_utc(2022_y / 7 / 1)) == 2h);
+            REQUIRE(clock.utc_offset(at_utc(2022_y / 7 / 2)) == 2h);
+            REQUIRE(clock.utc_offset(at_utc(2022_y / 12 / 1)) == 1h);
+            REQUIRE(clock.utc_offset(at_utc(2022_y / 7 / 1)) == 2h);
+            REQUIRE(clock.utc_offset(at_utc(2150_y / 7 / 1)) == 2h);
+        }
+        AND_THEN("The time is the local time")
+        {
+            auto before = system_clock::now();
+            auto local = clock.now();
+            auto after = system_clock::now();
+
+            REQUIRE(local >= before + clock.utc_offset(before));
+            REQUIRE(local <= after + clock.utc_offset(after));
+        }
+    }
+
+    GIVEN("A default clock")
+    {
+        ZonedClock clock{};
+
+        THEN("It is in UTC")
+        {
+            REQUIRE(clock.utc_offset(at_utc(2022_y / 7 / 1)) == 0s);
+            REQUIRE(clock.get_time_zone()->get_name() == "UTC");
+            REQUIRE_FALSE(clock.set_time_zone("No/Such_Zone"));
+        }
+    }
+}